@@ -1016,6 +1016,15 @@ int opt_max_alloc(void *optctx, const char *opt, const char *arg)
     return 0;
 }
 
+int opt_mem_flags(void *optctx, const char *opt, const char *arg)
+{
+    int flag = !strcmp(opt, "hugepages") ? AV_MEM_FLAG_HUGEPAGES
+                                         : AV_MEM_FLAG_PREFAULT;
+
+    av_mem_set_flags(av_mem_get_flags() | flag);
+    return 0;
+}
+
 int opt_timelimit(void *optctx, const char *opt, const char *arg)
 {
 #if HAVE_SETRLIMIT
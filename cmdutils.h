@@ -98,6 +98,8 @@ int opt_report(const char *opt);
 
 int opt_max_alloc(void *optctx, const char *opt, const char *arg);
 
+int opt_mem_flags(void *optctx, const char *opt, const char *arg);
+
 int opt_codec_debug(void *optctx, const char *opt, const char *arg);
 
 #if CONFIG_OPENCL
@@ -21,6 +21,8 @@
     { "v",           HAS_ARG,  {.func_arg = opt_loglevel},      "set logging level", "loglevel" },
     { "report"     , 0,        {(void*)opt_report}, "generate a report" },
     { "max_alloc"  , HAS_ARG,  {.func_arg = opt_max_alloc},     "set maximum size of a single allocated block", "bytes" },
+    { "hugepages"  , OPT_EXPERT, {.func_arg = opt_mem_flags},   "back large buffers with huge pages" },
+    { "prefault"   , OPT_EXPERT, {.func_arg = opt_mem_flags},   "fault in large buffers from the allocating thread" },
     { "cpuflags"   , HAS_ARG | OPT_EXPERT, { .func_arg = opt_cpuflags }, "force specific cpu flags", "flags" },
     { "hide_banner", OPT_BOOL | OPT_EXPERT, {&hide_banner},     "do not show program banner", "hide_banner" },
 #if CONFIG_OPENCL
@@ -3472,8 +3472,9 @@ static int init_input_threads(void)
         if (f->ctx->pb ? !f->ctx->pb->seekable :
             strcmp(f->ctx->iformat->name, "lavfi"))
             f->non_blocking = 1;
-        ret = av_thread_message_queue_alloc(&f->in_thread_queue,
-                                            f->thread_queue_size, sizeof(AVPacket));
+        ret = av_thread_message_queue_alloc2(&f->in_thread_queue,
+                                             f->thread_queue_size, sizeof(AVPacket),
+                                             AV_THREAD_MESSAGE_QUEUE_SPSC);
         if (ret < 0)
             return ret;
 
@@ -42,6 +42,7 @@
 #include "aac.h"
 #include "aactab.h"
 #include "aacenc.h"
+#include "aacenc_utils.h"
 
 #include "psymodel.h"
 
@@ -812,6 +813,12 @@ static av_cold int aac_encode_init(AVCodecContext *avctx)
     s->psypp = ff_psy_preprocess_init(avctx);
     s->coder = &ff_aac_coders[s->options.aac_coder];
 
+    s->abs_pow34   = abs_pow34_v;
+    s->quant_bands = quantize_bands;
+
+    if (ARCH_X86)
+        ff_aac_dsp_init_x86(s);
+
     if (HAVE_MIPSDSPR1)
         ff_aac_coder_init_mips(s);
 
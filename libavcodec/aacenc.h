@@ -86,6 +86,19 @@ typedef struct AACEncContext {
     DECLARE_ALIGNED(16, int,   qcoefs)[96];      ///< quantized coefficients
     DECLARE_ALIGNED(32, float, scoefs)[1024];    ///< scaled coefficients
 
+    /**
+     * Compute |in[i]|^0.75 for each of the size coefficients.
+     */
+    void (*abs_pow34)(float *out, const float *in, const int size);
+
+    /**
+     * Quantize the coefficients scaled by abs_pow34() with the quantizer
+     * Q34, clipping the magnitudes to maxval.
+     * @param is_signed if set, the sign of in is applied to the output
+     */
+    void (*quant_bands)(int *out, const float *in, const float *scaled,
+                        int size, float Q34, int is_signed, int maxval);
+
     struct {
         float *samples;
     } buffer;
@@ -94,5 +107,6 @@ typedef struct AACEncContext {
 extern float ff_aac_pow34sf_tab[428];
 
 void ff_aac_coder_init_mips(AACEncContext *c);
+void ff_aac_dsp_init_x86(AACEncContext *s);
 
 #endif /* AVCODEC_AACENC_H */
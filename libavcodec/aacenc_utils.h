@@ -0,0 +1,57 @@
+/*
+ * AAC encoder utilities
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * AAC encoder utilities
+ */
+
+#ifndef AVCODEC_AACENC_UTILS_H
+#define AVCODEC_AACENC_UTILS_H
+
+#include <math.h>
+#include "libavutil/common.h"
+
+static inline void abs_pow34_v(float *out, const float *in, const int size)
+{
+#ifndef USE_REALLY_FULL_SEARCH
+    int i;
+    for (i = 0; i < size; i++) {
+        float a = fabsf(in[i]);
+        out[i] = sqrtf(a * sqrtf(a));
+    }
+#endif /* USE_REALLY_FULL_SEARCH */
+}
+
+static inline void quantize_bands(int *out, const float *in, const float *scaled,
+                                  int size, float Q34, int is_signed, int maxval)
+{
+    int i;
+    double qc;
+    for (i = 0; i < size; i++) {
+        qc = scaled[i] * Q34;
+        out[i] = (int)FFMIN(qc + 0.4054, (double)maxval);
+        if (is_signed && in[i] < 0.0f) {
+            out[i] = -out[i];
+        }
+    }
+}
+
+#endif /* AVCODEC_AACENC_UTILS_H */
@@ -75,12 +75,12 @@ av_cold int AC3_NAME(mdct_init)(AC3EncodeContext *s)
  * Normalize the input samples to use the maximum available precision.
  * This assumes signed 16-bit input samples.
  */
-static int normalize_samples(AC3EncodeContext *s)
+static int normalize_samples(AC3EncodeContext *s, int16_t *windowed_samples)
 {
-    int v = s->ac3dsp.ac3_max_msb_abs_int16(s->windowed_samples, AC3_WINDOW_SIZE);
+    int v = s->ac3dsp.ac3_max_msb_abs_int16(windowed_samples, AC3_WINDOW_SIZE);
     v = 14 - av_log2(v);
     if (v > 0)
-        s->ac3dsp.ac3_lshift_int16(s->windowed_samples, AC3_WINDOW_SIZE, v);
+        s->ac3dsp.ac3_lshift_int16(windowed_samples, AC3_WINDOW_SIZE, v);
     /* +6 to right-shift from 31-bit to 25-bit */
     return v + 6;
 }
@@ -152,6 +152,7 @@ AVCodec ff_ac3_fixed_encoder = {
     .init            = ac3_fixed_encode_init,
     .encode2         = ff_ac3_fixed_encode_frame,
     .close           = ff_ac3_encode_close,
+    .capabilities    = CODEC_CAP_SLICE_THREADS,
     .sample_fmts     = (const enum AVSampleFormat[]){ AV_SAMPLE_FMT_S16P,
                                                       AV_SAMPLE_FMT_NONE },
     .priv_class      = &ac3enc_class,
@@ -90,7 +90,7 @@ av_cold int ff_ac3_float_mdct_init(AC3EncodeContext *s)
  * Normalize the input samples.
  * Not needed for the floating-point encoder.
  */
-static int normalize_samples(AC3EncodeContext *s)
+static int normalize_samples(AC3EncodeContext *s, float *windowed_samples)
 {
     return 0;
 }
@@ -154,6 +154,7 @@ AVCodec ff_ac3_encoder = {
     .init            = ff_ac3_float_encode_init,
     .encode2         = ff_ac3_float_encode_frame,
     .close           = ff_ac3_encode_close,
+    .capabilities    = CODEC_CAP_SLICE_THREADS,
     .sample_fmts     = (const enum AVSampleFormat[]){ AV_SAMPLE_FMT_FLTP,
                                                       AV_SAMPLE_FMT_NONE },
     .priv_class      = &ac3enc_class,
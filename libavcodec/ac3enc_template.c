@@ -40,7 +40,7 @@
 
 static void scale_coefficients(AC3EncodeContext *s);
 
-static int normalize_samples(AC3EncodeContext *s);
+static int normalize_samples(AC3EncodeContext *s, SampleType *windowed_samples);
 
 static void clip_coefficients(AudioDSPContext *adsp, CoefType *coef,
                               unsigned int len);
@@ -55,8 +55,8 @@ int AC3_NAME(allocate_sample_buffers)(AC3EncodeContext *s)
 {
     int ch;
 
-    FF_ALLOC_OR_GOTO(s->avctx, s->windowed_samples, AC3_WINDOW_SIZE *
-                     sizeof(*s->windowed_samples), alloc_fail);
+    FF_ALLOC_OR_GOTO(s->avctx, s->windowed_samples, s->channels *
+                     AC3_WINDOW_SIZE * sizeof(*s->windowed_samples), alloc_fail);
     FF_ALLOC_ARRAY_OR_GOTO(s->avctx, s->planar_samples, s->channels, sizeof(*s->planar_samples),
                      alloc_fail);
     for (ch = 0; ch < s->channels; ch++) {
@@ -94,34 +94,55 @@ static void copy_input_samples(AC3EncodeContext *s, SampleType **samples)
 
 
 /*
- * Apply the MDCT to input samples to generate frequency coefficients.
- * This applies the KBD window and normalizes the input to reduce precision
- * loss due to fixed-point calculations.
+ * Apply the MDCT to the input samples of one channel to generate frequency
+ * coefficients. This applies the KBD window and normalizes the input to
+ * reduce precision loss due to fixed-point calculations.
  */
-static void apply_mdct(AC3EncodeContext *s)
+static int apply_mdct_ch(AVCodecContext *avctx, void *arg, int ch, int threadnr)
 {
-    int blk, ch;
+    AC3EncodeContext *s = avctx->priv_data;
+    SampleType *windowed_samples = s->windowed_samples + ch * AC3_WINDOW_SIZE;
+    int blk;
 
-    for (ch = 0; ch < s->channels; ch++) {
-        for (blk = 0; blk < s->num_blocks; blk++) {
-            AC3Block *block = &s->blocks[blk];
-            const SampleType *input_samples = &s->planar_samples[ch][blk * AC3_BLOCK_SIZE];
+    for (blk = 0; blk < s->num_blocks; blk++) {
+        AC3Block *block = &s->blocks[blk];
+        const SampleType *input_samples = &s->planar_samples[ch][blk * AC3_BLOCK_SIZE];
 
 #if CONFIG_AC3ENC_FLOAT
-            s->fdsp->vector_fmul(s->windowed_samples, input_samples,
-                                s->mdct_window, AC3_WINDOW_SIZE);
+        s->fdsp->vector_fmul(windowed_samples, input_samples,
+                             s->mdct_window, AC3_WINDOW_SIZE);
 #else
-            s->ac3dsp.apply_window_int16(s->windowed_samples, input_samples,
-                                         s->mdct_window, AC3_WINDOW_SIZE);
+        s->ac3dsp.apply_window_int16(windowed_samples, input_samples,
+                                     s->mdct_window, AC3_WINDOW_SIZE);
 #endif
 
-            if (s->fixed_point)
-                block->coeff_shift[ch+1] = normalize_samples(s);
+        if (s->fixed_point)
+            block->coeff_shift[ch+1] = normalize_samples(s, windowed_samples);
 
-            s->mdct.mdct_calcw(&s->mdct, block->mdct_coef[ch+1],
-                               s->windowed_samples);
-        }
+        s->mdct.mdct_calcw(&s->mdct, block->mdct_coef[ch+1],
+                           windowed_samples);
     }
+    emms_c();
+
+    return 0;
+}
+
+
+/*
+ * Apply the MDCT to all channels, in parallel when slice threading is
+ * enabled. The fixed-point MDCT uses the scratch buffer of the shared FFT
+ * context, so the channels are transformed one after the other.
+ */
+static void apply_mdct(AC3EncodeContext *s)
+{
+#if CONFIG_AC3ENC_FLOAT
+    s->avctx->execute2(s->avctx, apply_mdct_ch, NULL, NULL, s->channels);
+#else
+    int ch;
+
+    for (ch = 0; ch < s->channels; ch++)
+        apply_mdct_ch(s->avctx, NULL, ch, 0);
+#endif
 }
 
 
@@ -40,7 +40,6 @@
 // The largest value that will not lead to overflow for 10bit samples.
 #define DNX10BIT_QMAT_SHIFT 18
 #define RC_VARIANCE 1 // use variance or ssd for fast rc
-#define LAMBDA_FRAC_BITS 10
 
 #define VE AV_OPT_FLAG_VIDEO_PARAM | AV_OPT_FLAG_ENCODING_PARAM
 static const AVOption options[] = {
@@ -128,6 +127,28 @@ static int dnxhd_10bit_dct_quantize(MpegEncContext *ctx, int16_t *block,
     return last_non_zero;
 }
 
+static void dnxhd_select_qscale_c(uint8_t *qscale, uint16_t *bits,
+                                  RCEntry (*mb_rc)[8160], int mb, int count,
+                                  int qmax, unsigned lambda)
+{
+    int i, q;
+
+    for (i = mb; i < mb + count; i++) {
+        unsigned min = UINT_MAX;
+        int best     = 1;
+        for (q = 1; q < qmax; q++) {
+            unsigned score = mb_rc[q][i].bits * lambda +
+                             ((unsigned) mb_rc[q][i].ssd << LAMBDA_FRAC_BITS);
+            if (score < min) {
+                min  = score;
+                best = q;
+            }
+        }
+        qscale[i] = best;
+        bits[i]   = mb_rc[best][i].bits;
+    }
+}
+
 static av_cold int dnxhd_init_vlc(DNXHDEncContext *ctx)
 {
     int i, j, level, run;
@@ -341,6 +362,7 @@ static av_cold int dnxhd_encode_init(AVCodecContext *avctx)
         ctx->get_pixels_8x4_sym = dnxhd_8bit_get_pixels_8x4_sym;
         ctx->block_width_l2     = 3;
     }
+    ctx->select_qscale = dnxhd_select_qscale_c;
 
     if (ARCH_X86)
         ff_dnxhdenc_init_x86(ctx);
@@ -786,11 +808,28 @@ static int dnxhd_mb_var_thread(AVCodecContext *avctx, void *arg,
     return 0;
 }
 
+static int dnxhd_select_qscale_thread(AVCodecContext *avctx, void *arg,
+                                      int jobnr, int threadnr)
+{
+    DNXHDEncContext *ctx = avctx->priv_data;
+    unsigned lambda      = *(unsigned *)arg;
+    int mb               = jobnr * ctx->m.mb_width;
+    int count            = ctx->m.mb_width & ~7;
+
+    ctx->select_qscale(ctx->mb_qscale, ctx->mb_bits, ctx->mb_rc,
+                       mb, count, avctx->qmax, lambda);
+    dnxhd_select_qscale_c(ctx->mb_qscale, ctx->mb_bits, ctx->mb_rc,
+                          mb + count, ctx->m.mb_width - count,
+                          avctx->qmax, lambda);
+    return 0;
+}
+
 static int dnxhd_encode_rdo(AVCodecContext *avctx, DNXHDEncContext *ctx)
 {
     int lambda, up_step, down_step;
     int last_lower = INT_MAX, last_higher = 0;
     int x, y, q;
+    unsigned rc_lambda;
 
     for (q = 1; q < avctx->qmax; q++) {
         ctx->qscale = q;
@@ -807,23 +846,13 @@ static int dnxhd_encode_rdo(AVCodecContext *avctx, DNXHDEncContext *ctx)
             lambda++;
             end = 1; // need to set final qscales/bits
         }
+        // all rows are updated, a pass that overflows is never the final one
+        rc_lambda = lambda;
+        avctx->execute2(avctx, dnxhd_select_qscale_thread,
+                        &rc_lambda, NULL, ctx->m.mb_height);
         for (y = 0; y < ctx->m.mb_height; y++) {
-            for (x = 0; x < ctx->m.mb_width; x++) {
-                unsigned min = UINT_MAX;
-                int qscale = 1;
-                int mb     = y * ctx->m.mb_width + x;
-                for (q = 1; q < avctx->qmax; q++) {
-                    unsigned score = ctx->mb_rc[q][mb].bits * lambda +
-                                     ((unsigned) ctx->mb_rc[q][mb].ssd << LAMBDA_FRAC_BITS);
-                    if (score < min) {
-                        min    = score;
-                        qscale = q;
-                    }
-                }
-                bits += ctx->mb_rc[qscale][mb].bits;
-                ctx->mb_qscale[mb] = qscale;
-                ctx->mb_bits[mb]   = ctx->mb_rc[qscale][mb].bits;
-            }
+            for (x = 0; x < ctx->m.mb_width; x++)
+                bits += ctx->mb_bits[y * ctx->m.mb_width + x];
             bits = (bits + 31) & ~31; // padding
             if (bits > ctx->frame_bits)
                 break;
@@ -1149,7 +1178,8 @@ AVCodec ff_dnxhd_encoder = {
     .init           = dnxhd_encode_init,
     .encode2        = dnxhd_encode_picture,
     .close          = dnxhd_encode_end,
-    .capabilities   = CODEC_CAP_SLICE_THREADS,
+    .capabilities   = CODEC_CAP_SLICE_THREADS | CODEC_CAP_FRAME_THREADS |
+                      CODEC_CAP_INTRA_ONLY,
     .pix_fmts       = (const enum AVPixelFormat[]) {
         AV_PIX_FMT_YUV422P,
         AV_PIX_FMT_YUV422P10,
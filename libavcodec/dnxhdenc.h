@@ -29,6 +29,8 @@
 #include "mpegvideo.h"
 #include "dnxhddata.h"
 
+#define LAMBDA_FRAC_BITS 10
+
 typedef struct RCCMPEntry {
     uint16_t mb;
     int value;
@@ -92,6 +94,16 @@ typedef struct DNXHDEncContext {
 
     void (*get_pixels_8x4_sym)(int16_t * /* align 16 */,
                                const uint8_t *, ptrdiff_t);
+
+    /**
+     * For count macroblocks starting at mb, select the qscale in
+     * [1, qmax) minimizing bits * lambda + (ssd << LAMBDA_FRAC_BITS),
+     * computed modulo 2^32, and store it with its bit cost.
+     * count must be a multiple of 8.
+     */
+    void (*select_qscale)(uint8_t *qscale, uint16_t *bits,
+                          RCEntry (*mb_rc)[8160], int mb, int count,
+                          int qmax, unsigned lambda);
 } DNXHDEncContext;
 
 void ff_dnxhdenc_init_x86(DNXHDEncContext *ctx);
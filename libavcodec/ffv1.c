@@ -57,6 +57,8 @@ av_cold int ffv1_common_init(AVCodecContext *avctx)
     s->width  = avctx->width;
     s->height = avctx->height;
 
+    ff_ffv1dsp_init(&s->dsp);
+
     // defaults
     s->num_h_slices = 1;
     s->num_v_slices = 1;
@@ -137,9 +139,17 @@ av_cold int ffv1_init_slice_contexts(FFV1Context *f)
         fs->slice_x      = sxs;
         fs->slice_y      = sys;
 
-        fs->sample_buffer = av_malloc_array((fs->width + 6), 3 * MAX_PLANES *
-                                      sizeof(*fs->sample_buffer));
-        if (!fs->sample_buffer) {
+        /* the line functions may overread the last line by up to 8 samples */
+        fs->sample_buffer = av_mallocz_array((fs->width + 6) * 3 * MAX_PLANES + 8,
+                                             sizeof(*fs->sample_buffer));
+        fs->context_buffer  = av_malloc_array(FFALIGN(fs->width, 8),
+                                              sizeof(*fs->context_buffer));
+        fs->residual_buffer = av_malloc_array(FFALIGN(fs->width, 8),
+                                              sizeof(*fs->residual_buffer));
+        if (!fs->sample_buffer || !fs->context_buffer || !fs->residual_buffer) {
+            av_freep(&fs->sample_buffer);
+            av_freep(&fs->context_buffer);
+            av_freep(&fs->residual_buffer);
             av_freep(&f->slice_context[i]);
             goto memfail;
         }
@@ -149,6 +159,8 @@ av_cold int ffv1_init_slice_contexts(FFV1Context *f)
 memfail:
     while(--i >= 0) {
         av_freep(&f->slice_context[i]->sample_buffer);
+        av_freep(&f->slice_context[i]->context_buffer);
+        av_freep(&f->slice_context[i]->residual_buffer);
         av_freep(&f->slice_context[i]);
     }
     return AVERROR(ENOMEM);
@@ -219,6 +231,8 @@ av_cold int ffv1_close(AVCodecContext *avctx)
             av_freep(&p->vlc_state);
         }
         av_freep(&fs->sample_buffer);
+        av_freep(&fs->context_buffer);
+        av_freep(&fs->residual_buffer);
     }
 
     av_freep(&avctx->stats_out);
@@ -100,6 +100,7 @@ static av_always_inline void decode_line(FFV1Context *s, int w,
 {
     PlaneContext *const p = &s->plane[plane_index];
     RangeCoder *const c   = &s->c;
+    const int large       = !!p->quant_table[3][127];
     int x;
     int run_count = 0;
     int run_mode  = 0;
@@ -118,10 +119,18 @@ static av_always_inline void decode_line(FFV1Context *s, int w,
         return;
     }
 
+    /* sample[1] still holds the line above the previous one here */
+    s->dsp.context_top(s->context_buffer, sample[0], sample[1],
+                       p->quant_table, large, w);
+
     for (x = 0; x < w; x++) {
+        const int L = sample[1][x - 1];
         int diff, context, sign;
 
-        context = get_context(p, sample[1] + x, sample[0] + x, sample[1] + x);
+        context = s->context_buffer[x] +
+                  p->quant_table[0][(L - sample[0][x - 1]) & 0xFF];
+        if (large)
+            context += p->quant_table[3][(sample[1][x - 2] - L) & 0xFF];
         if (context < 0) {
             context = -context;
             sign    = 1;
@@ -1009,6 +1018,8 @@ static int init_thread_copy(AVCodecContext *avctx)
     f->picture.f      = NULL;
     f->last_picture.f = NULL;
     f->sample_buffer  = NULL;
+    f->context_buffer = NULL;
+    f->residual_buffer = NULL;
     f->slice_count = 0;
 
     for (i = 0; i < f->quant_table_count; i++) {
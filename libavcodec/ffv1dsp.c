@@ -0,0 +1,74 @@
+/*
+ * FFV1 DSP functions
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "mathops.h"
+#include "ffv1dsp.h"
+
+static void context_top_c(int *context, const int16_t *last,
+                          const int16_t *last2,
+                          const int16_t (*quant_table)[256], int large, int w)
+{
+    int x;
+
+    for (x = 0; x < w; x++) {
+        const int LT = last[x - 1];
+        const int T  = last[x];
+        const int RT = last[x + 1];
+
+        context[x] = quant_table[1][(LT - T) & 0xFF] +
+                     quant_table[2][(T - RT) & 0xFF];
+    }
+    if (large)
+        for (x = 0; x < w; x++)
+            context[x] += quant_table[4][(last2[x] - last[x]) & 0xFF];
+}
+
+static void context_residual_c(int *context, int *residual, const int16_t *src,
+                               const int16_t *last, const int16_t *last2,
+                               const int16_t (*quant_table)[256], int large,
+                               int w)
+{
+    int x;
+
+    context_top_c(context, last, last2, quant_table, large, w);
+
+    for (x = 0; x < w; x++) {
+        const int LT = last[x - 1];
+        const int T  = last[x];
+        const int L  = src[x - 1];
+
+        context[x] += quant_table[0][(L - LT) & 0xFF];
+        residual[x] = src[x] - mid_pred(L, L + T - LT, T);
+    }
+    if (large)
+        for (x = 0; x < w; x++)
+            context[x] += quant_table[3][(src[x - 2] - src[x - 1]) & 0xFF];
+}
+
+av_cold void ff_ffv1dsp_init(FFV1DSPContext *c)
+{
+    c->context_top      = context_top_c;
+    c->context_residual = context_residual_c;
+
+    if (ARCH_X86)
+        ff_ffv1dsp_init_x86(c);
+}
@@ -0,0 +1,56 @@
+/*
+ * FFV1 DSP functions
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVCODEC_FFV1DSP_H
+#define AVCODEC_FFV1DSP_H
+
+#include <stdint.h>
+
+/**
+ * Line functions of the FFV1 context model. last and last2 are the two
+ * previous lines and src the current one, all with valid samples at
+ * index -2 to w. large selects the 5 input quant tables.
+ * The functions may process w rounded up to a multiple of 8, so the
+ * lines and outputs must have that much padding.
+ */
+typedef struct FFV1DSPContext {
+    /**
+     * Compute the part of the contexts of a line which only depends on the
+     * previous lines, the quantized LT - T, T - RT and TT - T gradients.
+     * The 2 bytes in front of quant_table must be readable.
+     */
+    void (*context_top)(int *context, const int16_t *last,
+                        const int16_t *last2,
+                        const int16_t (*quant_table)[256], int large, int w);
+
+    /**
+     * Compute the full contexts of a line and the residuals of the samples
+     * from the median predictor, as used by the encoder.
+     */
+    void (*context_residual)(int *context, int *residual, const int16_t *src,
+                             const int16_t *last, const int16_t *last2,
+                             const int16_t (*quant_table)[256], int large,
+                             int w);
+} FFV1DSPContext;
+
+void ff_ffv1dsp_init(FFV1DSPContext *c);
+void ff_ffv1dsp_init_x86(FFV1DSPContext *c);
+
+#endif /* AVCODEC_FFV1DSP_H */
@@ -298,11 +298,15 @@ static av_always_inline int encode_line(FFV1Context *s, int w,
         return 0;
     }
 
+    s->dsp.context_residual(s->context_buffer, s->residual_buffer,
+                            sample[0], sample[1], sample[2], p->quant_table,
+                            !!p->quant_table[3][127], w);
+
     for (x = 0; x < w; x++) {
         int diff, context;
 
-        context = get_context(p, sample[0] + x, sample[1] + x, sample[2] + x);
-        diff    = sample[0][x] - predict(sample[0] + x, sample[1] + x);
+        context = s->context_buffer[x];
+        diff    = s->residual_buffer[x];
 
         if (context < 0) {
             context = -context;
@@ -247,6 +247,26 @@ static inline int pix_abs8_c(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
     return s;
 }
 
+static void pix_abs16_x4_c(MpegEncContext *v, uint8_t *pix1,
+                           uint8_t *const pix2[4], ptrdiff_t stride, int h,
+                           int score[4])
+{
+    int i;
+
+    for (i = 0; i < 4; i++)
+        score[i] = pix_abs16_c(v, pix1, pix2[i], stride, h);
+}
+
+static void pix_abs8_x4_c(MpegEncContext *v, uint8_t *pix1,
+                          uint8_t *const pix2[4], ptrdiff_t stride, int h,
+                          int score[4])
+{
+    int i;
+
+    for (i = 0; i < 4; i++)
+        score[i] = pix_abs8_c(v, pix1, pix2[i], stride, h);
+}
+
 static int pix_abs8_x2_c(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
                          ptrdiff_t stride, int h)
 {
@@ -949,6 +969,9 @@ av_cold void ff_me_cmp_init(MECmpContext *c, AVCodecContext *avctx)
     c->pix_abs[1][2] = pix_abs8_y2_c;
     c->pix_abs[1][3] = pix_abs8_xy2_c;
 
+    c->sad_x4[0] = pix_abs16_x4_c;
+    c->sad_x4[1] = pix_abs8_x4_c;
+
 #define SET_CMP_FUNC(name)                      \
     c->name[0] = name ## 16_c;                  \
     c->name[1] = name ## 8x8_c;
@@ -50,6 +50,13 @@ typedef int (*me_cmp_func)(struct MpegEncContext *c,
                            uint8_t *blk2 /* align 1 */, ptrdiff_t stride,
                            int h);
 
+/* Compares one block against four candidate positions at once,
+ * score[i] is the same as the matching me_cmp_func returns for blk2[i]. */
+typedef void (*me_cmp_x4_func)(struct MpegEncContext *c,
+                               uint8_t *blk1 /* align width (8 or 16) */,
+                               uint8_t *const blk2[4] /* align 1 */,
+                               ptrdiff_t stride, int h, int score[4]);
+
 typedef struct MECmpContext {
     int (*sum_abs_dctelem)(int16_t *block /* align 16 */);
 
@@ -76,6 +83,8 @@ typedef struct MECmpContext {
     me_cmp_func frame_skip_cmp[6]; // only width 8 used
 
     me_cmp_func pix_abs[2][4];
+
+    me_cmp_x4_func sad_x4[2]; /* [0] 16x h, [1] 8x h, multi candidate sad[] */
 } MECmpContext;
 
 void ff_me_cmp_init_static(void);
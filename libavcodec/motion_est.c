@@ -271,6 +271,42 @@ static av_always_inline int cmp(MpegEncContext *s, const int x, const int y, con
     }
 }
 
+/**
+ * Compare a list of full-pel candidates against the current block.
+ * Gives the same scores as cmp() on each of them, but scores four
+ * positions per call when only the luma SAD is compared.
+ */
+static av_always_inline void cmp_fpel_batch(MpegEncContext *s, int (*mv)[3], int *d, int n,
+                      const int size, const int h, int ref_index, int src_index,
+                      me_cmp_func cmp_func, me_cmp_func chroma_cmp_func, const int flags){
+    MotionEstContext * const c= &s->me;
+    int i= 0;
+
+    if(!(flags&(FLAG_DIRECT|FLAG_CHROMA)) && size < 2 && cmp_func == s->mecc.sad[size]){
+        const int stride= c->stride;
+        uint8_t * const ref= c->ref[ref_index][0];
+        uint8_t * const src= c->src[src_index][0];
+        uint8_t *blk[4];
+        int score[4];
+
+        for(; n - i >= 2; i += 4){
+            const int left= FFMIN(n - i, 4);
+            int j;
+
+            /* short batches repeat their last candidate */
+            for(j=0; j<4; j++){
+                const int k= i + FFMIN(j, left - 1);
+                blk[j]= ref + mv[k][0] + mv[k][1]*stride;
+            }
+            s->mecc.sad_x4[size](s, src, blk, stride, h, score);
+            for(j=0; j<left; j++)
+                d[i + j]= score[j];
+        }
+    }
+    for(; i<n; i++)
+        d[i]= cmp(s, mv[i][0], mv[i][1], 0, 0, size, h, ref_index, src_index, cmp_func, chroma_cmp_func, flags);
+}
+
 static int cmp_hpel(MpegEncContext *s, const int x, const int y, const int subx, const int suby,
                       const int size, const int h, int ref_index, int src_index,
                       me_cmp_func cmp_func, me_cmp_func chroma_cmp_func, const int flags){
@@ -382,22 +382,66 @@ static int qpel_motion_search(MpegEncContext * s,
     CHECK_MV(Lx2, Ly2)\
 }
 
-#define CHECK_MV_DIR(x,y,new_dir)\
+/* Candidates are queued in the order the search visits them and scored as a
+ * batch. The map is updated while queuing, so the same candidates are scored
+ * and the same best vector is picked as with CHECK_MV. */
+#define ME_BATCH_SIZE 16
+
+#define LOAD_BATCH\
+    int batch[ME_BATCH_SIZE][3], batch_score[ME_BATCH_SIZE], batch_n= 0;\
+
+#define QUEUE_MV_DIR(x,y,new_dir)\
 {\
     const unsigned key = ((y)<<ME_MAP_MV_BITS) + (x) + map_generation;\
     const int index= (((y)<<ME_MAP_SHIFT) + (x))&(ME_MAP_SIZE-1);\
+    av_assert2((x) >= xmin);\
+    av_assert2((x) <= xmax);\
+    av_assert2((y) >= ymin);\
+    av_assert2((y) <= ymax);\
+    av_assert2(batch_n < ME_BATCH_SIZE);\
     if(map[index]!=key){\
-        d= cmp(s, x, y, 0, 0, size, h, ref_index, src_index, cmpf, chroma_cmpf, flags);\
         map[index]= key;\
-        score_map[index]= d;\
-        d += (mv_penalty[((x)<<shift)-pred_x] + mv_penalty[((y)<<shift)-pred_y])*penalty_factor;\
-        if(d<dmin){\
-            best[0]=x;\
-            best[1]=y;\
-            dmin=d;\
-            next_dir= new_dir;\
-        }\
+        batch[batch_n][0]= x;\
+        batch[batch_n][1]= y;\
+        batch[batch_n][2]= new_dir;\
+        batch_n++;\
+    }\
+}
+
+#define SCORE_MV_BATCH(update)\
+{\
+    int k;\
+    cmp_fpel_batch(s, batch, batch_score, batch_n, size, h, ref_index, src_index, cmpf, chroma_cmpf, flags);\
+    for(k=0; k<batch_n; k++){\
+        const int bx= batch[k][0];\
+        const int by= batch[k][1];\
+        const int index= ((by<<ME_MAP_SHIFT) + bx)&(ME_MAP_SIZE-1);\
+        score_map[index]= batch_score[k];\
+        d= batch_score[k] + (mv_penalty[(bx<<shift)-pred_x] + mv_penalty[(by<<shift)-pred_y])*penalty_factor;\
+        update\
     }\
+    batch_n= 0;\
+}
+
+#define FLUSH_MV_BATCH SCORE_MV_BATCH(COPY3_IF_LT(dmin, d, best[0], bx, best[1], by))
+
+#define FLUSH_MV_BATCH_DIR\
+    SCORE_MV_BATCH(if(d<dmin){ best[0]=bx; best[1]=by; dmin=d; next_dir= batch[k][2]; })
+
+#define QUEUE_MV(x,y)\
+{\
+    QUEUE_MV_DIR(x,y,-1)\
+    if(batch_n == ME_BATCH_SIZE)\
+        FLUSH_MV_BATCH\
+}
+
+#define QUEUE_CLIPPED_MV(ax,ay)\
+{\
+    const int Lx= ax;\
+    const int Ly= ay;\
+    const int Lx2= FFMAX(xmin, FFMIN(Lx, xmax));\
+    const int Ly2= FFMAX(ymin, FFMIN(Ly, ymax));\
+    QUEUE_MV(Lx2, Ly2)\
 }
 
 #define check(x,y,S,v)\
@@ -420,6 +464,7 @@ static av_always_inline int small_diamond_search(MpegEncContext * s, int *best,
     int next_dir=-1;
     LOAD_COMMON
     LOAD_COMMON2
+    LOAD_BATCH
     unsigned map_generation = c->map_generation;
 
     cmpf        = s->mecc.me_cmp[size];
@@ -441,10 +486,11 @@ static av_always_inline int small_diamond_search(MpegEncContext * s, int *best,
         const int y= best[1];
         next_dir=-1;
 
-        if(dir!=2 && x>xmin) CHECK_MV_DIR(x-1, y  , 0)
-        if(dir!=3 && y>ymin) CHECK_MV_DIR(x  , y-1, 1)
-        if(dir!=0 && x<xmax) CHECK_MV_DIR(x+1, y  , 2)
-        if(dir!=1 && y<ymax) CHECK_MV_DIR(x  , y+1, 3)
+        if(dir!=2 && x>xmin) QUEUE_MV_DIR(x-1, y  , 0)
+        if(dir!=3 && y>ymin) QUEUE_MV_DIR(x  , y-1, 1)
+        if(dir!=0 && x<xmax) QUEUE_MV_DIR(x+1, y  , 2)
+        if(dir!=1 && y<ymax) QUEUE_MV_DIR(x  , y+1, 3)
+        FLUSH_MV_BATCH_DIR
 
         if(next_dir==-1){
             return dmin;
@@ -458,9 +504,10 @@ static int funny_diamond_search(MpegEncContext * s, int *best, int dmin,
 {
     MotionEstContext * const c= &s->me;
     me_cmp_func cmpf, chroma_cmpf;
-    int dia_size;
+    int dia_size, d;
     LOAD_COMMON
     LOAD_COMMON2
+    LOAD_BATCH
     unsigned map_generation = c->map_generation;
 
     cmpf        = s->mecc.me_cmp[size];
@@ -480,13 +527,12 @@ static int funny_diamond_search(MpegEncContext * s, int *best, int dmin,
            continue;
 
         for(dir= 0; dir<dia_size; dir+=2){
-            int d;
-
-            CHECK_MV(x + dir           , y + dia_size - dir);
-            CHECK_MV(x + dia_size - dir, y - dir           );
-            CHECK_MV(x - dir           , y - dia_size + dir);
-            CHECK_MV(x - dia_size + dir, y + dir           );
+            QUEUE_MV(x + dir           , y + dia_size - dir);
+            QUEUE_MV(x + dia_size - dir, y - dir           );
+            QUEUE_MV(x - dir           , y - dia_size + dir);
+            QUEUE_MV(x - dia_size + dir, y + dir           );
         }
+        FLUSH_MV_BATCH
 
         if(x!=best[0] || y!=best[1])
             dia_size=0;
@@ -502,6 +548,7 @@ static int hex_search(MpegEncContext * s, int *best, int dmin,
     me_cmp_func cmpf, chroma_cmpf;
     LOAD_COMMON
     LOAD_COMMON2
+    LOAD_BATCH
     unsigned map_generation = c->map_generation;
     int x,y,d;
     const int dec= dia_size & (dia_size-1);
@@ -514,14 +561,15 @@ static int hex_search(MpegEncContext * s, int *best, int dmin,
             x= best[0];
             y= best[1];
 
-            CHECK_CLIPPED_MV(x  -dia_size    , y);
-            CHECK_CLIPPED_MV(x+  dia_size    , y);
-            CHECK_CLIPPED_MV(x+( dia_size>>1), y+dia_size);
-            CHECK_CLIPPED_MV(x+( dia_size>>1), y-dia_size);
+            QUEUE_CLIPPED_MV(x  -dia_size    , y);
+            QUEUE_CLIPPED_MV(x+  dia_size    , y);
+            QUEUE_CLIPPED_MV(x+( dia_size>>1), y+dia_size);
+            QUEUE_CLIPPED_MV(x+( dia_size>>1), y-dia_size);
             if(dia_size>1){
-                CHECK_CLIPPED_MV(x+(-dia_size>>1), y+dia_size);
-                CHECK_CLIPPED_MV(x+(-dia_size>>1), y-dia_size);
+                QUEUE_CLIPPED_MV(x+(-dia_size>>1), y+dia_size);
+                QUEUE_CLIPPED_MV(x+(-dia_size>>1), y-dia_size);
             }
+            FLUSH_MV_BATCH
         }while(best[0] != x || best[1] != y);
     }
 
@@ -536,6 +584,7 @@ static int l2s_dia_search(MpegEncContext * s, int *best, int dmin,
     me_cmp_func cmpf, chroma_cmpf;
     LOAD_COMMON
     LOAD_COMMON2
+    LOAD_BATCH
     unsigned map_generation = c->map_generation;
     int x,y,i,d;
     int dia_size= c->dia_size&0xFF;
@@ -551,17 +600,19 @@ static int l2s_dia_search(MpegEncContext * s, int *best, int dmin,
             x= best[0];
             y= best[1];
             for(i=0; i<8; i++){
-                CHECK_CLIPPED_MV(x+hex[i][0]*dia_size, y+hex[i][1]*dia_size);
+                QUEUE_CLIPPED_MV(x+hex[i][0]*dia_size, y+hex[i][1]*dia_size);
             }
+            FLUSH_MV_BATCH
         }while(best[0] != x || best[1] != y);
     }
 
     x= best[0];
     y= best[1];
-    CHECK_CLIPPED_MV(x+1, y);
-    CHECK_CLIPPED_MV(x, y+1);
-    CHECK_CLIPPED_MV(x-1, y);
-    CHECK_CLIPPED_MV(x, y-1);
+    QUEUE_CLIPPED_MV(x+1, y);
+    QUEUE_CLIPPED_MV(x, y+1);
+    QUEUE_CLIPPED_MV(x-1, y);
+    QUEUE_CLIPPED_MV(x, y-1);
+    FLUSH_MV_BATCH
 
     return dmin;
 }
@@ -574,6 +625,7 @@ static int umh_search(MpegEncContext * s, int *best, int dmin,
     me_cmp_func cmpf, chroma_cmpf;
     LOAD_COMMON
     LOAD_COMMON2
+    LOAD_BATCH
     unsigned map_generation = c->map_generation;
     int x,y,x2,y2, i, j, d;
     const int dia_size= c->dia_size&0xFE;
@@ -588,17 +640,18 @@ static int umh_search(MpegEncContext * s, int *best, int dmin,
     x= best[0];
     y= best[1];
     for(x2=FFMAX(x-dia_size+1, xmin); x2<=FFMIN(x+dia_size-1,xmax); x2+=2){
-        CHECK_MV(x2, y);
+        QUEUE_MV(x2, y);
     }
     for(y2=FFMAX(y-dia_size/2+1, ymin); y2<=FFMIN(y+dia_size/2-1,ymax); y2+=2){
-        CHECK_MV(x, y2);
+        QUEUE_MV(x, y2);
     }
+    FLUSH_MV_BATCH
 
     x= best[0];
     y= best[1];
     for(y2=FFMAX(y-2, ymin); y2<=FFMIN(y+2,ymax); y2++){
         for(x2=FFMAX(x-2, xmin); x2<=FFMIN(x+2,xmax); x2++){
-            CHECK_MV(x2, y2);
+            QUEUE_MV(x2, y2);
         }
     }
 
@@ -606,9 +659,10 @@ static int umh_search(MpegEncContext * s, int *best, int dmin,
 
     for(j=1; j<=dia_size/4; j++){
         for(i=0; i<16; i++){
-            CHECK_CLIPPED_MV(x+hex[i][0]*j, y+hex[i][1]*j);
+            QUEUE_CLIPPED_MV(x+hex[i][0]*j, y+hex[i][1]*j);
         }
     }
+    FLUSH_MV_BATCH
 
     return hex_search(s, best, dmin, src_index, ref_index, penalty_factor, size, h, flags, 2);
 }
@@ -621,6 +675,7 @@ static int full_search(MpegEncContext * s, int *best, int dmin,
     me_cmp_func cmpf, chroma_cmpf;
     LOAD_COMMON
     LOAD_COMMON2
+    LOAD_BATCH
     unsigned map_generation = c->map_generation;
     int x,y, d;
     const int dia_size= c->dia_size&0xFF;
@@ -630,9 +685,10 @@ static int full_search(MpegEncContext * s, int *best, int dmin,
 
     for(y=FFMAX(-dia_size, ymin); y<=FFMIN(dia_size,ymax); y++){
         for(x=FFMAX(-dia_size, xmin); x<=FFMIN(dia_size,xmax); x++){
-            CHECK_MV(x, y);
+            QUEUE_MV(x, y);
         }
     }
+    FLUSH_MV_BATCH
 
     x= best[0];
     y= best[1];
@@ -771,9 +827,10 @@ static int var_diamond_search(MpegEncContext * s, int *best, int dmin,
 {
     MotionEstContext * const c= &s->me;
     me_cmp_func cmpf, chroma_cmpf;
-    int dia_size;
+    int dia_size, d;
     LOAD_COMMON
     LOAD_COMMON2
+    LOAD_BATCH
     unsigned map_generation = c->map_generation;
 
     cmpf        = s->mecc.me_cmp[size];
@@ -787,39 +844,33 @@ static int var_diamond_search(MpegEncContext * s, int *best, int dmin,
         start= FFMAX(0, y + dia_size - ymax);
         end  = FFMIN(dia_size, xmax - x + 1);
         for(dir= start; dir<end; dir++){
-            int d;
-
 //check(x + dir,y + dia_size - dir,0, a0)
-            CHECK_MV(x + dir           , y + dia_size - dir);
+            QUEUE_MV(x + dir           , y + dia_size - dir);
         }
 
         start= FFMAX(0, x + dia_size - xmax);
         end  = FFMIN(dia_size, y - ymin + 1);
         for(dir= start; dir<end; dir++){
-            int d;
-
 //check(x + dia_size - dir, y - dir,0, a1)
-            CHECK_MV(x + dia_size - dir, y - dir           );
+            QUEUE_MV(x + dia_size - dir, y - dir           );
         }
 
         start= FFMAX(0, -y + dia_size + ymin );
         end  = FFMIN(dia_size, x - xmin + 1);
         for(dir= start; dir<end; dir++){
-            int d;
-
 //check(x - dir,y - dia_size + dir,0, a2)
-            CHECK_MV(x - dir           , y - dia_size + dir);
+            QUEUE_MV(x - dir           , y - dia_size + dir);
         }
 
         start= FFMAX(0, -x + dia_size + xmin );
         end  = FFMIN(dia_size, ymax - y + 1);
         for(dir= start; dir<end; dir++){
-            int d;
-
 //check(x - dia_size + dir, y + dir,0, a3)
-            CHECK_MV(x - dia_size + dir, y + dir           );
+            QUEUE_MV(x - dia_size + dir, y + dir           );
         }
 
+        FLUSH_MV_BATCH
+
         if(x!=best[0] || y!=best[1])
             dia_size=0;
     }
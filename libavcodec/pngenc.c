@@ -24,6 +24,7 @@
 #include "bytestream.h"
 #include "huffyuvencdsp.h"
 #include "png.h"
+#include "pngencdsp.h"
 #include "apng.h"
 
 #include "libavutil/avassert.h"
@@ -36,17 +37,31 @@
 
 #define IOBUF_SIZE 4096
 
+typedef struct PNGEncBand {
+    z_stream zstream;
+    uint8_t *crow_base;
+    unsigned int crow_base_size;
+    uint8_t *buf;
+    unsigned int buf_size;
+    int len;                     ///< size of the deflated band, or a negative error code
+    uLong adler;                 ///< Adler-32 of the filtered rows of the band
+} PNGEncBand;
+
 typedef struct PNGEncContext {
     AVClass *class;
     HuffYUVEncDSPContext hdsp;
+    PNGEncDSPContext pdsp;
 
     uint8_t *bytestream;
     uint8_t *bytestream_start;
     uint8_t *bytestream_end;
 
     int filter_type;
+    int compression_level;
 
     z_stream zstream;
+    PNGEncBand *band;
+    int nb_bands;                ///< number of row bands deflated independently
     uint8_t buf[IOBUF_SIZE];
     int dpi;                     ///< Physical pixel density, in dots per inch, if set
     int dpm;                     ///< Physical pixel density, in dots per meter, if set
@@ -100,34 +115,6 @@ static void png_get_interlaced_row(uint8_t *dst, int row_size,
     }
 }
 
-static void sub_png_paeth_prediction(uint8_t *dst, uint8_t *src, uint8_t *top,
-                                     int w, int bpp)
-{
-    int i;
-    for (i = 0; i < w; i++) {
-        int a, b, c, p, pa, pb, pc;
-
-        a = src[i - bpp];
-        b = top[i];
-        c = top[i - bpp];
-
-        p  = b - c;
-        pc = a - c;
-
-        pa = abs(p);
-        pb = abs(pc);
-        pc = abs(p + pc);
-
-        if (pa <= pb && pa <= pc)
-            p = a;
-        else if (pb <= pc)
-            p = b;
-        else
-            p = c;
-        dst[i] = src[i] - p;
-    }
-}
-
 static void sub_left_prediction(PNGEncContext *c, uint8_t *dst, const uint8_t *src, int bpp, int size)
 {
     const uint8_t *src1 = src + bpp;
@@ -162,13 +149,12 @@ static void png_filter_row(PNGEncContext *c, uint8_t *dst, int filter_type,
     case PNG_FILTER_VALUE_AVG:
         for (i = 0; i < bpp; i++)
             dst[i] = src[i] - (top[i] >> 1);
-        for (; i < size; i++)
-            dst[i] = src[i] - ((src[i - bpp] + top[i]) >> 1);
+        c->pdsp.sub_avg_prediction(dst + i, src + i, top + i, size - i, bpp);
         break;
     case PNG_FILTER_VALUE_PAETH:
         for (i = 0; i < bpp; i++)
             dst[i] = src[i] - top[i];
-        sub_png_paeth_prediction(dst + i, src + i, top + i, size - i, bpp);
+        c->pdsp.sub_paeth_prediction(dst + i, src + i, top + i, size - i, bpp);
         break;
     }
 }
@@ -181,15 +167,12 @@ static uint8_t *png_choose_filter(PNGEncContext *s, uint8_t *dst,
     if (!top && pred)
         pred = PNG_FILTER_VALUE_SUB;
     if (pred == PNG_FILTER_VALUE_MIXED) {
-        int i;
         int cost, bcost = INT_MAX;
         uint8_t *buf1 = dst, *buf2 = dst + size + 16;
         for (pred = 0; pred < 5; pred++) {
             png_filter_row(s, buf1 + 1, pred, src, top, size, bpp);
             buf1[0] = pred;
-            cost = 0;
-            for (i = 0; i <= size; i++)
-                cost += abs((int8_t) buf1[i]);
+            cost = s->pdsp.filter_cost(buf1, size + 1);
             if (cost < bcost) {
                 bcost = cost;
                 FFSWAP(uint8_t *, buf1, buf2);
@@ -392,6 +375,125 @@ static int encode_headers(AVCodecContext *avctx, const AVFrame *pict)
     return 0;
 }
 
+static void png_write_deflated(AVCodecContext *avctx, int *pos,
+                               const uint8_t *data, int len)
+{
+    PNGEncContext *s = avctx->priv_data;
+
+    while (len > 0) {
+        int n = FFMIN(len, IOBUF_SIZE - *pos);
+        memcpy(s->buf + *pos, data, n);
+        *pos += n;
+        data += n;
+        len  -= n;
+        if (*pos == IOBUF_SIZE) {
+            if (s->bytestream_end - s->bytestream > IOBUF_SIZE + 100)
+                png_write_image_data(avctx, s->buf, IOBUF_SIZE);
+            *pos = 0;
+        }
+    }
+}
+
+static int encode_band(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    PNGEncContext *s       = avctx->priv_data;
+    const AVFrame *const p = arg;
+    PNGEncBand *band       = &s->band[jobnr];
+    const int row_size     = (avctx->width * s->bits_per_pixel + 7) >> 3;
+    const int start        = avctx->height *  jobnr      / s->nb_bands;
+    const int end          = avctx->height * (jobnr + 1) / s->nb_bands;
+    const int last         = jobnr == s->nb_bands - 1;
+    uint8_t *ptr, *top, *crow;
+    int y, ret;
+
+    band->zstream.avail_out = band->buf_size;
+    band->zstream.next_out  = band->buf;
+    band->adler             = adler32(0, NULL, 0);
+    band->len               = AVERROR_EXTERNAL;
+
+    top = start ? p->data[0] + (start - 1) * p->linesize[0] : NULL;
+    for (y = start; y < end; y++) {
+        ptr  = p->data[0] + y * p->linesize[0];
+        crow = png_choose_filter(s, band->crow_base + 15, ptr, top,
+                                 row_size, s->bits_per_pixel >> 3);
+        band->adler = adler32(band->adler, crow, row_size + 1);
+        band->zstream.avail_in = row_size + 1;
+        band->zstream.next_in  = crow;
+        ret = deflate(&band->zstream, Z_NO_FLUSH);
+        if (ret != Z_OK || band->zstream.avail_in)
+            goto the_end;
+        top = ptr;
+    }
+    /* all bands but the last end on a byte boundary without the final
+     * block bit, so that they can simply be concatenated */
+    ret = deflate(&band->zstream, last ? Z_FINISH : Z_SYNC_FLUSH);
+    if (ret == (last ? Z_STREAM_END : Z_OK) && band->zstream.avail_out)
+        band->len = band->buf_size - band->zstream.avail_out;
+
+the_end:
+    deflateReset(&band->zstream);
+    return band->len < 0 ? band->len : 0;
+}
+
+/**
+ * Encode the image data as independently deflated bands of rows, which
+ * are compressed in parallel and joined into a single zlib stream.
+ */
+static int encode_frame_bands(AVCodecContext *avctx, const AVFrame *pict)
+{
+    PNGEncContext *s   = avctx->priv_data;
+    const int row_size = (avctx->width * s->bits_per_pixel + 7) >> 3;
+    int level_flags, header, i, pos = 0;
+    uLong adler = adler32(0, NULL, 0);
+    uint8_t buf[4];
+
+    for (i = 0; i < s->nb_bands; i++) {
+        PNGEncBand *band = &s->band[i];
+        int rows = avctx->height * (i + 1) / s->nb_bands -
+                   avctx->height *  i      / s->nb_bands;
+
+        av_fast_malloc(&band->crow_base, &band->crow_base_size,
+                       (row_size + 32) << (s->filter_type == PNG_FILTER_VALUE_MIXED));
+        // room for the sync flush marker on top of the bound
+        av_fast_malloc(&band->buf, &band->buf_size,
+                       deflateBound(&band->zstream, (uLong)rows * (row_size + 1)) + 64);
+        if (!band->crow_base || !band->buf)
+            return AVERROR(ENOMEM);
+    }
+
+    avctx->execute2(avctx, encode_band, (void *)pict, NULL, s->nb_bands);
+
+    /* zlib header, as written by deflate() */
+    if (s->compression_level == Z_DEFAULT_COMPRESSION || s->compression_level == 6)
+        level_flags = 2;
+    else if (s->compression_level < 2)
+        level_flags = 0;
+    else
+        level_flags = s->compression_level < 6 ? 1 : 3;
+    header  = (Z_DEFLATED + ((MAX_WBITS - 8) << 4)) << 8 | level_flags << 6;
+    header += 31 - header % 31;
+    AV_WB16(buf, header);
+    png_write_deflated(avctx, &pos, buf, 2);
+
+    for (i = 0; i < s->nb_bands; i++) {
+        PNGEncBand *band = &s->band[i];
+        int rows = avctx->height * (i + 1) / s->nb_bands -
+                   avctx->height *  i      / s->nb_bands;
+
+        if (band->len < 0)
+            return band->len;
+        png_write_deflated(avctx, &pos, band->buf, band->len);
+        adler = adler32_combine(adler, band->adler, (z_off_t)rows * (row_size + 1));
+    }
+
+    AV_WB32(buf, adler);
+    png_write_deflated(avctx, &pos, buf, 4);
+    if (pos > 0 && s->bytestream_end - s->bytestream > pos + 100)
+        png_write_image_data(avctx, s->buf, pos);
+
+    return 0;
+}
+
 static int encode_frame(AVCodecContext *avctx, const AVFrame *pict)
 {
     PNGEncContext *s       = avctx->priv_data;
@@ -403,6 +505,9 @@ static int encode_frame(AVCodecContext *avctx, const AVFrame *pict)
     uint8_t *progressive_buf = NULL;
     uint8_t *top_buf         = NULL;
 
+    if (s->nb_bands > 1)
+        return encode_frame_bands(avctx, pict);
+
     row_size = (avctx->width * s->bits_per_pixel + 7) >> 3;
 
     crow_base = av_malloc((row_size + 32) << (s->filter_type == PNG_FILTER_VALUE_MIXED));
@@ -608,7 +713,7 @@ static int encode_apng(AVCodecContext *avctx, AVPacket *pkt,
 static av_cold int png_enc_init(AVCodecContext *avctx)
 {
     PNGEncContext *s = avctx->priv_data;
-    int compression_level;
+    int compression_level, i;
 
     switch (avctx->pix_fmt) {
     case AV_PIX_FMT_RGBA:
@@ -635,6 +740,7 @@ static av_cold int png_enc_init(AVCodecContext *avctx)
     avctx->coded_frame->key_frame = 1;
 
     ff_huffyuvencdsp_init(&s->hdsp);
+    ff_pngencdsp_init(&s->pdsp);
 
     s->filter_type = av_clip(avctx->prediction_method,
                              PNG_FILTER_VALUE_NONE,
@@ -704,6 +810,23 @@ static av_cold int png_enc_init(AVCodecContext *avctx)
                       : av_clip(avctx->compression_level, 0, 9);
     if (deflateInit2(&s->zstream, compression_level, Z_DEFLATED, 15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
         return -1;
+    s->compression_level = compression_level;
+
+    if (avctx->slices > 1 && !s->is_progressive) {
+        s->band = av_mallocz_array(FFMIN(avctx->slices, avctx->height), sizeof(*s->band));
+        if (!s->band)
+            return AVERROR(ENOMEM);
+        for (i = 0; i < FFMIN(avctx->slices, avctx->height); i++) {
+            z_stream *zstream = &s->band[i].zstream;
+            zstream->zalloc = ff_png_zalloc;
+            zstream->zfree  = ff_png_zfree;
+            zstream->opaque = NULL;
+            if (deflateInit2(zstream, compression_level, Z_DEFLATED, -MAX_WBITS,
+                             8, Z_DEFAULT_STRATEGY) != Z_OK)
+                return -1;
+            s->nb_bands++;
+        }
+    }
 
     return 0;
 }
@@ -711,8 +834,15 @@ static av_cold int png_enc_init(AVCodecContext *avctx)
 static av_cold int png_enc_close(AVCodecContext *avctx)
 {
     PNGEncContext *s = avctx->priv_data;
+    int i;
 
     deflateEnd(&s->zstream);
+    for (i = 0; i < s->nb_bands; i++) {
+        deflateEnd(&s->band[i].zstream);
+        av_freep(&s->band[i].crow_base);
+        av_freep(&s->band[i].buf);
+    }
+    av_freep(&s->band);
     av_frame_free(&avctx->coded_frame);
     return 0;
 }
@@ -748,7 +878,8 @@ AVCodec ff_png_encoder = {
     .init           = png_enc_init,
     .close          = png_enc_close,
     .encode2        = encode_png,
-    .capabilities   = CODEC_CAP_FRAME_THREADS | CODEC_CAP_INTRA_ONLY,
+    .capabilities   = CODEC_CAP_FRAME_THREADS | CODEC_CAP_SLICE_THREADS |
+                      CODEC_CAP_INTRA_ONLY,
     .pix_fmts       = (const enum AVPixelFormat[]) {
         AV_PIX_FMT_RGB24, AV_PIX_FMT_RGBA,
         AV_PIX_FMT_RGB48BE, AV_PIX_FMT_RGBA64BE,
@@ -769,6 +900,7 @@ AVCodec ff_apng_encoder = {
     .init           = png_enc_init,
     .close          = png_enc_close,
     .encode2        = encode_apng,
+    .capabilities   = CODEC_CAP_SLICE_THREADS,
     .pix_fmts       = (const enum AVPixelFormat[]) {
         AV_PIX_FMT_RGB24, AV_PIX_FMT_RGBA,
         AV_PIX_FMT_RGB48BE, AV_PIX_FMT_RGBA64BE,
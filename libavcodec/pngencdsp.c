@@ -0,0 +1,79 @@
+/*
+ * PNG encoder DSP functions
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdlib.h>
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "pngencdsp.h"
+
+static void sub_avg_prediction_c(uint8_t *dst, const uint8_t *src,
+                                 const uint8_t *top, int w, int bpp)
+{
+    int i;
+    for (i = 0; i < w; i++)
+        dst[i] = src[i] - ((src[i - bpp] + top[i]) >> 1);
+}
+
+void ff_sub_png_paeth_prediction(uint8_t *dst, const uint8_t *src,
+                                 const uint8_t *top, int w, int bpp)
+{
+    int i;
+    for (i = 0; i < w; i++) {
+        int a, b, c, p, pa, pb, pc;
+
+        a = src[i - bpp];
+        b = top[i];
+        c = top[i - bpp];
+
+        p  = b - c;
+        pc = a - c;
+
+        pa = abs(p);
+        pb = abs(pc);
+        pc = abs(p + pc);
+
+        if (pa <= pb && pa <= pc)
+            p = a;
+        else if (pb <= pc)
+            p = b;
+        else
+            p = c;
+        dst[i] = src[i] - p;
+    }
+}
+
+static int filter_cost_c(const uint8_t *buf, int size)
+{
+    int i, cost = 0;
+    for (i = 0; i < size; i++)
+        cost += abs((int8_t) buf[i]);
+    return cost;
+}
+
+av_cold void ff_pngencdsp_init(PNGEncDSPContext *c)
+{
+    c->sub_avg_prediction   = sub_avg_prediction_c;
+    c->sub_paeth_prediction = ff_sub_png_paeth_prediction;
+    c->filter_cost          = filter_cost_c;
+
+    if (ARCH_X86)
+        ff_pngencdsp_init_x86(c);
+}
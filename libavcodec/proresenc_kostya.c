@@ -26,11 +26,11 @@
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
 #include "avcodec.h"
-#include "fdctdsp.h"
 #include "put_bits.h"
 #include "bytestream.h"
 #include "internal.h"
 #include "proresdata.h"
+#include "proresencdsp.h"
 
 #define CFACTOR_Y422 2
 #define CFACTOR_Y444 3
@@ -181,7 +181,9 @@ struct TrellisNode {
 
 typedef struct ProresThreadData {
     DECLARE_ALIGNED(16, int16_t, blocks)[MAX_PLANES][64 * 4 * MAX_MBS_PER_SLICE];
+    DECLARE_ALIGNED(16, int16_t, levels)[64 * 4 * MAX_MBS_PER_SLICE];
     DECLARE_ALIGNED(16, uint16_t, emu_buf)[16 * 16];
+    uint32_t nz[64];
     int16_t custom_q[64];
     struct TrellisNode *nodes;
 } ProresThreadData;
@@ -189,15 +191,15 @@ typedef struct ProresThreadData {
 typedef struct ProresContext {
     AVClass *class;
     DECLARE_ALIGNED(16, int16_t, blocks)[MAX_PLANES][64 * 4 * MAX_MBS_PER_SLICE];
+    DECLARE_ALIGNED(16, int16_t, levels)[64 * 4 * MAX_MBS_PER_SLICE];
     DECLARE_ALIGNED(16, uint16_t, emu_buf)[16*16];
+    uint32_t nz[64];
     int16_t quants[MAX_STORED_Q][64];
     int16_t custom_q[64];
     const uint8_t *quant_mat;
     const uint8_t *scantable;
 
-    void (*fdct)(FDCTDSPContext *fdsp, const uint16_t *src,
-                 int linesize, int16_t *block);
-    FDCTDSPContext fdsp;
+    ProresEncDSPContext dsp;
 
     int mb_width, mb_height;
     int mbs_per_slice;
@@ -225,6 +227,26 @@ typedef struct ProresContext {
     ProresThreadData *tdata;
 } ProresContext;
 
+/**
+ * Transform a block and store its coefficients in scan order with a
+ * distance of stride between them.
+ */
+static void fdct_block(ProresContext *ctx, const uint16_t *src, int linesize,
+                       int16_t *dst, int stride)
+{
+    LOCAL_ALIGNED_16(int16_t, block, [64]);
+    int i;
+
+    ctx->dsp.fdct(src, linesize, block);
+    for (i = 0; i < 64; i++)
+        dst[i * stride] = block[ctx->scantable[i]];
+}
+
+/**
+ * Compute the DCT coefficients of a slice plane. They are stored in scan
+ * order, interleaved by block, so that coefficient i of block b ends up
+ * in blocks[i * blocks_per_slice + b], the order they are coded in.
+ */
 static void get_slice_data(ProresContext *ctx, const uint16_t *src,
                            int linesize, int x, int y, int w, int h,
                            int16_t *blocks, uint16_t *emu_buf,
@@ -232,13 +254,15 @@ static void get_slice_data(ProresContext *ctx, const uint16_t *src,
 {
     const uint16_t *esrc;
     const int mb_width = 4 * blocks_per_mb;
+    const int blocks_per_slice = mbs_per_slice * blocks_per_mb;
     int elinesize;
     int i, j, k;
 
     for (i = 0; i < mbs_per_slice; i++, src += mb_width) {
         if (x >= w) {
-            memset(blocks, 0, 64 * (mbs_per_slice - i) * blocks_per_mb
-                              * sizeof(*blocks));
+            for (j = 0; j < 64; j++)
+                memset(blocks + j * blocks_per_slice, 0,
+                       (mbs_per_slice - i) * blocks_per_mb * sizeof(*blocks));
             return;
         }
         if (x + mb_width <= w && y + 16 <= h) {
@@ -267,28 +291,20 @@ static void get_slice_data(ProresContext *ctx, const uint16_t *src,
                        mb_width * sizeof(*emu_buf));
         }
         if (!is_chroma) {
-            ctx->fdct(&ctx->fdsp, esrc, elinesize, blocks);
-            blocks += 64;
-            if (blocks_per_mb > 2) {
-                ctx->fdct(&ctx->fdsp, esrc + 8, elinesize, blocks);
-                blocks += 64;
-            }
-            ctx->fdct(&ctx->fdsp, esrc + elinesize * 4, elinesize, blocks);
-            blocks += 64;
-            if (blocks_per_mb > 2) {
-                ctx->fdct(&ctx->fdsp, esrc + elinesize * 4 + 8, elinesize, blocks);
-                blocks += 64;
-            }
+            fdct_block(ctx, esrc, elinesize, blocks++, blocks_per_slice);
+            if (blocks_per_mb > 2)
+                fdct_block(ctx, esrc + 8, elinesize, blocks++, blocks_per_slice);
+            fdct_block(ctx, esrc + elinesize * 4, elinesize, blocks++, blocks_per_slice);
+            if (blocks_per_mb > 2)
+                fdct_block(ctx, esrc + elinesize * 4 + 8, elinesize, blocks++,
+                           blocks_per_slice);
         } else {
-            ctx->fdct(&ctx->fdsp, esrc, elinesize, blocks);
-            blocks += 64;
-            ctx->fdct(&ctx->fdsp, esrc + elinesize * 4, elinesize, blocks);
-            blocks += 64;
+            fdct_block(ctx, esrc, elinesize, blocks++, blocks_per_slice);
+            fdct_block(ctx, esrc + elinesize * 4, elinesize, blocks++, blocks_per_slice);
             if (blocks_per_mb > 2) {
-                ctx->fdct(&ctx->fdsp, esrc + 8, elinesize, blocks);
-                blocks += 64;
-                ctx->fdct(&ctx->fdsp, esrc + elinesize * 4 + 8, elinesize, blocks);
-                blocks += 64;
+                fdct_block(ctx, esrc + 8, elinesize, blocks++, blocks_per_slice);
+                fdct_block(ctx, esrc + elinesize * 4 + 8, elinesize, blocks++,
+                           blocks_per_slice);
             }
         }
 
@@ -369,9 +385,9 @@ static void encode_dcs(PutBitContext *pb, int16_t *blocks,
     encode_vlc_codeword(pb, FIRST_DC_CB, MAKE_CODE(prev_dc));
     sign     = 0;
     codebook = 3;
-    blocks  += 64;
+    blocks++;
 
-    for (i = 1; i < blocks_per_slice; i++, blocks += 64) {
+    for (i = 1; i < blocks_per_slice; i++, blocks++) {
         dc       = (blocks[0] - 0x4000) / scale;
         delta    = dc - prev_dc;
         new_sign = GET_SIGN(delta);
@@ -385,37 +401,43 @@ static void encode_dcs(PutBitContext *pb, int16_t *blocks,
     }
 }
 
-static void encode_acs(PutBitContext *pb, int16_t *blocks,
-                       int blocks_per_slice,
-                       int plane_size_factor,
-                       const uint8_t *scan, const int16_t *qmat)
+/**
+ * Code the AC levels produced by ProresEncDSPContext.quant_ac, skipping
+ * the zero runs with the help of the nonzero masks.
+ */
+static void encode_acs(PutBitContext *pb, const int16_t *levels,
+                       const uint32_t *nz, int blocks_per_slice,
+                       int plane_size_factor)
 {
-    int idx, i;
+    int i, b, next;
     int run, level, run_cb, lev_cb;
-    int max_coeffs, abs_level;
+    int abs_level;
+    uint32_t mask;
 
-    max_coeffs = blocks_per_slice << 6;
-    run_cb     = ff_prores_run_to_cb_index[4];
-    lev_cb     = ff_prores_lev_to_cb_index[2];
-    run        = 0;
+    run_cb = ff_prores_run_to_cb_index[4];
+    lev_cb = ff_prores_lev_to_cb_index[2];
+    run    = 0;
 
     for (i = 1; i < 64; i++) {
-        for (idx = scan[i]; idx < max_coeffs; idx += 64) {
-            level = blocks[idx] / qmat[scan[i]];
-            if (level) {
-                abs_level = FFABS(level);
-                encode_vlc_codeword(pb, ff_prores_ac_codebook[run_cb], run);
-                encode_vlc_codeword(pb, ff_prores_ac_codebook[lev_cb],
-                                    abs_level - 1);
-                put_sbits(pb, 1, GET_SIGN(level));
-
-                run_cb = ff_prores_run_to_cb_index[FFMIN(run, 15)];
-                lev_cb = ff_prores_lev_to_cb_index[FFMIN(abs_level, 9)];
-                run    = 0;
-            } else {
-                run++;
-            }
+        levels += blocks_per_slice;
+        mask    = nz[i];
+        for (next = 0; mask; mask &= mask - 1) {
+            b      = ff_ctz(mask);
+            run   += b - next;
+            next   = b + 1;
+            level  = levels[b];
+
+            abs_level = FFABS(level);
+            encode_vlc_codeword(pb, ff_prores_ac_codebook[run_cb], run);
+            encode_vlc_codeword(pb, ff_prores_ac_codebook[lev_cb],
+                                abs_level - 1);
+            put_sbits(pb, 1, GET_SIGN(level));
+
+            run_cb = ff_prores_run_to_cb_index[FFMIN(run, 15)];
+            lev_cb = ff_prores_lev_to_cb_index[FFMIN(abs_level, 9)];
+            run    = 0;
         }
+        run += blocks_per_slice - next;
     }
 }
 
@@ -431,8 +453,9 @@ static int encode_slice_plane(ProresContext *ctx, PutBitContext *pb,
     blocks_per_slice = mbs_per_slice * blocks_per_mb;
 
     encode_dcs(pb, blocks, blocks_per_slice, qmat[0]);
-    encode_acs(pb, blocks, blocks_per_slice, plane_size_factor,
-               ctx->scantable, qmat);
+    ctx->dsp.quant_ac(ctx->levels, ctx->nz, blocks, qmat, ctx->scantable,
+                      blocks_per_slice);
+    encode_acs(pb, ctx->levels, ctx->nz, blocks_per_slice, plane_size_factor);
     flush_put_bits(pb);
 
     return (put_bits_count(pb) - saved_pos) >> 3;
@@ -612,10 +635,10 @@ static int estimate_dcs(int *error, int16_t *blocks, int blocks_per_slice,
     bits     = estimate_vlc(FIRST_DC_CB, MAKE_CODE(prev_dc));
     sign     = 0;
     codebook = 3;
-    blocks  += 64;
+    blocks++;
     *error  += FFABS(blocks[0] - 0x4000) % scale;
 
-    for (i = 1; i < blocks_per_slice; i++, blocks += 64) {
+    for (i = 1; i < blocks_per_slice; i++, blocks++) {
         dc       = (blocks[0] - 0x4000) / scale;
         *error  += FFABS(blocks[0] - 0x4000) % scale;
         delta    = dc - prev_dc;
@@ -632,37 +655,37 @@ static int estimate_dcs(int *error, int16_t *blocks, int blocks_per_slice,
     return bits;
 }
 
-static int estimate_acs(int *error, int16_t *blocks, int blocks_per_slice,
-                        int plane_size_factor,
-                        const uint8_t *scan, const int16_t *qmat)
+static int estimate_acs(const int16_t *levels, const uint32_t *nz,
+                        int blocks_per_slice, int plane_size_factor)
 {
-    int idx, i;
-    int run, level, run_cb, lev_cb;
-    int max_coeffs, abs_level;
+    int i, b, next;
+    int run, run_cb, lev_cb;
+    int abs_level;
     int bits = 0;
+    uint32_t mask;
 
-    max_coeffs = blocks_per_slice << 6;
-    run_cb     = ff_prores_run_to_cb_index[4];
-    lev_cb     = ff_prores_lev_to_cb_index[2];
-    run        = 0;
+    run_cb = ff_prores_run_to_cb_index[4];
+    lev_cb = ff_prores_lev_to_cb_index[2];
+    run    = 0;
 
     for (i = 1; i < 64; i++) {
-        for (idx = scan[i]; idx < max_coeffs; idx += 64) {
-            level   = blocks[idx] / qmat[scan[i]];
-            *error += FFABS(blocks[idx]) % qmat[scan[i]];
-            if (level) {
-                abs_level = FFABS(level);
-                bits += estimate_vlc(ff_prores_ac_codebook[run_cb], run);
-                bits += estimate_vlc(ff_prores_ac_codebook[lev_cb],
-                                     abs_level - 1) + 1;
-
-                run_cb = ff_prores_run_to_cb_index[FFMIN(run, 15)];
-                lev_cb = ff_prores_lev_to_cb_index[FFMIN(abs_level, 9)];
-                run    = 0;
-            } else {
-                run++;
-            }
+        levels += blocks_per_slice;
+        mask    = nz[i];
+        for (next = 0; mask; mask &= mask - 1) {
+            b     = ff_ctz(mask);
+            run  += b - next;
+            next  = b + 1;
+
+            abs_level = FFABS(levels[b]);
+            bits += estimate_vlc(ff_prores_ac_codebook[run_cb], run);
+            bits += estimate_vlc(ff_prores_ac_codebook[lev_cb],
+                                 abs_level - 1) + 1;
+
+            run_cb = ff_prores_run_to_cb_index[FFMIN(run, 15)];
+            lev_cb = ff_prores_lev_to_cb_index[FFMIN(abs_level, 9)];
+            run    = 0;
         }
+        run += blocks_per_slice - next;
     }
 
     return bits;
@@ -679,9 +702,11 @@ static int estimate_slice_plane(ProresContext *ctx, int *error, int plane,
 
     blocks_per_slice = mbs_per_slice * blocks_per_mb;
 
-    bits  = estimate_dcs(error, td->blocks[plane], blocks_per_slice, qmat[0]);
-    bits += estimate_acs(error, td->blocks[plane], blocks_per_slice,
-                         plane_size_factor, ctx->scantable, qmat);
+    bits    = estimate_dcs(error, td->blocks[plane], blocks_per_slice, qmat[0]);
+    *error += ctx->dsp.quant_ac(td->levels, td->nz, td->blocks[plane], qmat,
+                                ctx->scantable, blocks_per_slice);
+    bits   += estimate_acs(td->levels, td->nz, blocks_per_slice,
+                           plane_size_factor);
 
     return FFALIGN(bits, 8);
 }
@@ -1102,20 +1127,6 @@ static av_cold int encode_close(AVCodecContext *avctx)
     return 0;
 }
 
-static void prores_fdct(FDCTDSPContext *fdsp, const uint16_t *src,
-                        int linesize, int16_t *block)
-{
-    int x, y;
-    const uint16_t *tsrc = src;
-
-    for (y = 0; y < 8; y++) {
-        for (x = 0; x < 8; x++)
-            block[y * 8 + x] = tsrc[x];
-        tsrc += linesize >> 1;
-    }
-    fdsp->fdct(block);
-}
-
 static av_cold int encode_init(AVCodecContext *avctx)
 {
     ProresContext *ctx = avctx->priv_data;
@@ -1131,10 +1142,9 @@ static av_cold int encode_init(AVCodecContext *avctx)
     avctx->coded_frame->pict_type = AV_PICTURE_TYPE_I;
     avctx->coded_frame->key_frame = 1;
 
-    ctx->fdct      = prores_fdct;
     ctx->scantable = interlaced ? ff_prores_interlaced_scan
                                 : ff_prores_progressive_scan;
-    ff_fdctdsp_init(&ctx->fdsp, avctx);
+    ff_proresencdsp_init(&ctx->dsp);
 
     mps = ctx->mbs_per_slice;
     if (mps & (mps - 1)) {
@@ -0,0 +1,71 @@
+/*
+ * Apple ProRes encoder DSP functions
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "dct.h"
+#include "proresencdsp.h"
+
+static void prores_fdct_c(const uint16_t *src, ptrdiff_t linesize,
+                          int16_t *block)
+{
+    int x, y;
+
+    for (y = 0; y < 8; y++) {
+        for (x = 0; x < 8; x++)
+            block[y * 8 + x] = src[x];
+        src += linesize >> 1;
+    }
+    ff_jpeg_fdct_islow_10(block);
+}
+
+int ff_prores_quant_ac(int16_t *levels, uint32_t *nz, const int16_t *coeffs,
+                       const int16_t *qmat, const uint8_t *scan,
+                       int blocks_per_slice)
+{
+    int i, b, error = 0;
+
+    for (i = 1; i < 64; i++) {
+        const int q   = qmat[scan[i]];
+        uint32_t mask = 0;
+
+        coeffs += blocks_per_slice;
+        levels += blocks_per_slice;
+        for (b = 0; b < blocks_per_slice; b++) {
+            levels[b] = coeffs[b] / q;
+            error    += FFABS(coeffs[b]) % q;
+            if (levels[b])
+                mask |= 1U << b;
+        }
+        nz[i] = mask;
+    }
+
+    return error;
+}
+
+av_cold void ff_proresencdsp_init(ProresEncDSPContext *c)
+{
+    c->fdct     = prores_fdct_c;
+    c->quant_ac = ff_prores_quant_ac;
+
+    if (ARCH_X86)
+        ff_proresencdsp_init_x86(c);
+}
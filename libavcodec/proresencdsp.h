@@ -0,0 +1,57 @@
+/*
+ * Apple ProRes encoder DSP functions
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVCODEC_PRORESENCDSP_H
+#define AVCODEC_PRORESENCDSP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct ProresEncDSPContext {
+    /**
+     * Load an 8x8 block of 10-bit samples and apply the forward DCT.
+     * The result is bit-exact with ff_jpeg_fdct_islow_10().
+     * @param linesize distance between source lines in bytes
+     * @param block    16-byte aligned output
+     */
+    void (*fdct)(const uint16_t *src, ptrdiff_t linesize, int16_t *block);
+
+    /**
+     * Quantize the AC coefficients of a slice. The coefficients are
+     * stored in scan order and interleaved by block: coefficient i of
+     * block b is coeffs[i * blocks_per_slice + b]. The levels are written
+     * to the same positions in levels, and bit b of nz[i] is set when
+     * the level of block b at scan position i is nonzero.
+     * @param qmat quantiser matrix in raster order
+     * @return the sum of the absolute quantisation errors
+     */
+    int (*quant_ac)(int16_t *levels, uint32_t *nz, const int16_t *coeffs,
+                    const int16_t *qmat, const uint8_t *scan,
+                    int blocks_per_slice);
+} ProresEncDSPContext;
+
+int ff_prores_quant_ac(int16_t *levels, uint32_t *nz, const int16_t *coeffs,
+                       const int16_t *qmat, const uint8_t *scan,
+                       int blocks_per_slice);
+
+void ff_proresencdsp_init(ProresEncDSPContext *c);
+void ff_proresencdsp_init_x86(ProresEncDSPContext *c);
+
+#endif /* AVCODEC_PRORESENCDSP_H */
@@ -84,19 +84,17 @@ static inline int get_rac_count(RangeCoder *c)
 
 static inline void put_rac(RangeCoder *c, uint8_t *const state, int bit)
 {
-    int range1 = (c->range * (*state)) >> 8;
+    int range1   = (c->range * (*state)) >> 8;
+    int range0   = c->range - range1;
+    int one_mask = -!!bit;
 
     av_assert2(*state);
     av_assert2(range1 < c->range);
     av_assert2(range1 > 0);
-    if (!bit) {
-        c->range -= range1;
-        *state    = c->zero_state[*state];
-    } else {
-        c->low  += c->range - range1;
-        c->range = range1;
-        *state   = c->one_state[*state];
-    }
+
+    c->low   += range0 & one_mask;
+    c->range  = range0 ^ ((range0 ^ range1) & one_mask);
+    *state    = (bit ? c->one_state : c->zero_state)[*state];
 
     renorm_encoder(c);
 }
@@ -115,33 +113,21 @@ static inline void refill(RangeCoder *c)
 static inline int get_rac(RangeCoder *c, uint8_t *const state)
 {
     int range1 = (c->range * (*state)) >> 8;
+    int one_mask;
 
     c->range -= range1;
-#if 1
-    if (c->low < c->range) {
-        *state = c->zero_state[*state];
-        refill(c);
-        return 0;
-    } else {
-        c->low  -= c->range;
-        *state   = c->one_state[*state];
-        c->range = range1;
-        refill(c);
-        return 1;
-    }
-#else
-    {
-        int one_mask one_mask = (c->range - c->low - 1) >> 31;
 
-        c->low   -=           c->range  & one_mask;
-        c->range += (range1 - c->range) & one_mask;
+    /* branchless, the decoded bits of the symbol mantissas are close to
+     * random */
+    one_mask = (c->range - c->low - 1) >> 31;
 
-        *state = c->zero_state[(*state) + (256 & one_mask)];
-    }
+    c->low   -=           c->range  & one_mask;
+    c->range += (range1 - c->range) & one_mask;
+
+    *state = (one_mask ? c->one_state : c->zero_state)[*state];
     refill(c);
 
     return one_mask & 1;
-#endif
 }
 
 #endif /* AVCODEC_RANGECODER_H */
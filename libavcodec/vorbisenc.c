@@ -26,6 +26,7 @@
 
 #include <float.h>
 
+#include "libavutil/float_dsp.h"
 #include "avcodec.h"
 #include "internal.h"
 #include "fft.h"
@@ -51,6 +52,8 @@ typedef struct vorbis_enc_codebook {
     int *quantlist;
     float *dimensions;
     float *pow2;
+    int nlattice;     ///< values per dimension if the vectors form a lattice, else 0
+    int *lattice;     ///< lookup value index for each quantized value
 } vorbis_enc_codebook;
 
 typedef struct vorbis_enc_floor_class {
@@ -103,6 +106,8 @@ typedef struct vorbis_enc_context {
     int log2_blocksize[2];
     FFTContext mdct[2];
     const float *win[2];
+    float *window; ///< short block window scaled by 4/blocksize
+    AVFloatDSPContext *fdsp;
     int have_saved;
     float *saved;
     float *samples;
@@ -193,6 +198,27 @@ static int ready_codebook(vorbis_enc_codebook *cb)
             }
             cb->pow2[i] /= 2.0;
         }
+
+        /* With lookup type 1 and no sequence mode every dimension is coded
+         * independently. If the quantized values are 0..vals-1 the vectors
+         * form a regular lattice, and the nearest one can be found by
+         * rounding each dimension. */
+        if (cb->lookup == 1 && !cb->seq_p && cb->delta > 0) {
+            cb->lattice = av_malloc_array(vals, sizeof(int));
+            if (!cb->lattice)
+                return AVERROR(ENOMEM);
+            memset(cb->lattice, -1, vals * sizeof(int));
+            for (i = 0; i < vals; i++) {
+                int q = cb->quantlist[i];
+                if (q >= vals || cb->lattice[q] >= 0)
+                    break;
+                cb->lattice[q] = i;
+            }
+            if (i == vals)
+                cb->nlattice = vals;
+            else
+                av_freep(&cb->lattice);
+        }
     }
     return 0;
 }
@@ -249,7 +275,7 @@ static int create_vorbis_context(vorbis_enc_context *venc,
     venc->log2_blocksize[0] = venc->log2_blocksize[1] = 11;
 
     venc->ncodebooks = FF_ARRAY_ELEMS(cvectors);
-    venc->codebooks  = av_malloc(sizeof(vorbis_enc_codebook) * venc->ncodebooks);
+    venc->codebooks  = av_mallocz(sizeof(vorbis_enc_codebook) * venc->ncodebooks);
     if (!venc->codebooks)
         return AVERROR(ENOMEM);
 
@@ -429,6 +455,14 @@ static int create_vorbis_context(vorbis_enc_context *venc,
     venc->win[0] = ff_vorbis_vwin[venc->log2_blocksize[0] - 6];
     venc->win[1] = ff_vorbis_vwin[venc->log2_blocksize[1] - 6];
 
+    venc->window = av_malloc_array(sizeof(float), 1 << (venc->log2_blocksize[0] - 1));
+    venc->fdsp   = avpriv_float_dsp_alloc(avctx->flags & CODEC_FLAG_BITEXACT);
+    if (!venc->window || !venc->fdsp)
+        return AVERROR(ENOMEM);
+    // the scale factor is a power of two, so folding it into the window is exact
+    for (i = 0; i < 1 << (venc->log2_blocksize[0] - 1); i++)
+        venc->window[i] = venc->win[0][i] / ((1 << venc->log2_blocksize[0]) / 4);
+
     if ((ret = ff_mdct_init(&venc->mdct[0], venc->log2_blocksize[0], 0, 1.0)) < 0)
         return ret;
     if ((ret = ff_mdct_init(&venc->mdct[1], venc->log2_blocksize[1], 0, 1.0)) < 0)
@@ -849,12 +883,44 @@ static int floor_encode(vorbis_enc_context *venc, vorbis_enc_floor *fc,
     return 0;
 }
 
-static float *put_vector(vorbis_enc_codebook *book, PutBitContext *pb,
-                         float *num)
+/**
+ * Find the nearest vector of a lattice codebook one dimension at a time.
+ * @return the entry, or -1 if the nearest lattice point has no codeword
+ */
+static int lattice_search(const vorbis_enc_codebook *book, const float *num)
+{
+    int j, q, entry = 0, mul = 1;
+
+    for (j = 0; j < book->ndimensions; j++) {
+        float distance = FLT_MAX;
+        int best = 0;
+        int k    = av_clip(lrintf((num[j] - book->min) / book->delta),
+                           0, book->nlattice - 1);
+
+        /* rounding can be off by one for values halfway between two points,
+         * pick the neighbour with the lowest index on ties. The distance is
+         * not rounded like the sum in exhaustive_search(), so points that
+         * are about equally close may be chosen differently. */
+        for (q = FFMAX(k - 1, 0); q <= FFMIN(k + 1, book->nlattice - 1); q++) {
+            int   i = book->lattice[q];
+            float v = book->min + q * book->delta;
+            float d = v * (0.5f * v - num[j]);
+            if (distance > d || (distance == d && i < best)) {
+                best     = i;
+                distance = d;
+            }
+        }
+        entry += best * mul;
+        mul   *= book->nlattice;
+    }
+    return book->lens[entry] ? entry : -1;
+}
+
+static int exhaustive_search(const vorbis_enc_codebook *book, const float *num)
 {
     int i, entry = -1;
     float distance = FLT_MAX;
-    assert(book->dimensions);
+
     for (i = 0; i < book->nentries; i++) {
         float * vec = book->dimensions + i * book->ndimensions, d = book->pow2[i];
         int j;
@@ -867,6 +933,18 @@ static float *put_vector(vorbis_enc_codebook *book, PutBitContext *pb,
             distance = d;
         }
     }
+    return entry;
+}
+
+static float *put_vector(vorbis_enc_codebook *book, PutBitContext *pb,
+                         float *num)
+{
+    int entry = -1;
+    assert(book->dimensions);
+    if (book->nlattice)
+        entry = lattice_search(book, num);
+    if (entry < 0)
+        entry = exhaustive_search(book, num);
     if (put_codeword(pb, book, entry))
         return NULL;
     return &book->dimensions[entry * book->ndimensions];
@@ -970,11 +1048,9 @@ static int residue_encode(vorbis_enc_context *venc, vorbis_enc_residue *rc,
 static int apply_window_and_mdct(vorbis_enc_context *venc,
                                  float **audio, int samples)
 {
-    int i, channel;
-    const float * win = venc->win[0];
+    int channel;
+    const float *win = venc->window;
     int window_len = 1 << (venc->log2_blocksize[0] - 1);
-    float n = (float)(1 << venc->log2_blocksize[0]) / 4.0;
-    // FIXME use dsp
 
     if (!venc->have_saved && !samples)
         return 0;
@@ -989,11 +1065,14 @@ static int apply_window_and_mdct(vorbis_enc_context *venc,
                    sizeof(float) * window_len);
     }
 
+    /* without CODEC_CAP_SMALL_LAST_FRAME every frame is padded to
+     * frame_size, so the window is applied over its whole length */
+    av_assert0(!samples || samples == window_len);
+
     if (samples) {
         for (channel = 0; channel < venc->channels; channel++) {
-            float * offset = venc->samples + channel*window_len*2 + window_len;
-            for (i = 0; i < samples; i++)
-                offset[i] = audio[channel][i] / n * win[window_len - i - 1];
+            float *offset = venc->samples + channel * window_len * 2 + window_len;
+            venc->fdsp->vector_fmul_reverse(offset, audio[channel], win, samples);
         }
     } else {
         for (channel = 0; channel < venc->channels; channel++)
@@ -1008,8 +1087,7 @@ static int apply_window_and_mdct(vorbis_enc_context *venc,
     if (samples) {
         for (channel = 0; channel < venc->channels; channel++) {
             float *offset = venc->saved + channel * window_len;
-            for (i = 0; i < samples; i++)
-                offset[i] = audio[channel][i] / n * win[i];
+            venc->fdsp->vector_fmul(offset, audio[channel], win, samples);
         }
         venc->have_saved = 1;
     } else {
@@ -1117,6 +1195,7 @@ static av_cold int vorbis_encode_close(AVCodecContext *avctx)
             av_freep(&venc->codebooks[i].quantlist);
             av_freep(&venc->codebooks[i].dimensions);
             av_freep(&venc->codebooks[i].pow2);
+            av_freep(&venc->codebooks[i].lattice);
         }
     av_freep(&venc->codebooks);
 
@@ -1152,6 +1231,8 @@ static av_cold int vorbis_encode_close(AVCodecContext *avctx)
     av_freep(&venc->modes);
 
     av_freep(&venc->saved);
+    av_freep(&venc->window);
+    av_freep(&venc->fdsp);
     av_freep(&venc->samples);
     av_freep(&venc->floor);
     av_freep(&venc->coeffs);
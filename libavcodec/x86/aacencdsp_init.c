@@ -0,0 +1,140 @@
+/*
+ * AAC encoder SIMD functions
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/mem.h"
+#include "libavutil/x86/asm.h"
+#include "libavutil/x86/cpu.h"
+#include "libavcodec/aacenc.h"
+#include "libavcodec/aacenc_utils.h"
+
+#if HAVE_INLINE_ASM
+
+/* Both functions give the same results as the C versions: sqrtps is
+ * correctly rounded like sqrtf(), and the rounding and clipping of the
+ * quantized values is done in double precision. The per-tuple codebook
+ * bit cost and distortion in quantize_and_encode_band_cost() stay in C:
+ * they are serial table lookups and a summation whose order the coders'
+ * decisions depend on. */
+
+#if HAVE_SSE_INLINE && HAVE_INLINE_ASM_LABELS
+DECLARE_ASM_CONST(16, uint32_t, abs_mask)[4] = {
+    0x7fffffff, 0x7fffffff, 0x7fffffff, 0x7fffffff
+};
+
+static void abs_pow34_sse(float *out, const float *in, const int size)
+{
+    const int len = size & ~3;
+    x86_reg i     = -4 * len;
+
+    if (len) {
+        __asm__ volatile(
+            "movaps  %3, %%xmm2                 \n\t"
+            "1:                                 \n\t"
+            "movups  (%1, %0), %%xmm0           \n\t"
+            "andps   %%xmm2, %%xmm0             \n\t"
+            "sqrtps  %%xmm0, %%xmm1             \n\t"
+            "mulps   %%xmm1, %%xmm0             \n\t"
+            "sqrtps  %%xmm0, %%xmm0             \n\t"
+            "movups  %%xmm0, (%2, %0)           \n\t"
+            "add     $16, %0                    \n\t"
+            "jl      1b                         \n\t"
+            : "+r"(i)
+            : "r"(in + len), "r"(out + len), "m"(*abs_mask)
+            : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2",) "memory"
+        );
+    }
+    abs_pow34_v(out + len, in + len, size - len);
+}
+#endif /* HAVE_SSE_INLINE && HAVE_INLINE_ASM_LABELS */
+
+#if HAVE_SSE2_INLINE && HAVE_INLINE_ASM_LABELS
+static void quantize_bands_sse2(int *out, const float *in, const float *scaled,
+                                int size, float Q34, int is_signed, int maxval)
+{
+    const int len = size & ~3;
+    x86_reg i     = -4 * len;
+    const double rounding = 0.4054;
+    const double dmaxval  = maxval;
+    const int sign_mask   = is_signed ? -1 : 0;
+
+    if (len) {
+        __asm__ volatile(
+            "movss      %4, %%xmm4              \n\t"
+            "shufps     $0, %%xmm4, %%xmm4      \n\t"
+            "movsd      %5, %%xmm5              \n\t"
+            "unpcklpd   %%xmm5, %%xmm5          \n\t"
+            "movsd      %6, %%xmm6              \n\t"
+            "unpcklpd   %%xmm6, %%xmm6          \n\t"
+            "movd       %7, %%xmm7              \n\t"
+            "pshufd     $0, %%xmm7, %%xmm7      \n\t"
+            "1:                                 \n\t"
+            "movups     (%2, %0), %%xmm0        \n\t"
+            "mulps      %%xmm4, %%xmm0          \n\t"
+            "cvtps2pd   %%xmm0, %%xmm1          \n\t"
+            "movhlps    %%xmm0, %%xmm0          \n\t"
+            "cvtps2pd   %%xmm0, %%xmm0          \n\t"
+            "addpd      %%xmm5, %%xmm1          \n\t"
+            "addpd      %%xmm5, %%xmm0          \n\t"
+            "minpd      %%xmm6, %%xmm1          \n\t"
+            "minpd      %%xmm6, %%xmm0          \n\t"
+            "cvttpd2dq  %%xmm1, %%xmm1          \n\t"
+            "cvttpd2dq  %%xmm0, %%xmm0          \n\t"
+            "punpcklqdq %%xmm0, %%xmm1          \n\t"
+            "movups     (%1, %0), %%xmm2        \n\t"
+            "xorps      %%xmm3, %%xmm3          \n\t"
+            "cmpltps    %%xmm3, %%xmm2          \n\t"
+            "andps      %%xmm7, %%xmm2          \n\t"
+            "pxor       %%xmm2, %%xmm1          \n\t"
+            "psubd      %%xmm2, %%xmm1          \n\t"
+            "movdqu     %%xmm1, (%3, %0)        \n\t"
+            "add        $16, %0                 \n\t"
+            "jl         1b                      \n\t"
+            : "+r"(i)
+            : "r"(in + len), "r"(scaled + len), "r"(out + len),
+              "m"(Q34), "m"(rounding), "m"(dmaxval), "m"(sign_mask)
+            : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                           "%xmm4", "%xmm5", "%xmm6", "%xmm7",) "memory"
+        );
+    }
+    quantize_bands(out + len, in + len, scaled + len, size - len,
+                   Q34, is_signed, maxval);
+}
+#endif /* HAVE_SSE2_INLINE && HAVE_INLINE_ASM_LABELS */
+
+#endif /* HAVE_INLINE_ASM */
+
+av_cold void ff_aac_dsp_init_x86(AACEncContext *s)
+{
+#if HAVE_INLINE_ASM
+    int cpu_flags = av_get_cpu_flags();
+
+#if HAVE_SSE_INLINE && HAVE_INLINE_ASM_LABELS
+    if (INLINE_SSE(cpu_flags))
+        s->abs_pow34   = abs_pow34_sse;
+#endif
+#if HAVE_SSE2_INLINE && HAVE_INLINE_ASM_LABELS
+    if (INLINE_SSE2(cpu_flags))
+        s->quant_bands = quantize_bands_sse2;
+#endif
+#endif /* HAVE_INLINE_ASM */
+}
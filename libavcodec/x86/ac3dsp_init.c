@@ -25,6 +25,7 @@
 #include "libavutil/x86/cpu.h"
 #include "libavcodec/ac3.h"
 #include "libavcodec/ac3dsp.h"
+#include "libavcodec/ac3tab.h"
 
 void ff_ac3_exponent_min_mmx   (uint8_t *exp, int num_reuse_blocks, int nb_coefs);
 void ff_ac3_exponent_min_mmxext(uint8_t *exp, int num_reuse_blocks, int nb_coefs);
@@ -196,6 +197,184 @@ static void ac3_downmix_sse(float **samples, float (*matrix)[2],
 
 #endif /* HAVE_SSE_INLINE && HAVE_7REGS */
 
+#if HAVE_AVX2_INLINE
+
+#define R4(v)  v, v, v, v
+#define R16(v) { R4(v), R4(v), R4(v), R4(v) }
+#define R32(v) { R4(v), R4(v), R4(v), R4(v), R4(v), R4(v), R4(v), R4(v) }
+
+DECLARE_ALIGNED(16, static const uint8_t, bap_bounds)[4][16] = {
+    R16(15), R16(31), R16(47), R16(63),
+};
+
+static void ac3_bit_alloc_calc_bap_avx2(int16_t *mask, int16_t *psd,
+                                        int start, int end, int snr_offset,
+                                        int floor, const uint8_t *bap_tab,
+                                        uint8_t *bap)
+{
+    LOCAL_ALIGNED_32(int16_t, m, [AC3_MAX_COEFS]);
+    const xmm_reg *tab = (const xmm_reg *)bap_tab;
+    int bin, band, band_end;
+    x86_reg n;
+
+    if (snr_offset == -960) {
+        memset(bap, 0, AC3_MAX_COEFS);
+        return;
+    }
+
+    /* expand the masking curve of each band to its bins */
+    bin  = start;
+    band = ff_ac3_bin_to_band_tab[start];
+    do {
+        int v = (FFMAX(mask[band] - snr_offset - floor, 0) & 0x1FE0) + floor;
+        band_end = ff_ac3_band_start_tab[++band];
+        band_end = FFMIN(band_end, end);
+        for (; bin < band_end; bin++)
+            m[bin] = v;
+    } while (end > band_end);
+
+    /* 16 bins per iteration, the 64 entry bap_tab is looked up with one
+     * pshufb per quarter */
+    n = (end - start) >> 4;
+    if (n > 0) {
+        int16_t *p = psd + start;
+        int16_t *q = m + start;
+        uint8_t *b = bap + start;
+
+        __asm__ volatile(
+            "vmovdqu          %4, %%xmm4                \n\t"
+            "vmovdqu          %5, %%xmm5                \n\t"
+            "vmovdqu          %6, %%xmm6                \n\t"
+            "vmovdqu          %7, %%xmm7                \n\t"
+            "1:                                         \n\t"
+            "vmovdqu        (%0), %%ymm0                \n\t"
+            "vpsubw         (%1), %%ymm0, %%ymm0        \n\t"
+            "vpsraw           $5, %%ymm0, %%ymm0        \n\t"
+            "vextracti128     $1, %%ymm0, %%xmm1        \n\t"
+            "vpackuswb   %%xmm1, %%xmm0, %%xmm0         \n\t"
+            "vpminub         %11, %%xmm0, %%xmm0        \n\t"
+            "vpshufb     %%xmm0, %%xmm4, %%xmm1         \n\t"
+            "vpshufb     %%xmm0, %%xmm5, %%xmm2         \n\t"
+            "vpcmpgtb         %8, %%xmm0, %%xmm3        \n\t"
+            "vpblendvb   %%xmm3, %%xmm2, %%xmm1, %%xmm1 \n\t"
+            "vpshufb     %%xmm0, %%xmm6, %%xmm2         \n\t"
+            "vpcmpgtb         %9, %%xmm0, %%xmm3        \n\t"
+            "vpblendvb   %%xmm3, %%xmm2, %%xmm1, %%xmm1 \n\t"
+            "vpshufb     %%xmm0, %%xmm7, %%xmm2         \n\t"
+            "vpcmpgtb        %10, %%xmm0, %%xmm3        \n\t"
+            "vpblendvb   %%xmm3, %%xmm2, %%xmm1, %%xmm1 \n\t"
+            "vmovdqu     %%xmm1, (%2)                   \n\t"
+            "add             $32, %0                    \n\t"
+            "add             $32, %1                    \n\t"
+            "add             $16, %2                    \n\t"
+            "sub              $1, %3                    \n\t"
+            "jg               1b                        \n\t"
+            "vzeroupper                                 \n\t"
+            : "+&r"(p), "+&r"(q), "+&r"(b), "+&r"(n)
+            : "m"(tab[0]), "m"(tab[1]), "m"(tab[2]), "m"(tab[3]),
+              "m"(bap_bounds[0]), "m"(bap_bounds[1]), "m"(bap_bounds[2]),
+              "m"(bap_bounds[3])
+            : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                           "%xmm4", "%xmm5", "%xmm6", "%xmm7",) "memory"
+        );
+    }
+
+    for (bin = start + ((end - start) & ~15); bin < end; bin++) {
+        int address = av_clip_uintp2((psd[bin] - m[bin]) >> 5, 6);
+        bap[bin] = bap_tab[address];
+    }
+}
+
+DECLARE_ALIGNED(32, static const uint8_t, bap_values)[16][32] = {
+    R32( 0), R32( 1), R32( 2), R32( 3), R32( 4), R32( 5), R32( 6), R32( 7),
+    R32( 8), R32( 9), R32(10), R32(11), R32(12), R32(13), R32(14), R32(15),
+};
+
+/* count 4 bap values: compare each 32 byte chunk with them and subtract
+ * the masks from byte counters, which are then summed with vpsadbw and
+ * packed as 4 words added to mant_cnt */
+#define COUNT_BAP4(v)                                                   \
+    __asm__ volatile(                                                   \
+        "vmovdqa          %2, %%ymm0            \n\t"                     \
+        "vpcmpeqb  32*"#v"+  0(%4), %%ymm0, %%ymm1 \n\t"                  \
+        "vpcmpeqb  32*"#v"+ 32(%4), %%ymm0, %%ymm2 \n\t"                  \
+        "vpcmpeqb  32*"#v"+ 64(%4), %%ymm0, %%ymm3 \n\t"                  \
+        "vpcmpeqb  32*"#v"+ 96(%4), %%ymm0, %%ymm4 \n\t"                  \
+        "vpxor       %%ymm5, %%ymm5, %%ymm5     \n\t"                     \
+        "vpsubb      %%ymm1, %%ymm5, %%ymm1     \n\t"                     \
+        "vpsubb      %%ymm2, %%ymm5, %%ymm2     \n\t"                     \
+        "vpsubb      %%ymm3, %%ymm5, %%ymm3     \n\t"                     \
+        "vpsubb      %%ymm4, %%ymm5, %%ymm4     \n\t"                     \
+        "test             %1, %1                \n\t"                     \
+        "jz               2f                    \n\t"                     \
+        "1:                                     \n\t"                     \
+        "vmovdqu        (%0), %%ymm0            \n\t"                     \
+        "vpcmpeqb  32*"#v"+  0(%4), %%ymm0, %%ymm5 \n\t"                  \
+        "vpsubb      %%ymm5, %%ymm1, %%ymm1     \n\t"                     \
+        "vpcmpeqb  32*"#v"+ 32(%4), %%ymm0, %%ymm5 \n\t"                  \
+        "vpsubb      %%ymm5, %%ymm2, %%ymm2     \n\t"                     \
+        "vpcmpeqb  32*"#v"+ 64(%4), %%ymm0, %%ymm5 \n\t"                  \
+        "vpsubb      %%ymm5, %%ymm3, %%ymm3     \n\t"                     \
+        "vpcmpeqb  32*"#v"+ 96(%4), %%ymm0, %%ymm5 \n\t"                  \
+        "vpsubb      %%ymm5, %%ymm4, %%ymm4     \n\t"                     \
+        "add             $32, %0                \n\t"                     \
+        "sub              $1, %1                \n\t"                     \
+        "jg               1b                    \n\t"                     \
+        "2:                                     \n\t"                     \
+        "vpxor       %%ymm5, %%ymm5, %%ymm5     \n\t"                     \
+        "vpsadbw     %%ymm5, %%ymm1, %%ymm1     \n\t"                     \
+        "vpsadbw     %%ymm5, %%ymm2, %%ymm2     \n\t"                     \
+        "vpsadbw     %%ymm5, %%ymm3, %%ymm3     \n\t"                     \
+        "vpsadbw     %%ymm5, %%ymm4, %%ymm4     \n\t"                     \
+        "vpsllq          $16, %%ymm2, %%ymm2    \n\t"                     \
+        "vpsllq          $32, %%ymm3, %%ymm3    \n\t"                     \
+        "vpsllq          $48, %%ymm4, %%ymm4    \n\t"                     \
+        "vpor        %%ymm2, %%ymm1, %%ymm1     \n\t"                     \
+        "vpor        %%ymm4, %%ymm3, %%ymm3     \n\t"                     \
+        "vpor        %%ymm3, %%ymm1, %%ymm1     \n\t"                     \
+        "vextracti128    $1, %%ymm1, %%xmm2     \n\t"                     \
+        "vpaddq      %%xmm2, %%xmm1, %%xmm1     \n\t"                     \
+        "vpshufd      $0xEE, %%xmm1, %%xmm2     \n\t"                     \
+        "vpaddq      %%xmm2, %%xmm1, %%xmm1     \n\t"                     \
+        "vmovq            %3, %%xmm2            \n\t"                     \
+        "vpaddw      %%xmm2, %%xmm1, %%xmm1     \n\t"                     \
+        "vmovq       %%xmm1, %3                 \n\t"                     \
+        : "+&r"(ptr), "+&r"(n)                                          \
+        : "m"(*tail), "m"(*(uint64_t *)&mant_cnt[v]),                   \
+          "r"(bap_values)                                               \
+        : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",              \
+                       "%xmm4", "%xmm5",) "memory"                      \
+    )
+
+static void ac3_update_bap_counts_avx2(uint16_t mant_cnt[16], uint8_t *bap,
+                                       int len)
+{
+    LOCAL_ALIGNED_32(uint8_t, tail, [32]);
+    int rem = len & 31;
+    uint8_t *ptr;
+    x86_reg n;
+
+    if (len <= 0)
+        return;
+
+    /* the last partial chunk is counted first, padded with values which
+     * do not match any bap */
+    memset(tail, 0xFF, 32 - rem);
+    memcpy(tail + 32 - rem, bap + len - rem, rem);
+
+    ptr = bap; n = len >> 5;
+    COUNT_BAP4(0);
+    ptr = bap; n = len >> 5;
+    COUNT_BAP4(4);
+    ptr = bap; n = len >> 5;
+    COUNT_BAP4(8);
+    ptr = bap; n = len >> 5;
+    COUNT_BAP4(12);
+    __asm__ volatile("vzeroupper" ::: "memory");
+}
+
+#endif /* HAVE_AVX2_INLINE */
+
 av_cold void ff_ac3dsp_init_x86(AC3DSPContext *c, int bit_exact)
 {
     int cpu_flags = av_get_cpu_flags();
@@ -254,4 +433,10 @@ av_cold void ff_ac3dsp_init_x86(AC3DSPContext *c, int bit_exact)
         c->downmix = ac3_downmix_sse;
     }
 #endif
+#if HAVE_AVX2_INLINE
+    if (INLINE_AVX2(cpu_flags)) {
+        c->bit_alloc_calc_bap = ac3_bit_alloc_calc_bap_avx2;
+        c->update_bap_counts  = ac3_update_bap_counts_avx2;
+    }
+#endif
 }
@@ -62,6 +62,9 @@ static const struct algo fdct_tab_arch[] = {
 #endif
 #if HAVE_SSE2_INLINE
     { "SSE2",   ff_fdct_sse2,   FF_IDCT_PERM_NONE, AV_CPU_FLAG_SSE2 },
+#endif
+#if HAVE_AVX2_INLINE
+    { "AVX2",   ff_fdct_avx2,   FF_IDCT_PERM_NONE, AV_CPU_FLAG_AVX2 },
 #endif
     { 0 }
 };
@@ -22,16 +22,140 @@
  */
 
 #include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/mem.h"
+#include "libavutil/x86/asm.h"
 #include "libavutil/x86/cpu.h"
 #include "libavcodec/dnxhdenc.h"
 
 void ff_get_pixels_8x4_sym_sse2(int16_t *block, const uint8_t *pixels,
                                 ptrdiff_t line_size);
 
+/* One macroblock per lane: the (ssd, bits) pairs of adjacent macroblocks
+ * are scaled and summed horizontally, and each lane keeps its minimum
+ * score and the first qscale reaching it. */
+
+#if HAVE_SSE4_INLINE
+static void select_qscale_sse4(uint8_t *qscale, uint16_t *bits,
+                               RCEntry (*mb_rc)[8160], int mb, int count,
+                               int qmax, unsigned lambda)
+{
+    DECLARE_ALIGNED(16, int, best)[4];
+    const int scale = 1 << LAMBDA_FRAC_BITS;
+    int i, j;
+
+    for (i = mb; i < mb + count; i += 4) {
+        const RCEntry *rc = &mb_rc[1][i];
+        x86_reg n         = qmax - 1;
+
+        __asm__ volatile(
+            "movd       %3,      %%xmm7         \n\t"
+            "movd       %4,      %%xmm2         \n\t"
+            "pshufd     $0, %%xmm7, %%xmm7      \n\t"
+            "pshufd     $0, %%xmm2, %%xmm2      \n\t"
+            "punpckldq  %%xmm7,  %%xmm2         \n\t"
+            "movdqa     %%xmm2,  %%xmm7         \n\t" // scale, lambda
+            "pcmpeqd    %%xmm6,  %%xmm6         \n\t" // min score
+            "pcmpeqd    %%xmm3,  %%xmm3         \n\t"
+            "psrld      $31,     %%xmm3         \n\t"
+            "movdqa     %%xmm3,  %%xmm4         \n\t" // qscale
+            "movdqa     %%xmm3,  %%xmm5         \n\t" // best qscale
+            "1:                                 \n\t"
+            "movdqu       (%0),  %%xmm0         \n\t"
+            "movdqu     16(%0),  %%xmm1         \n\t"
+            "pmulld     %%xmm7,  %%xmm0         \n\t"
+            "pmulld     %%xmm7,  %%xmm1         \n\t"
+            "phaddd     %%xmm1,  %%xmm0         \n\t"
+            "pminud     %%xmm6,  %%xmm0         \n\t"
+            "movdqa     %%xmm0,  %%xmm1         \n\t"
+            "pcmpeqd    %%xmm6,  %%xmm1         \n\t"
+            "movdqa     %%xmm0,  %%xmm6         \n\t"
+            "pand       %%xmm1,  %%xmm5         \n\t"
+            "pandn      %%xmm4,  %%xmm1         \n\t"
+            "por        %%xmm1,  %%xmm5         \n\t"
+            "paddd      %%xmm3,  %%xmm4         \n\t"
+            "add        %5,      %0             \n\t"
+            "sub        $1,      %1             \n\t"
+            "jg         1b                      \n\t"
+            "movdqa     %%xmm5,  %2             \n\t"
+            : "+r"(rc), "+r"(n), "+m"(best)
+            : "m"(lambda), "m"(scale), "i"(sizeof(mb_rc[0]))
+            : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                           "%xmm4", "%xmm5", "%xmm6", "%xmm7",) "memory"
+        );
+        for (j = 0; j < 4; j++) {
+            qscale[i + j] = best[j];
+            bits[i + j]   = mb_rc[best[j]][i + j].bits;
+        }
+    }
+}
+#endif /* HAVE_SSE4_INLINE */
+
+#if HAVE_AVX2_INLINE
+static void select_qscale_avx2(uint8_t *qscale, uint16_t *bits,
+                               RCEntry (*mb_rc)[8160], int mb, int count,
+                               int qmax, unsigned lambda)
+{
+    DECLARE_ALIGNED(32, int, best)[8];
+    const int scale = 1 << LAMBDA_FRAC_BITS;
+    int i, j;
+
+    for (i = mb; i < mb + count; i += 8) {
+        const RCEntry *rc = &mb_rc[1][i];
+        x86_reg n         = qmax - 1;
+
+        /* the horizontal add leaves the lanes in the order 0 1 4 5 2 3 6 7 */
+        __asm__ volatile(
+            "vpbroadcastd %3,    %%ymm7                 \n\t"
+            "vpbroadcastd %4,    %%ymm2                 \n\t"
+            "vpunpckldq %%ymm7,  %%ymm2, %%ymm7         \n\t" // scale, lambda
+            "vpcmpeqd   %%ymm6,  %%ymm6, %%ymm6         \n\t" // min score
+            "vpcmpeqd   %%ymm3,  %%ymm3, %%ymm3         \n\t"
+            "vpsrld     $31,     %%ymm3, %%ymm3         \n\t"
+            "vmovdqa    %%ymm3,  %%ymm4                 \n\t" // qscale
+            "vmovdqa    %%ymm3,  %%ymm5                 \n\t" // best qscale
+            "1:                                         \n\t"
+            "vpmulld      (%0),  %%ymm7, %%ymm0         \n\t"
+            "vpmulld    32(%0),  %%ymm7, %%ymm1         \n\t"
+            "vphaddd    %%ymm1,  %%ymm0, %%ymm0         \n\t"
+            "vpminud    %%ymm6,  %%ymm0, %%ymm0         \n\t"
+            "vpcmpeqd   %%ymm6,  %%ymm0, %%ymm1         \n\t"
+            "vmovdqa    %%ymm0,  %%ymm6                 \n\t"
+            "vpblendvb  %%ymm1,  %%ymm5, %%ymm4, %%ymm5 \n\t"
+            "vpaddd     %%ymm3,  %%ymm4, %%ymm4         \n\t"
+            "add        %5,      %0                     \n\t"
+            "sub        $1,      %1                     \n\t"
+            "jg         1b                              \n\t"
+            "vpermq     $0xd8,   %%ymm5, %%ymm5         \n\t"
+            "vmovdqa    %%ymm5,  %2                     \n\t"
+            "vzeroupper                                 \n\t"
+            : "+r"(rc), "+r"(n), "+m"(best)
+            : "m"(lambda), "m"(scale), "i"(sizeof(mb_rc[0]))
+            : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                           "%xmm4", "%xmm5", "%xmm6", "%xmm7",) "memory"
+        );
+        for (j = 0; j < 8; j++) {
+            qscale[i + j] = best[j];
+            bits[i + j]   = mb_rc[best[j]][i + j].bits;
+        }
+    }
+}
+#endif /* HAVE_AVX2_INLINE */
+
 av_cold void ff_dnxhdenc_init_x86(DNXHDEncContext *ctx)
 {
-    if (EXTERNAL_SSE2(av_get_cpu_flags())) {
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_SSE2(cpu_flags)) {
         if (ctx->cid_table->bit_depth == 8)
             ctx->get_pixels_8x4_sym = ff_get_pixels_8x4_sym_sse2;
     }
+#if HAVE_SSE4_INLINE
+    if (INLINE_SSE4(cpu_flags))
+        ctx->select_qscale = select_qscale_sse4;
+#endif
+#if HAVE_AVX2_INLINE
+    if (INLINE_AVX2(cpu_flags))
+        ctx->select_qscale = select_qscale_avx2;
+#endif
 }
@@ -592,3 +592,65 @@ void ff_fdct_sse2(int16_t *block)
 }
 
 #endif /* HAVE_SSE2_INLINE */
+
+#if HAVE_AVX2_INLINE
+
+/* Same as fdct_row_sse2(), but with the two rows sharing a coefficient
+ * table in the two lanes of the registers. */
+static av_always_inline void fdct_row_avx2(const int16_t *in, int16_t *out)
+{
+    __asm__ volatile(
+#define FDCT_ROW_AVX2(i,j,t)                                 \
+        "vmovq          " #i "(%0), %%xmm2               \n\t" \
+        "vmovq          " #j "(%0), %%xmm1               \n\t" \
+        "vinserti128    $1, %%xmm1, %%ymm2, %%ymm2       \n\t" \
+        "vmovq          " #i "+8(%0), %%xmm0             \n\t" \
+        "vmovq          " #j "+8(%0), %%xmm1             \n\t" \
+        "vinserti128    $1, %%xmm1, %%ymm0, %%ymm0       \n\t" \
+        "vbroadcasti128 " #t "(%1), %%ymm4               \n\t" \
+        "vbroadcasti128 " #t "+16(%1), %%ymm5            \n\t" \
+        "vbroadcasti128 " #t "+32(%1), %%ymm3            \n\t" \
+        "vbroadcasti128 " #t "+48(%1), %%ymm7            \n\t" \
+        "vpshuflw       $27, %%ymm0, %%ymm0              \n\t" \
+        "vpaddsw        %%ymm0, %%ymm2, %%ymm1           \n\t" \
+        "vpsubsw        %%ymm0, %%ymm2, %%ymm2           \n\t" \
+        "vpunpckldq     %%ymm2, %%ymm1, %%ymm1           \n\t" \
+        "vpshufd        $78, %%ymm1, %%ymm2              \n\t" \
+        "vpmaddwd       %%ymm2, %%ymm3, %%ymm3           \n\t" \
+        "vpmaddwd       %%ymm1, %%ymm7, %%ymm7           \n\t" \
+        "vpmaddwd       %%ymm5, %%ymm2, %%ymm2           \n\t" \
+        "vpmaddwd       %%ymm4, %%ymm1, %%ymm1           \n\t" \
+        "vpaddd         %%ymm7, %%ymm3, %%ymm3           \n\t" \
+        "vpaddd         %%ymm2, %%ymm1, %%ymm1           \n\t" \
+        "vpaddd         %%ymm6, %%ymm3, %%ymm3           \n\t" \
+        "vpaddd         %%ymm6, %%ymm1, %%ymm1           \n\t" \
+        "vpsrad         %3, %%ymm3, %%ymm3               \n\t" \
+        "vpsrad         %3, %%ymm1, %%ymm1               \n\t" \
+        "vpackssdw      %%ymm3, %%ymm1, %%ymm1           \n\t" \
+        "vmovdqa        %%xmm1, " #i "(%4)               \n\t" \
+        "vextracti128   $1, %%ymm1, " #j "(%4)           \n\t"
+
+        "vbroadcasti128 (%2), %%ymm6                     \n\t"
+        FDCT_ROW_AVX2(0,  64,  0)
+        FDCT_ROW_AVX2(16, 112, 64)
+        FDCT_ROW_AVX2(32, 96,  128)
+        FDCT_ROW_AVX2(48, 80,  192)
+        "vzeroupper                                      \n\t"
+        :
+        : "r" (in), "r" (tab_frw_01234567_sse2.tab_frw_01234567_sse2),
+          "r" (fdct_r_row_sse2.fdct_r_row_sse2), "i" (SHIFT_FRW_ROW), "r" (out)
+          XMM_CLOBBERS_ONLY("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                            "%xmm4", "%xmm5", "%xmm6", "%xmm7")
+    );
+}
+
+void ff_fdct_avx2(int16_t *block)
+{
+    DECLARE_ALIGNED(16, int64_t, align_tmp)[16];
+    int16_t * const block1= (int16_t*)align_tmp;
+
+    fdct_col_sse2(block, block1, 0);
+    fdct_row_avx2(block1, block);
+}
+
+#endif /* HAVE_AVX2_INLINE */
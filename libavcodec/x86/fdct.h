@@ -24,5 +24,6 @@
 void ff_fdct_mmx(int16_t *block);
 void ff_fdct_mmxext(int16_t *block);
 void ff_fdct_sse2(int16_t *block);
+void ff_fdct_avx2(int16_t *block);
 
 #endif /* AVCODEC_X86_FDCT_H */
@@ -39,6 +39,11 @@ av_cold void ff_fdctdsp_init_x86(FDCTDSPContext *c, AVCodecContext *avctx,
 
             if (INLINE_SSE2(cpu_flags))
                 c->fdct = ff_fdct_sse2;
+
+#if HAVE_AVX2_INLINE
+            if (INLINE_AVX2(cpu_flags))
+                c->fdct = ff_fdct_avx2;
+#endif
         }
     }
 }
@@ -0,0 +1,168 @@
+/*
+ * FFV1 SIMD functions
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/asm.h"
+#include "libavutil/x86/cpu.h"
+#include "libavcodec/ffv1dsp.h"
+
+#if HAVE_AVX2_INLINE
+
+/*
+ * Eight samples are processed per iteration in 32-bit lanes. The quant
+ * tables are looked up with vpgatherdd, reading each int16_t entry as the
+ * upper half of a dword so that an arithmetic shift sign extends it. This
+ * reads the 2 bytes in front of each table, which are shifted out. For the
+ * first table they lie before PlaneContext.quant_table, the first member of
+ * PlaneContext: in the preceding PlaneContext, or for plane 0 in the field
+ * of FFV1Context before plane[], so the read stays inside FFV1Context.
+ */
+
+#define LINE8(p) (*(const int16_t (*)[8])(p))
+
+#define MASK                                                        \
+    "vpcmpeqd   %%ymm7, %%ymm7, %%ymm7                      \n\t"   \
+    "vpsrld     $24, %%ymm7, %%ymm7                         \n\t"
+
+/* dst += quant_table[t][idx & 0xFF] with the 0xFF mask in ymm7,
+ * clobbers idx, ymm5 and ymm6 */
+#define QUANT(t, idx, dst)                                          \
+    "vpand      %%ymm7, "idx", "idx"                        \n\t"   \
+    "vpcmpeqd   %%ymm6, %%ymm6, %%ymm6                      \n\t"   \
+    "vpxor      %%ymm5, %%ymm5, %%ymm5                      \n\t"   \
+    "vpgatherdd %%ymm6, 512*"#t"-2(%[qt], "idx", 2), %%ymm5 \n\t"   \
+    "vpsrad     $16, %%ymm5, %%ymm5                         \n\t"   \
+    "vpaddd     %%ymm5, "dst", "dst"                        \n\t"
+
+static void context_top_avx2(int *context, const int16_t *last,
+                             const int16_t *last2,
+                             const int16_t (*quant_table)[256], int large,
+                             int w)
+{
+    int x;
+
+    for (x = 0; x < w; x += 8) {
+        __asm__ volatile(
+            MASK
+            "vpmovsxwd  %1, %%ymm0                  \n\t" // LT
+            "vpmovsxwd  %2, %%ymm1                  \n\t" // T
+            "vpmovsxwd  %3, %%ymm2                  \n\t" // RT
+            "vpxor      %%ymm4, %%ymm4, %%ymm4      \n\t"
+            "vpsubd     %%ymm1, %%ymm0, %%ymm3      \n\t"
+            QUANT(1, "%%ymm3", "%%ymm4")
+            "vpsubd     %%ymm2, %%ymm1, %%ymm3      \n\t"
+            QUANT(2, "%%ymm3", "%%ymm4")
+            "vmovdqu    %%ymm4, %0                  \n\t"
+            : "=m"(*(int (*)[8])(context + x))
+            : "m"(LINE8(last + x - 1)), "m"(LINE8(last + x)),
+              "m"(LINE8(last + x + 1)), [qt]"r"(quant_table)
+            : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                           "%xmm4", "%xmm5", "%xmm6", "%xmm7",) "memory"
+        );
+        if (large)
+            __asm__ volatile(
+                MASK
+                "vpmovsxwd  %1, %%ymm1              \n\t" // T
+                "vpmovsxwd  %2, %%ymm3              \n\t" // TT
+                "vmovdqu    %0, %%ymm4              \n\t"
+                "vpsubd     %%ymm1, %%ymm3, %%ymm3  \n\t"
+                QUANT(4, "%%ymm3", "%%ymm4")
+                "vmovdqu    %%ymm4, %0              \n\t"
+                : "+m"(*(int (*)[8])(context + x))
+                : "m"(LINE8(last + x)), "m"(LINE8(last2 + x)),
+                  [qt]"r"(quant_table)
+                : XMM_CLOBBERS("%xmm1", "%xmm3", "%xmm4", "%xmm5",
+                               "%xmm6", "%xmm7",) "memory"
+            );
+    }
+    __asm__ volatile("vzeroupper" ::: "memory");
+}
+
+static void context_residual_avx2(int *context, int *residual,
+                                  const int16_t *src, const int16_t *last,
+                                  const int16_t *last2,
+                                  const int16_t (*quant_table)[256],
+                                  int large, int w)
+{
+    int x;
+
+    context_top_avx2(context, last, last2, quant_table, large, w);
+
+    for (x = 0; x < w; x += 8) {
+        __asm__ volatile(
+            MASK
+            "vpmovsxwd  %2, %%ymm0                  \n\t" // LT
+            "vpmovsxwd  %3, %%ymm1                  \n\t" // T
+            "vpmovsxwd  %4, %%ymm2                  \n\t" // L
+            "vmovdqu    %0, %%ymm4                  \n\t"
+            "vpsubd     %%ymm0, %%ymm2, %%ymm3      \n\t"
+            QUANT(0, "%%ymm3", "%%ymm4")
+            "vmovdqu    %%ymm4, %0                  \n\t"
+            "vpaddd     %%ymm1, %%ymm2, %%ymm3      \n\t"
+            "vpsubd     %%ymm0, %%ymm3, %%ymm3      \n\t" // L + T - LT
+            "vpminsd    %%ymm1, %%ymm2, %%ymm4      \n\t"
+            "vpmaxsd    %%ymm1, %%ymm2, %%ymm5      \n\t"
+            "vpminsd    %%ymm3, %%ymm5, %%ymm5      \n\t"
+            "vpmaxsd    %%ymm5, %%ymm4, %%ymm4      \n\t"
+            "vpmovsxwd  %5, %%ymm5                  \n\t"
+            "vpsubd     %%ymm4, %%ymm5, %%ymm5      \n\t"
+            "vmovdqu    %%ymm5, %1                  \n\t"
+            : "+m"(*(int (*)[8])(context + x)),
+              "=m"(*(int (*)[8])(residual + x))
+            : "m"(LINE8(last + x - 1)), "m"(LINE8(last + x)),
+              "m"(LINE8(src + x - 1)), "m"(LINE8(src + x)),
+              [qt]"r"(quant_table)
+            : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                           "%xmm4", "%xmm5", "%xmm6", "%xmm7",) "memory"
+        );
+        if (large)
+            __asm__ volatile(
+                MASK
+                "vpmovsxwd  %1, %%ymm1              \n\t" // L
+                "vpmovsxwd  %2, %%ymm3              \n\t" // LL
+                "vmovdqu    %0, %%ymm4              \n\t"
+                "vpsubd     %%ymm1, %%ymm3, %%ymm3  \n\t"
+                QUANT(3, "%%ymm3", "%%ymm4")
+                "vmovdqu    %%ymm4, %0              \n\t"
+                : "+m"(*(int (*)[8])(context + x))
+                : "m"(LINE8(src + x - 1)), "m"(LINE8(src + x - 2)),
+                  [qt]"r"(quant_table)
+                : XMM_CLOBBERS("%xmm1", "%xmm3", "%xmm4", "%xmm5",
+                               "%xmm6", "%xmm7",) "memory"
+            );
+    }
+    __asm__ volatile("vzeroupper" ::: "memory");
+}
+
+#endif /* HAVE_AVX2_INLINE */
+
+av_cold void ff_ffv1dsp_init_x86(FFV1DSPContext *c)
+{
+#if HAVE_AVX2_INLINE
+    int cpu_flags = av_get_cpu_flags();
+
+    if (INLINE_AVX2(cpu_flags)) {
+        c->context_top      = context_top_avx2;
+        c->context_residual = context_residual_avx2;
+    }
+#endif
+}
@@ -23,6 +23,7 @@
  */
 
 #include "libavutil/attributes.h"
+#include "libavutil/avassert.h"
 #include "libavutil/cpu.h"
 #include "libavutil/x86/asm.h"
 #include "libavutil/x86/cpu.h"
@@ -553,6 +554,179 @@ PIX_SAD(mmx)
 
 #endif /* HAVE_INLINE_ASM */
 
+#if HAVE_AVX2_INLINE && ARCH_X86_64
+/* Accumulate the SAD of two rows of the source block in ymm0/xmm0 against
+ * one candidate; the 16 pixel wide version keeps one row per lane. */
+#define SAD16_X4_ROWS(ref, acc)                                 \
+    "vmovdqu            (%" #ref "),    %%xmm1          \n\t"   \
+    "vinserti128    $1, (%" #ref ",%7), %%ymm1, %%ymm1  \n\t"   \
+    "vpsadbw        %%ymm0, %%ymm1,     %%ymm1          \n\t"   \
+    "vpaddq         %%ymm1, %%ymm" #acc ", %%ymm" #acc " \n\t"
+
+#define SAD8_X4_ROWS(ref, acc)                                  \
+    "vmovq              (%" #ref "),    %%xmm1          \n\t"   \
+    "vmovhps            (%" #ref ",%7), %%xmm1, %%xmm1  \n\t"   \
+    "vpsadbw        %%xmm0, %%xmm1,     %%xmm1          \n\t"   \
+    "vpaddq         %%xmm1, %%xmm" #acc ", %%xmm" #acc " \n\t"
+
+#define SAD_X4_AVX2(w, load_src)                                            \
+static void sad ## w ## _x4_avx2(MpegEncContext *v, uint8_t *blk1,          \
+                                 uint8_t *const blk2[4], ptrdiff_t stride,  \
+                                 int h, int score[4])                       \
+{                                                                           \
+    uint8_t *ref0 = blk2[0], *ref1 = blk2[1];                               \
+    uint8_t *ref2 = blk2[2], *ref3 = blk2[3];                               \
+    x86_reg rows  = h;                                                      \
+                                                                            \
+    __asm__ volatile(                                                       \
+        "vpxor      %%xmm4, %%xmm4, %%xmm4          \n\t"                   \
+        "vpxor      %%xmm5, %%xmm5, %%xmm5          \n\t"                   \
+        "vpxor      %%xmm6, %%xmm6, %%xmm6          \n\t"                   \
+        "vpxor      %%xmm7, %%xmm7, %%xmm7          \n\t"                   \
+        "1:                                         \n\t"                   \
+        load_src                                                            \
+        SAD ## w ## _X4_ROWS(2, 4)                                          \
+        SAD ## w ## _X4_ROWS(3, 5)                                          \
+        SAD ## w ## _X4_ROWS(4, 6)                                          \
+        SAD ## w ## _X4_ROWS(5, 7)                                          \
+        "lea        (%1,%7,2),  %1                  \n\t"                   \
+        "lea        (%2,%7,2),  %2                  \n\t"                   \
+        "lea        (%3,%7,2),  %3                  \n\t"                   \
+        "lea        (%4,%7,2),  %4                  \n\t"                   \
+        "lea        (%5,%7,2),  %5                  \n\t"                   \
+        "sub        $2,         %6                  \n\t"                   \
+        "jg         1b                              \n\t"                   \
+        /* interleave the per candidate qword sums and fold them */         \
+        "vpsllq     $32,    %%ymm5, %%ymm5          \n\t"                   \
+        "vpsllq     $32,    %%ymm7, %%ymm7          \n\t"                   \
+        "vpor       %%ymm5, %%ymm4, %%ymm4          \n\t"                   \
+        "vpor       %%ymm7, %%ymm6, %%ymm6          \n\t"                   \
+        "vpunpckhqdq %%ymm6, %%ymm4, %%ymm5         \n\t"                   \
+        "vpunpcklqdq %%ymm6, %%ymm4, %%ymm4         \n\t"                   \
+        "vpaddd     %%ymm5, %%ymm4, %%ymm4          \n\t"                   \
+        "vextracti128 $1, %%ymm4, %%xmm5            \n\t"                   \
+        "vpaddd     %%xmm5, %%xmm4, %%xmm4          \n\t"                   \
+        "vmovdqu    %%xmm4, %0                      \n\t"                   \
+        "vzeroupper                                 \n\t"                   \
+        : "=m"(*(int (*)[4])score), "+&r"(blk1),                            \
+          "+&r"(ref0), "+&r"(ref1), "+&r"(ref2), "+&r"(ref3), "+&r"(rows)   \
+        : "r"((x86_reg)stride)                                              \
+        : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm4", "%xmm5",                  \
+                       "%xmm6", "%xmm7",) "memory"                          \
+    );                                                                      \
+}
+
+SAD_X4_AVX2(16, "vmovdqu         (%1),    %%xmm0          \n\t"
+                "vinserti128 $1, (%1,%7), %%ymm0, %%ymm0  \n\t")
+SAD_X4_AVX2(8,  "vmovq           (%1),    %%xmm0          \n\t"
+                "vmovhps         (%1,%7), %%xmm0, %%xmm0  \n\t")
+
+/* Load one row of pixel differences as words into register n; the 16 pixel
+ * wide version keeps the left 8x8 block in the low lane and the right one in
+ * the high lane, so both blocks are transformed at once. */
+#define LOAD_DIFF(x, n, t, src, dst)                            \
+    "vpmovzxbw  " src ", %%" x #n "                     \n\t"   \
+    "vpmovzxbw  " dst ", %%" x #t "                     \n\t"   \
+    "vpsubw     %%ymm" #t ", %%ymm" #n ", %%ymm" #n "   \n\t"
+
+#define SUMSUB(a, b, s, d)                                      \
+    "vpaddw     %%ymm" #b ", %%ymm" #a ", %%ymm" #s "   \n\t"   \
+    "vpsubw     %%ymm" #b ", %%ymm" #a ", %%ymm" #d "   \n\t"
+
+#define UNPACK(sz, a, b, lo, hi)                                        \
+    "vpunpckl" sz " %%ymm" #b ", %%ymm" #a ", %%ymm" #lo "      \n\t"   \
+    "vpunpckh" sz " %%ymm" #b ", %%ymm" #a ", %%ymm" #hi "      \n\t"
+
+/* last butterfly stage, |a + b| + |a - b| widened to dwords in a */
+#define SUMSUB_ABS(a, b, t)                                     \
+    "vpaddw     %%ymm" #b ", %%ymm" #a ", %%ymm" #t "   \n\t"   \
+    "vpsubw     %%ymm" #b ", %%ymm" #a ", %%ymm" #a "   \n\t"   \
+    "vpabsw     %%ymm" #t ", %%ymm" #t "                \n\t"   \
+    "vpabsw     %%ymm" #a ", %%ymm" #a "                \n\t"   \
+    "vpaddw     %%ymm" #t ", %%ymm" #a ", %%ymm" #a "   \n\t"   \
+    "vpmaddwd   %%ymm15, %%ymm" #a ", %%ymm" #a "       \n\t"
+
+#define HADAMARD8_AVX2(name, x)                                             \
+static int name(uint8_t *dst, uint8_t *src, ptrdiff_t stride)               \
+{                                                                           \
+    int sum;                                                                \
+                                                                            \
+    __asm__ volatile(                                                       \
+        LOAD_DIFF(x, 0,  8, "(%1)",       "(%2)")                           \
+        LOAD_DIFF(x, 1,  9, "(%1,%3)",    "(%2,%3)")                        \
+        LOAD_DIFF(x, 2, 10, "(%1,%3,2)",  "(%2,%3,2)")                      \
+        LOAD_DIFF(x, 3, 11, "(%1,%4)",    "(%2,%4)")                        \
+        "lea        (%1,%3,4),  %1                  \n\t"                   \
+        "lea        (%2,%3,4),  %2                  \n\t"                   \
+        LOAD_DIFF(x, 4, 12, "(%1)",       "(%2)")                           \
+        LOAD_DIFF(x, 5, 13, "(%1,%3)",    "(%2,%3)")                        \
+        LOAD_DIFF(x, 6, 14, "(%1,%3,2)",  "(%2,%3,2)")                      \
+        LOAD_DIFF(x, 7, 15, "(%1,%4)",    "(%2,%4)")                        \
+        /* vertical transform, ping-ponging between ymm0-7 and ymm8-15 */   \
+        SUMSUB(0,  1,  8,  9) SUMSUB(2,  3, 10, 11)                         \
+        SUMSUB(4,  5, 12, 13) SUMSUB(6,  7, 14, 15)                         \
+        SUMSUB(8, 10,  0,  2) SUMSUB(9, 11,  1,  3)                         \
+        SUMSUB(12, 14, 4,  6) SUMSUB(13, 15, 5,  7)                         \
+        SUMSUB(0,  4,  8, 12) SUMSUB(1,  5,  9, 13)                         \
+        SUMSUB(2,  6, 10, 14) SUMSUB(3,  7, 11, 15)                         \
+        /* transpose the 8x8 words of each lane */                          \
+        UNPACK("wd",   8,  9,  0,  1) UNPACK("wd",  10, 11,  2,  3)         \
+        UNPACK("wd",  12, 13,  4,  5) UNPACK("wd",  14, 15,  6,  7)         \
+        UNPACK("dq",   0,  2,  8,  9) UNPACK("dq",   1,  3, 10, 11)         \
+        UNPACK("dq",   4,  6, 12, 13) UNPACK("dq",   5,  7, 14, 15)         \
+        UNPACK("qdq",  8, 12,  0,  1) UNPACK("qdq",  9, 13,  2,  3)         \
+        UNPACK("qdq", 10, 14,  4,  5) UNPACK("qdq", 11, 15,  6,  7)         \
+        /* horizontal transform */                                          \
+        SUMSUB(0,  1,  8,  9) SUMSUB(2,  3, 10, 11)                         \
+        SUMSUB(4,  5, 12, 13) SUMSUB(6,  7, 14, 15)                         \
+        SUMSUB(8, 10,  0,  2) SUMSUB(9, 11,  1,  3)                         \
+        SUMSUB(12, 14, 4,  6) SUMSUB(13, 15, 5,  7)                         \
+        "vpcmpeqw   %%ymm15, %%ymm15, %%ymm15       \n\t"                   \
+        "vpsrlw     $15,     %%ymm15, %%ymm15       \n\t"                   \
+        SUMSUB_ABS(0, 4, 8) SUMSUB_ABS(1, 5, 9)                             \
+        SUMSUB_ABS(2, 6, 10) SUMSUB_ABS(3, 7, 11)                           \
+        "vpaddd     %%ymm1,  %%ymm0, %%ymm0         \n\t"                   \
+        "vpaddd     %%ymm3,  %%ymm2, %%ymm2         \n\t"                   \
+        "vpaddd     %%ymm2,  %%ymm0, %%ymm0         \n\t"                   \
+        "vextracti128 $1, %%ymm0, %%xmm1            \n\t"                   \
+        "vpaddd     %%xmm1,  %%xmm0, %%xmm0         \n\t"                   \
+        "vpshufd    $0x4e,   %%xmm0, %%xmm1         \n\t"                   \
+        "vpaddd     %%xmm1,  %%xmm0, %%xmm0         \n\t"                   \
+        "vpshufd    $0xb1,   %%xmm0, %%xmm1         \n\t"                   \
+        "vpaddd     %%xmm1,  %%xmm0, %%xmm0         \n\t"                   \
+        "vmovd      %%xmm0,  %0                     \n\t"                   \
+        "vzeroupper                                 \n\t"                   \
+        : "=r"(sum), "+&r"(src), "+&r"(dst)                                 \
+        : "r"((x86_reg)stride), "r"((x86_reg)(3 * stride))                  \
+        : XMM_CLOBBERS("%xmm0",  "%xmm1",  "%xmm2",  "%xmm3",               \
+                       "%xmm4",  "%xmm5",  "%xmm6",  "%xmm7",               \
+                       "%xmm8",  "%xmm9",  "%xmm10", "%xmm11",              \
+                       "%xmm12", "%xmm13", "%xmm14", "%xmm15",) "memory"    \
+    );                                                                      \
+    return sum;                                                             \
+}
+
+HADAMARD8_AVX2(hadamard8x8_avx2,  "xmm")
+HADAMARD8_AVX2(hadamard16x8_avx2, "ymm")
+
+static int hadamard8_diff_avx2(MpegEncContext *s, uint8_t *dst, uint8_t *src,
+                               ptrdiff_t stride, int h)
+{
+    av_assert2(h == 8);
+    return hadamard8x8_avx2(dst, src, stride);
+}
+
+static int hadamard8_diff16_avx2(MpegEncContext *s, uint8_t *dst, uint8_t *src,
+                                 ptrdiff_t stride, int h)
+{
+    int score = hadamard16x8_avx2(dst, src, stride);
+
+    if (h == 16)
+        score += hadamard16x8_avx2(dst + 8 * stride, src + 8 * stride, stride);
+    return score;
+}
+#endif /* HAVE_AVX2_INLINE && ARCH_X86_64 */
+
 av_cold void ff_me_cmp_init_x86(MECmpContext *c, AVCodecContext *avctx)
 {
     int cpu_flags = av_get_cpu_flags();
@@ -648,4 +822,13 @@ av_cold void ff_me_cmp_init_x86(MECmpContext *c, AVCodecContext *avctx)
         c->hadamard8_diff[1] = ff_hadamard8_diff_ssse3;
 #endif
     }
+
+#if HAVE_AVX2_INLINE && ARCH_X86_64
+    if (INLINE_AVX2(cpu_flags)) {
+        c->sad_x4[0]         = sad16_x4_avx2;
+        c->sad_x4[1]         = sad8_x4_avx2;
+        c->hadamard8_diff[0] = hadamard8_diff16_avx2;
+        c->hadamard8_diff[1] = hadamard8_diff_avx2;
+    }
+#endif
 }
@@ -36,6 +36,7 @@ DECLARE_ALIGNED(16, static uint16_t, inv_zigzag_direct16)[64];
 #define COMPILE_TEMPLATE_MMXEXT 0
 #define COMPILE_TEMPLATE_SSE2   0
 #define COMPILE_TEMPLATE_SSSE3  0
+#define COMPILE_TEMPLATE_AVX2   0
 #define RENAME(a)      a ## _mmx
 #define RENAME_FDCT(a) a ## _mmx
 #include "mpegvideoenc_template.c"
@@ -43,11 +44,13 @@ DECLARE_ALIGNED(16, static uint16_t, inv_zigzag_direct16)[64];
 
 #if HAVE_MMXEXT_INLINE
 #undef COMPILE_TEMPLATE_SSSE3
+#undef COMPILE_TEMPLATE_AVX2
 #undef COMPILE_TEMPLATE_SSE2
 #undef COMPILE_TEMPLATE_MMXEXT
 #define COMPILE_TEMPLATE_MMXEXT 1
 #define COMPILE_TEMPLATE_SSE2   0
 #define COMPILE_TEMPLATE_SSSE3  0
+#define COMPILE_TEMPLATE_AVX2   0
 #undef RENAME
 #undef RENAME_FDCT
 #define RENAME(a)      a ## _mmxext
@@ -59,9 +62,11 @@ DECLARE_ALIGNED(16, static uint16_t, inv_zigzag_direct16)[64];
 #undef COMPILE_TEMPLATE_MMXEXT
 #undef COMPILE_TEMPLATE_SSE2
 #undef COMPILE_TEMPLATE_SSSE3
+#undef COMPILE_TEMPLATE_AVX2
 #define COMPILE_TEMPLATE_MMXEXT 0
 #define COMPILE_TEMPLATE_SSE2   1
 #define COMPILE_TEMPLATE_SSSE3  0
+#define COMPILE_TEMPLATE_AVX2   0
 #undef RENAME
 #undef RENAME_FDCT
 #define RENAME(a)      a ## _sse2
@@ -73,9 +78,11 @@ DECLARE_ALIGNED(16, static uint16_t, inv_zigzag_direct16)[64];
 #undef COMPILE_TEMPLATE_MMXEXT
 #undef COMPILE_TEMPLATE_SSE2
 #undef COMPILE_TEMPLATE_SSSE3
+#undef COMPILE_TEMPLATE_AVX2
 #define COMPILE_TEMPLATE_MMXEXT 0
 #define COMPILE_TEMPLATE_SSE2   1
 #define COMPILE_TEMPLATE_SSSE3  1
+#define COMPILE_TEMPLATE_AVX2   0
 #undef RENAME
 #undef RENAME_FDCT
 #define RENAME(a)      a ## _ssse3
@@ -83,6 +90,22 @@ DECLARE_ALIGNED(16, static uint16_t, inv_zigzag_direct16)[64];
 #include "mpegvideoenc_template.c"
 #endif /* HAVE_SSSE3_INLINE */
 
+#if HAVE_AVX2_INLINE
+#undef COMPILE_TEMPLATE_MMXEXT
+#undef COMPILE_TEMPLATE_SSE2
+#undef COMPILE_TEMPLATE_SSSE3
+#undef COMPILE_TEMPLATE_AVX2
+#define COMPILE_TEMPLATE_MMXEXT 0
+#define COMPILE_TEMPLATE_SSE2   1
+#define COMPILE_TEMPLATE_SSSE3  1
+#define COMPILE_TEMPLATE_AVX2   1
+#undef RENAME
+#undef RENAME_FDCT
+#define RENAME(a)      a ## _avx2
+#define RENAME_FDCT(a) a ## _avx2
+#include "mpegvideoenc_template.c"
+#endif /* HAVE_AVX2_INLINE */
+
 #endif /* HAVE_6REGS */
 
 #if HAVE_INLINE_ASM
@@ -230,6 +253,10 @@ av_cold void ff_dct_encode_init_x86(MpegEncContext *s)
 #if HAVE_6REGS && HAVE_SSSE3_INLINE
         if (INLINE_SSSE3(cpu_flags))
             s->dct_quantize = dct_quantize_ssse3;
+#endif
+#if HAVE_6REGS && HAVE_AVX2_INLINE
+        if (INLINE_AVX2(cpu_flags))
+            s->dct_quantize = dct_quantize_avx2;
 #endif
     }
 }
@@ -35,6 +35,7 @@
 #undef PMAX
 #undef SAVE_SIGN
 #undef RESTORE_SIGN
+#undef PMAX_AVX2
 
 #if COMPILE_TEMPLATE_SSE2
 #define MMREG_WIDTH "16"
@@ -81,6 +82,18 @@
 #endif
 #endif
 
+#if COMPILE_TEMPLATE_AVX2
+#define PMAX_AVX2 \
+            "vextracti128 $1, %%ymm3, %%xmm0            \n\t"\
+            "vpmaxsw %%xmm0, %%xmm3, %%xmm3             \n\t"\
+            "vpshufd $0x0E, %%xmm3, %%xmm0              \n\t"\
+            "vpmaxsw %%xmm0, %%xmm3, %%xmm3             \n\t"\
+            "vpshuflw $0x0E, %%xmm3, %%xmm0             \n\t"\
+            "vpmaxsw %%xmm0, %%xmm3, %%xmm3             \n\t"\
+            "vpshuflw $0x01, %%xmm3, %%xmm0             \n\t"\
+            "vpmaxsw %%xmm0, %%xmm3, %%xmm3             \n\t"
+#endif
+
 #if COMPILE_TEMPLATE_SSSE3
 #define SAVE_SIGN(a,b) \
             "movdqa "b", "a"            \n\t"\
@@ -148,6 +161,45 @@ static int RENAME(dct_quantize)(MpegEncContext *s,
 
     if((s->out_format == FMT_H263 || s->out_format == FMT_H261) && s->mpeg_quant==0){
 
+#if COMPILE_TEMPLATE_AVX2
+        __asm__ volatile(
+            "vmovd %%eax, %%xmm3                        \n\t" // last_non_zero_p1
+            "vpbroadcastw %%xmm3, %%ymm3                \n\t"
+            "vpxor %%ymm7, %%ymm7, %%ymm7               \n\t" // 0
+            "vpxor %%ymm4, %%ymm4, %%ymm4               \n\t" // 0
+            "vbroadcasti128 (%2), %%ymm5                \n\t" // qmat[0]
+            "vbroadcasti128 (%3), %%ymm6                \n\t"
+            "vpsubw %%ymm6, %%ymm7, %%ymm6              \n\t" // -bias[0]
+            "mov $-128, %%"REG_a"                       \n\t"
+            ".p2align 4                                 \n\t"
+            "1:                                         \n\t"
+            "vmovdqu (%1, %%"REG_a"), %%ymm0            \n\t" // block[i]
+            "vpabsw %%ymm0, %%ymm1                      \n\t" // ABS(block[i])
+            "vpsubusw %%ymm6, %%ymm1, %%ymm1            \n\t" // ABS(block[i]) + bias[0]
+            "vpmulhw %%ymm5, %%ymm1, %%ymm1             \n\t" // (ABS(block[i])*qmat[0] - bias[0]*qmat[0])>>16
+            "vpor %%ymm1, %%ymm4, %%ymm4                \n\t"
+            "vpsignw %%ymm0, %%ymm1, %%ymm1             \n\t" // out=((ABS(block[i])*qmat[0] - bias[0]*qmat[0])>>16)*sign(block[i])
+            "vmovdqu %%ymm1, (%5, %%"REG_a")            \n\t"
+            "vpcmpeqw %%ymm7, %%ymm1, %%ymm1            \n\t" // out==0 ? 0xFF : 0x00
+            "vmovdqu (%4, %%"REG_a"), %%ymm0            \n\t"
+            "vmovdqu %%ymm7, (%1, %%"REG_a")            \n\t" // 0
+            "vpandn %%ymm0, %%ymm1, %%ymm1              \n\t"
+            "vpmaxsw %%ymm1, %%ymm3, %%ymm3             \n\t"
+            "add $32, %%"REG_a"                         \n\t"
+            " js 1b                                     \n\t"
+            PMAX_AVX2
+            "vextracti128 $1, %%ymm4, %%xmm0            \n\t"
+            "vpor %%xmm0, %%xmm4, %%xmm4                \n\t" // for the overflow check below
+            "vzeroupper                                 \n\t"
+            "vmovd %%xmm3, %%eax                        \n\t"
+            "movzbl %%al, %%eax                         \n\t" // last_non_zero_p1
+            : "+a" (last_non_zero_p1)
+            : "r" (block+64), "r" (qmat), "r" (bias),
+              "r" (inv_zigzag_direct16 + 64), "r" (temp_block + 64)
+              XMM_CLOBBERS_ONLY("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                                "%xmm4", "%xmm5", "%xmm6", "%xmm7")
+        );
+#else
         __asm__ volatile(
             "movd %%"REG_a", "MM"3              \n\t" // last_non_zero_p1
             SPREADW(MM"3")
@@ -182,7 +234,46 @@ static int RENAME(dct_quantize)(MpegEncContext *s,
               XMM_CLOBBERS_ONLY("%xmm0", "%xmm1", "%xmm2", "%xmm3",
                                 "%xmm4", "%xmm5", "%xmm6", "%xmm7")
         );
+#endif
     }else{ // FMT_H263
+#if COMPILE_TEMPLATE_AVX2
+        __asm__ volatile(
+            "vmovd %%eax, %%xmm3                        \n\t" // last_non_zero_p1
+            "vpbroadcastw %%xmm3, %%ymm3                \n\t"
+            "vpxor %%ymm7, %%ymm7, %%ymm7               \n\t" // 0
+            "vpxor %%ymm4, %%ymm4, %%ymm4               \n\t" // 0
+            "mov $-128, %%"REG_a"                       \n\t"
+            ".p2align 4                                 \n\t"
+            "1:                                         \n\t"
+            "vmovdqu (%1, %%"REG_a"), %%ymm0            \n\t" // block[i]
+            "vpabsw %%ymm0, %%ymm1                      \n\t" // ABS(block[i])
+            "vmovdqu (%3, %%"REG_a"), %%ymm6            \n\t" // bias[0]
+            "vpaddusw %%ymm6, %%ymm1, %%ymm1            \n\t" // ABS(block[i]) + bias[0]
+            "vmovdqu (%2, %%"REG_a"), %%ymm5            \n\t" // qmat[i]
+            "vpmulhw %%ymm5, %%ymm1, %%ymm1             \n\t" // (ABS(block[i])*qmat[0] + bias[0]*qmat[0])>>16
+            "vpor %%ymm1, %%ymm4, %%ymm4                \n\t"
+            "vpsignw %%ymm0, %%ymm1, %%ymm1             \n\t" // out=((ABS(block[i])*qmat[0] - bias[0]*qmat[0])>>16)*sign(block[i])
+            "vmovdqu %%ymm1, (%5, %%"REG_a")            \n\t"
+            "vpcmpeqw %%ymm7, %%ymm1, %%ymm1            \n\t" // out==0 ? 0xFF : 0x00
+            "vmovdqu (%4, %%"REG_a"), %%ymm0            \n\t"
+            "vmovdqu %%ymm7, (%1, %%"REG_a")            \n\t" // 0
+            "vpandn %%ymm0, %%ymm1, %%ymm1              \n\t"
+            "vpmaxsw %%ymm1, %%ymm3, %%ymm3             \n\t"
+            "add $32, %%"REG_a"                         \n\t"
+            " js 1b                                     \n\t"
+            PMAX_AVX2
+            "vextracti128 $1, %%ymm4, %%xmm0            \n\t"
+            "vpor %%xmm0, %%xmm4, %%xmm4                \n\t" // for the overflow check below
+            "vzeroupper                                 \n\t"
+            "vmovd %%xmm3, %%eax                        \n\t"
+            "movzbl %%al, %%eax                         \n\t" // last_non_zero_p1
+            : "+a" (last_non_zero_p1)
+            : "r" (block+64), "r" (qmat+64), "r" (bias+64),
+              "r" (inv_zigzag_direct16 + 64), "r" (temp_block + 64)
+              XMM_CLOBBERS_ONLY("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                                "%xmm4", "%xmm5", "%xmm6", "%xmm7")
+        );
+#else
         __asm__ volatile(
             "movd %%"REG_a", "MM"3              \n\t" // last_non_zero_p1
             SPREADW(MM"3")
@@ -216,6 +307,7 @@ static int RENAME(dct_quantize)(MpegEncContext *s,
               XMM_CLOBBERS_ONLY("%xmm0", "%xmm1", "%xmm2", "%xmm3",
                                 "%xmm4", "%xmm5", "%xmm6", "%xmm7")
         );
+#endif
     }
     __asm__ volatile(
         "movd %1, "MM"1                     \n\t" // max_qcoeff
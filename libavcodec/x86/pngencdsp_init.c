@@ -0,0 +1,172 @@
+/*
+ * PNG encoder SIMD functions
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdlib.h>
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/asm.h"
+#include "libavutil/x86/cpu.h"
+#include "libavcodec/pngencdsp.h"
+
+#if HAVE_SSE2_INLINE
+
+static void sub_avg_prediction_sse2(uint8_t *dst, const uint8_t *src,
+                                    const uint8_t *top, int w, int bpp)
+{
+    const int len = w & ~15;
+    x86_reg i     = -len;
+
+    if (len) {
+        __asm__ volatile(
+            "pcmpeqb    %%xmm7, %%xmm7          \n\t"
+            "pxor       %%xmm6, %%xmm6          \n\t"
+            "psubb      %%xmm7, %%xmm6          \n\t" // pb_1
+            "1:                                 \n\t"
+            "movdqu     (%1, %0), %%xmm0        \n\t" // left
+            "movdqu     (%2, %0), %%xmm1        \n\t" // top
+            "movdqa     %%xmm0, %%xmm2          \n\t"
+            "pxor       %%xmm1, %%xmm2          \n\t"
+            "pand       %%xmm6, %%xmm2          \n\t"
+            "pavgb      %%xmm1, %%xmm0          \n\t"
+            "psubb      %%xmm2, %%xmm0          \n\t" // (left + top) >> 1
+            "movdqu     (%3, %0), %%xmm1        \n\t"
+            "psubb      %%xmm0, %%xmm1          \n\t"
+            "movdqu     %%xmm1, (%4, %0)        \n\t"
+            "add        $16, %0                 \n\t"
+            "jl         1b                      \n\t"
+            : "+r"(i)
+            : "r"(src + len - bpp), "r"(top + len), "r"(src + len), "r"(dst + len)
+            : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm6", "%xmm7",) "memory"
+        );
+    }
+    for (i = len; i < w; i++)
+        dst[i] = src[i] - ((src[i - bpp] + top[i]) >> 1);
+}
+
+static int filter_cost_sse2(const uint8_t *buf, int size)
+{
+    const int len = size & ~15;
+    x86_reg i     = -len;
+    int cost      = 0;
+
+    if (len) {
+        __asm__ volatile(
+            "pxor       %%xmm4, %%xmm4          \n\t"
+            "pxor       %%xmm5, %%xmm5          \n\t"
+            "1:                                 \n\t"
+            "movdqu     (%2, %0), %%xmm0        \n\t"
+            "pxor       %%xmm1, %%xmm1          \n\t"
+            "psubb      %%xmm0, %%xmm1          \n\t"
+            "pminub     %%xmm1, %%xmm0          \n\t" // abs as unsigned
+            "psadbw     %%xmm4, %%xmm0          \n\t"
+            "paddq      %%xmm0, %%xmm5          \n\t"
+            "add        $16, %0                 \n\t"
+            "jl         1b                      \n\t"
+            "pshufd     $0xee, %%xmm5, %%xmm0   \n\t"
+            "paddq      %%xmm0, %%xmm5          \n\t"
+            "movd       %%xmm5, %1              \n\t"
+            : "+r"(i), "=&r"(cost)
+            : "r"(buf + len)
+            : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm4", "%xmm5",) "memory"
+        );
+    }
+    for (i = len; i < size; i++)
+        cost += abs((int8_t) buf[i]);
+    return cost;
+}
+
+#if HAVE_6REGS
+static void sub_paeth_prediction_sse2(uint8_t *dst, const uint8_t *src,
+                                      const uint8_t *top, int w, int bpp)
+{
+    const int len = w & ~7;
+    x86_reg i     = -len;
+
+    if (len) {
+        __asm__ volatile(
+            "pxor       %%xmm7, %%xmm7          \n\t"
+            "1:                                 \n\t"
+            "movq       (%1, %0), %%xmm0        \n\t" // a
+            "movq       (%2, %0), %%xmm1        \n\t" // b
+            "movq       (%3, %0), %%xmm2        \n\t" // c
+            "punpcklbw  %%xmm7, %%xmm0          \n\t"
+            "punpcklbw  %%xmm7, %%xmm1          \n\t"
+            "punpcklbw  %%xmm7, %%xmm2          \n\t"
+            "movdqa     %%xmm1, %%xmm3          \n\t"
+            "psubw      %%xmm2, %%xmm3          \n\t" // p  = b - c
+            "movdqa     %%xmm0, %%xmm4          \n\t"
+            "psubw      %%xmm2, %%xmm4          \n\t" // pc = a - c
+            "movdqa     %%xmm3, %%xmm5          \n\t"
+            "paddw      %%xmm4, %%xmm5          \n\t" // p + pc
+            "pxor       %%xmm6, %%xmm6          \n\t"
+            "psubw      %%xmm3, %%xmm6          \n\t"
+            "pmaxsw     %%xmm6, %%xmm3          \n\t" // pa
+            "pxor       %%xmm6, %%xmm6          \n\t"
+            "psubw      %%xmm4, %%xmm6          \n\t"
+            "pmaxsw     %%xmm6, %%xmm4          \n\t" // pb
+            "pxor       %%xmm6, %%xmm6          \n\t"
+            "psubw      %%xmm5, %%xmm6          \n\t"
+            "pmaxsw     %%xmm6, %%xmm5          \n\t" // pc
+            "movdqa     %%xmm3, %%xmm6          \n\t"
+            "pcmpgtw    %%xmm4, %%xmm6          \n\t" // pa > pb
+            "pcmpgtw    %%xmm5, %%xmm3          \n\t" // pa > pc
+            "por        %%xmm6, %%xmm3          \n\t"
+            "pcmpgtw    %%xmm5, %%xmm4          \n\t" // pb > pc
+            "pxor       %%xmm1, %%xmm2          \n\t"
+            "pand       %%xmm4, %%xmm2          \n\t"
+            "pxor       %%xmm1, %%xmm2          \n\t" // pb > pc ? c : b
+            "pxor       %%xmm0, %%xmm2          \n\t"
+            "pand       %%xmm3, %%xmm2          \n\t"
+            "pxor       %%xmm0, %%xmm2          \n\t" // prediction
+            "packuswb   %%xmm2, %%xmm2          \n\t"
+            "movq       (%4, %0), %%xmm0        \n\t"
+            "psubb      %%xmm2, %%xmm0          \n\t"
+            "movq       %%xmm0, (%5, %0)        \n\t"
+            "add        $8, %0                  \n\t"
+            "jl         1b                      \n\t"
+            : "+r"(i)
+            : "r"(src + len - bpp), "r"(top + len), "r"(top + len - bpp),
+              "r"(src + len), "r"(dst + len)
+            : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                           "%xmm4", "%xmm5", "%xmm6", "%xmm7",) "memory"
+        );
+    }
+    ff_sub_png_paeth_prediction(dst + len, src + len, top + len, w - len, bpp);
+}
+#endif /* HAVE_6REGS */
+
+#endif /* HAVE_SSE2_INLINE */
+
+av_cold void ff_pngencdsp_init_x86(PNGEncDSPContext *c)
+{
+#if HAVE_SSE2_INLINE
+    int cpu_flags = av_get_cpu_flags();
+
+    if (INLINE_SSE2(cpu_flags)) {
+        c->sub_avg_prediction   = sub_avg_prediction_sse2;
+        c->filter_cost          = filter_cost_sse2;
+#if HAVE_6REGS
+        c->sub_paeth_prediction = sub_paeth_prediction_sse2;
+#endif
+    }
+#endif /* HAVE_SSE2_INLINE */
+}
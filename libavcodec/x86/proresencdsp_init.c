@@ -0,0 +1,292 @@
+/*
+ * Apple ProRes encoder SIMD functions
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+#include "libavutil/x86/asm.h"
+#include "libavutil/x86/cpu.h"
+#include "libavcodec/proresencdsp.h"
+
+#if HAVE_SSE2_INLINE
+
+/*
+ * The 10-bit islow DCT (jfdctint_template.c with CONST_BITS 13 and
+ * PASS1_BITS 1) evaluated with pmaddwd. Every output is rewritten as a
+ * linear combination of the butterfly terms so that all products and
+ * sums are exact in 32 bits, which keeps the result bit-exact with C.
+ */
+
+#define PAIR(a, b) { a, b, a, b, a, b, a, b }
+
+/* pairs for (t0,t3)/(t1,t2) in the even part, (t4,t5)/(t6,t7) in the odd */
+DECLARE_ALIGNED(16, static const int16_t, fdct_coeffs)[11][8] = {
+    PAIR( 10703, -10703), PAIR(  4433,  -4433), PAIR(-10704,  10704),
+    PAIR(  2260,   6437), PAIR(  9633,  11363),     /* out1 */
+    PAIR( -6436, -11362), PAIR( -2259,   9633),     /* out3 */
+    PAIR(  9633,   2261), PAIR(-11362,   6437),     /* out5 */
+    PAIR(-11363,   9633), PAIR( -6436,   2260),     /* out7 */
+};
+
+typedef struct FDCTPass {
+    int16_t even_sum[8];    ///< pairs for outputs 0 and 4
+    int16_t even_diff[8];
+    int32_t round_04[4];    ///< descaling of outputs 0 and 4
+    int32_t round[4];       ///< descaling of the other outputs
+    int64_t shift_04[2];
+    int64_t shift[2];
+} FDCTPass;
+
+DECLARE_ALIGNED(16, static const FDCTPass, fdct_passes)[2] = {
+    { /* rows: scale by 2^PASS1_BITS, descale by CONST_BITS - PASS1_BITS */
+        PAIR(2, 2), PAIR(-2, -2),
+        { 0, 0, 0, 0 }, { 1 << 11, 1 << 11, 1 << 11, 1 << 11 },
+        { 0, 0 }, { 12, 0 },
+    },
+    { /* columns: descale by OUT_SHIFT and CONST_BITS + OUT_SHIFT */
+        PAIR(1, 1), PAIR(-1, -1),
+        { 2, 2, 2, 2 }, { 1 << 14, 1 << 14, 1 << 14, 1 << 14 },
+        { 2, 0 }, { 15, 0 },
+    },
+};
+
+static void transpose8x8_sse2(int16_t *dst, const void *src,
+                              x86_reg stride)
+{
+#define TRANSPOSE_LOAD(lo, hi)                                  \
+    "movdqu     (%0),        %%xmm0         \n\t"               \
+    "movdqu     (%0, %2),    %%xmm1         \n\t"               \
+    "lea        (%0, %2, 2), %0             \n\t"               \
+    "movdqa     %%xmm0,      %%xmm2         \n\t"               \
+    "punpcklwd  %%xmm1,      %%xmm0         \n\t"               \
+    "punpckhwd  %%xmm1,      %%xmm2         \n\t"               \
+    "movdqa     %%xmm0,      "#lo"(%1)      \n\t"               \
+    "movdqa     %%xmm2,      "#hi"(%1)      \n\t"
+#define TRANSPOSE_HALF(off)                                     \
+    "movdqa     "#off"+0x00(%1), %%xmm0     \n\t"               \
+    "movdqa     "#off"+0x10(%1), %%xmm1     \n\t"               \
+    "movdqa     "#off"+0x20(%1), %%xmm2     \n\t"               \
+    "movdqa     "#off"+0x30(%1), %%xmm3     \n\t"               \
+    "movdqa     %%xmm0,      %%xmm4         \n\t"               \
+    "punpckldq  %%xmm1,      %%xmm0         \n\t"               \
+    "punpckhdq  %%xmm1,      %%xmm4         \n\t"               \
+    "movdqa     %%xmm2,      %%xmm5         \n\t"               \
+    "punpckldq  %%xmm3,      %%xmm2         \n\t"               \
+    "punpckhdq  %%xmm3,      %%xmm5         \n\t"               \
+    "movdqa     %%xmm0,      %%xmm6         \n\t"               \
+    "punpcklqdq %%xmm2,      %%xmm0         \n\t"               \
+    "punpckhqdq %%xmm2,      %%xmm6         \n\t"               \
+    "movdqa     %%xmm4,      %%xmm7         \n\t"               \
+    "punpcklqdq %%xmm5,      %%xmm4         \n\t"               \
+    "punpckhqdq %%xmm5,      %%xmm7         \n\t"               \
+    "movdqa     %%xmm0,      "#off"+0x00(%1)\n\t"               \
+    "movdqa     %%xmm6,      "#off"+0x10(%1)\n\t"               \
+    "movdqa     %%xmm4,      "#off"+0x20(%1)\n\t"               \
+    "movdqa     %%xmm7,      "#off"+0x30(%1)\n\t"
+
+    __asm__ volatile(
+        /* interleave row pairs; the low halves go to the first four
+         * vectors and the high halves to the last four */
+        TRANSPOSE_LOAD(0x00, 0x40)
+        TRANSPOSE_LOAD(0x10, 0x50)
+        TRANSPOSE_LOAD(0x20, 0x60)
+        TRANSPOSE_LOAD(0x30, 0x70)
+        TRANSPOSE_HALF(0x00)
+        TRANSPOSE_HALF(0x40)
+        : "+r"(src)
+        : "r"(dst), "r"(stride)
+        : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                       "%xmm4", "%xmm5", "%xmm6", "%xmm7",) "memory"
+    );
+#undef TRANSPOSE_LOAD
+#undef TRANSPOSE_HALF
+}
+
+/* one 1-D DCT on eight vectors, transforming across the vectors */
+static void fdct_pass_sse2(int16_t *dst, const int16_t *src,
+                           const FDCTPass *pass)
+{
+#define FDCT_BUTTERFLY(op, a, b, c, d, e, f, g, h)              \
+    "movdqa     "#a"(%1),    %%xmm0         \n\t"               \
+    "movdqa     "#c"(%1),    %%xmm1         \n\t"               \
+    "movdqa     "#e"(%1),    %%xmm2         \n\t"               \
+    "movdqa     "#g"(%1),    %%xmm3         \n\t"               \
+    op"         "#b"(%1),    %%xmm0         \n\t"               \
+    op"         "#d"(%1),    %%xmm1         \n\t"               \
+    op"         "#f"(%1),    %%xmm2         \n\t"               \
+    op"         "#h"(%1),    %%xmm3         \n\t"               \
+    "movdqa     %%xmm0,      %%xmm4         \n\t"               \
+    "punpcklwd  %%xmm1,      %%xmm0         \n\t"               \
+    "punpckhwd  %%xmm1,      %%xmm4         \n\t"               \
+    "movdqa     %%xmm2,      %%xmm5         \n\t"               \
+    "punpcklwd  %%xmm3,      %%xmm2         \n\t"               \
+    "punpckhwd  %%xmm3,      %%xmm5         \n\t"
+#define FDCT_OUT(c0, c1, rnd, shift, out)                       \
+    "movdqa     %%xmm0,      %%xmm1         \n\t"               \
+    "movdqa     %%xmm2,      %%xmm3         \n\t"               \
+    "movdqa     %%xmm4,      %%xmm6         \n\t"               \
+    "movdqa     %%xmm5,      %%xmm7         \n\t"               \
+    "pmaddwd    "c0",        %%xmm1         \n\t"               \
+    "pmaddwd    "c1",        %%xmm3         \n\t"               \
+    "pmaddwd    "c0",        %%xmm6         \n\t"               \
+    "pmaddwd    "c1",        %%xmm7         \n\t"               \
+    "paddd      %%xmm3,      %%xmm1         \n\t"               \
+    "paddd      %%xmm7,      %%xmm6         \n\t"               \
+    "paddd      "rnd"(%2),   %%xmm1         \n\t"               \
+    "paddd      "rnd"(%2),   %%xmm6         \n\t"               \
+    "psrad      "shift"(%2), %%xmm1         \n\t"               \
+    "psrad      "shift"(%2), %%xmm6         \n\t"               \
+    "packssdw   %%xmm6,      %%xmm1         \n\t"               \
+    "movdqa     %%xmm1,      "#out"(%0)     \n\t"
+
+    __asm__ volatile(
+        /* even part: (t0,t3) and (t1,t2) */
+        FDCT_BUTTERFLY("paddw", 0x00, 0x70, 0x30, 0x40, 0x10, 0x60, 0x20, 0x50)
+        FDCT_OUT("0x00(%2)",  "0x00(%2)",  "0x20", "0x40", 0x00)
+        FDCT_OUT("0x00(%2)",  "0x10(%2)",  "0x20", "0x40", 0x40)
+        FDCT_OUT("0x00(%3)",  "0x10(%3)",  "0x30", "0x50", 0x20)
+        FDCT_OUT("0x10(%3)",  "0x20(%3)",  "0x30", "0x50", 0x60)
+        /* odd part: (t4,t5) and (t6,t7) */
+        FDCT_BUTTERFLY("psubw", 0x30, 0x40, 0x20, 0x50, 0x10, 0x60, 0x00, 0x70)
+        FDCT_OUT("0x30(%3)",  "0x40(%3)",  "0x30", "0x50", 0x10)
+        FDCT_OUT("0x50(%3)",  "0x60(%3)",  "0x30", "0x50", 0x30)
+        FDCT_OUT("0x70(%3)",  "0x80(%3)",  "0x30", "0x50", 0x50)
+        FDCT_OUT("0x90(%3)",  "0xa0(%3)",  "0x30", "0x50", 0x70)
+        :
+        : "r"(dst), "r"(src), "r"(pass), "r"(fdct_coeffs)
+        : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                       "%xmm4", "%xmm5", "%xmm6", "%xmm7",) "memory"
+    );
+#undef FDCT_BUTTERFLY
+#undef FDCT_OUT
+}
+
+static void prores_fdct_sse2(const uint16_t *src, ptrdiff_t linesize,
+                             int16_t *block)
+{
+    LOCAL_ALIGNED_16(int16_t, tmp, [64]);
+
+    transpose8x8_sse2(tmp, src, linesize);
+    fdct_pass_sse2(block, tmp, &fdct_passes[0]);
+    transpose8x8_sse2(tmp, block, 16);
+    fdct_pass_sse2(block, tmp, &fdct_passes[1]);
+}
+
+/*
+ * The division is done in single precision: for |c| < 2^24 truncating
+ * the correctly rounded quotient gives the exact integer quotient.
+ */
+static int quant_ac_sse2(int16_t *levels, uint32_t *nz, const int16_t *coeffs,
+                         const int16_t *qmat, const uint8_t *scan,
+                         int blocks_per_slice)
+{
+    int i, error = 0;
+
+    if (blocks_per_slice & 7)
+        return ff_prores_quant_ac(levels, nz, coeffs, qmat, scan,
+                                  blocks_per_slice);
+
+    for (i = 1; i < 64; i++) {
+        x86_reg off = 2 * blocks_per_slice - 16;
+        int q       = qmat[scan[i]];
+        int mask, err;
+
+        coeffs += blocks_per_slice;
+        levels += blocks_per_slice;
+
+        /* the mask is built from the last 8 blocks down to the first */
+        __asm__ volatile(
+            "movd       %3,      %%xmm6         \n\t"
+            "cvtsi2ssl  %3,      %%xmm5         \n\t"
+            "pshuflw    $0, %%xmm6, %%xmm6      \n\t"
+            "punpcklqdq %%xmm6,  %%xmm6         \n\t"
+            "shufps     $0, %%xmm5, %%xmm5      \n\t"
+            "pxor       %%xmm7,  %%xmm7         \n\t"
+            "pxor       %%xmm4,  %%xmm4         \n\t"
+            "xor        %0,      %0             \n\t"
+            "1:                                 \n\t"
+            "movdqa     (%4, %2), %%xmm0        \n\t"
+            "movdqa     %%xmm0,  %%xmm3         \n\t"
+            "psraw      $15,     %%xmm3         \n\t"
+            "pxor       %%xmm3,  %%xmm0         \n\t"
+            "psubw      %%xmm3,  %%xmm0         \n\t" // |c|
+            "movdqa     %%xmm0,  %%xmm2         \n\t"
+            "movdqa     %%xmm0,  %%xmm1         \n\t"
+            "punpcklwd  %%xmm7,  %%xmm0         \n\t"
+            "punpckhwd  %%xmm7,  %%xmm1         \n\t"
+            "cvtdq2ps   %%xmm0,  %%xmm0         \n\t"
+            "cvtdq2ps   %%xmm1,  %%xmm1         \n\t"
+            "divps      %%xmm5,  %%xmm0         \n\t"
+            "divps      %%xmm5,  %%xmm1         \n\t"
+            "cvttps2dq  %%xmm0,  %%xmm0         \n\t"
+            "cvttps2dq  %%xmm1,  %%xmm1         \n\t"
+            "packssdw   %%xmm1,  %%xmm0         \n\t" // |c| / q
+            "movdqa     %%xmm0,  %%xmm1         \n\t"
+            "pmullw     %%xmm6,  %%xmm1         \n\t"
+            "psubw      %%xmm1,  %%xmm2         \n\t" // |c| % q
+            "movdqa     %%xmm2,  %%xmm1         \n\t"
+            "punpcklwd  %%xmm7,  %%xmm2         \n\t"
+            "punpckhwd  %%xmm7,  %%xmm1         \n\t"
+            "paddd      %%xmm2,  %%xmm4         \n\t"
+            "paddd      %%xmm1,  %%xmm4         \n\t"
+            "pxor       %%xmm3,  %%xmm0         \n\t"
+            "psubw      %%xmm3,  %%xmm0         \n\t"
+            "movdqa     %%xmm0,  (%5, %2)       \n\t"
+            "pcmpeqw    %%xmm7,  %%xmm0         \n\t"
+            "packsswb   %%xmm0,  %%xmm0         \n\t"
+            "pmovmskb   %%xmm0,  %1             \n\t"
+            "shl        $8,      %0             \n\t"
+            "not        %1                      \n\t"
+            "and        $0xff,   %1             \n\t"
+            "or         %1,      %0             \n\t"
+            "sub        $16,     %2             \n\t"
+            "jge        1b                      \n\t"
+            "pshufd     $0x4e, %%xmm4, %%xmm1   \n\t"
+            "paddd      %%xmm1,  %%xmm4         \n\t"
+            "pshufd     $0xb1, %%xmm4, %%xmm1   \n\t"
+            "paddd      %%xmm1,  %%xmm4         \n\t"
+            "movd       %%xmm4,  %1             \n\t"
+            : "=&r"(mask), "=&r"(err), "+r"(off)
+            : "m"(q), "r"(coeffs), "r"(levels)
+            : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                           "%xmm4", "%xmm5", "%xmm6", "%xmm7",) "memory"
+        );
+        nz[i]  = mask;
+        error += err;
+    }
+
+    return error;
+}
+
+#endif /* HAVE_SSE2_INLINE */
+
+av_cold void ff_proresencdsp_init_x86(ProresEncDSPContext *c)
+{
+#if HAVE_SSE2_INLINE
+    int cpu_flags = av_get_cpu_flags();
+
+    if (INLINE_SSE2(cpu_flags)) {
+        c->fdct     = prores_fdct_sse2;
+        c->quant_ac = quant_ac_sse2;
+    }
+#endif /* HAVE_SSE2_INLINE */
+}
@@ -295,12 +295,23 @@ static int output_frame(AVFilterLink *outlink, int nb_samples)
 
             planes     = s->planar ? s->nb_channels : 1;
             plane_size = nb_samples * (s->planar ? 1 : s->nb_channels);
-            plane_size = FFALIGN(plane_size, 16);
 
-            for (p = 0; p < planes; p++) {
-                s->fdsp->vector_fmac_scalar((float *)out_buf->extended_data[p],
-                                           (float *) in_buf->extended_data[p],
-                                           s->input_scale[i], plane_size);
+            if (av_get_packed_sample_fmt(outlink->format) == AV_SAMPLE_FMT_DBL) {
+                plane_size = FFALIGN(plane_size, 8);
+
+                for (p = 0; p < planes; p++) {
+                    s->fdsp->vector_dmac_scalar((double *)out_buf->extended_data[p],
+                                                (double *) in_buf->extended_data[p],
+                                                s->input_scale[i], plane_size);
+                }
+            } else {
+                plane_size = FFALIGN(plane_size, 16);
+
+                for (p = 0; p < planes; p++) {
+                    s->fdsp->vector_fmac_scalar((float *)out_buf->extended_data[p],
+                                               (float *) in_buf->extended_data[p],
+                                               s->input_scale[i], plane_size);
+                }
             }
         }
     }
@@ -543,6 +554,8 @@ static int query_formats(AVFilterContext *ctx)
 
     ff_add_format(&formats, AV_SAMPLE_FMT_FLT);
     ff_add_format(&formats, AV_SAMPLE_FMT_FLTP);
+    ff_add_format(&formats, AV_SAMPLE_FMT_DBL);
+    ff_add_format(&formats, AV_SAMPLE_FMT_DBLP);
     ret = ff_set_common_formats(ctx, formats);
     if (ret < 0)
         return ret;
@@ -0,0 +1,33 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_SIGNALSTATS_H
+#define AVFILTER_SIGNALSTATS_H
+
+#include <stdint.h>
+
+typedef struct SignalstatsDSPContext {
+    /**
+     * Return the sum of the absolute differences of the w pixels of a line.
+     */
+    int (*sad_line)(const uint8_t *src, const uint8_t *ref, int w);
+} SignalstatsDSPContext;
+
+void ff_signalstats_init_x86(SignalstatsDSPContext *dsp);
+
+#endif /* AVFILTER_SIGNALSTATS_H */
@@ -70,7 +70,12 @@ typedef struct BoxBlurContext {
     int hsub, vsub;
     int radius[4];
     int power[4];
-    uint8_t *temp[2]; ///< temporary buffer used in blur_power()
+    int nb_threads;
+    int temp_len;     ///< size of each of the two blur_power() buffers
+    uint8_t *temp;    ///< temporary buffers used in blur_power(), two per thread
+    int vtemp_linesize;
+    int vtemp_size;   ///< size of the vertical pass buffers of one thread
+    uint8_t *vtemp;   ///< per-thread column sums and planes used in vblur()
 } BoxBlurContext;
 
 #define Y 0
@@ -111,8 +116,8 @@ static av_cold void uninit(AVFilterContext *ctx)
 {
     BoxBlurContext *s = ctx->priv;
 
-    av_freep(&s->temp[0]);
-    av_freep(&s->temp[1]);
+    av_freep(&s->temp);
+    av_freep(&s->vtemp);
 }
 
 static int query_formats(AVFilterContext *ctx)
@@ -142,8 +147,17 @@ static int config_input(AVFilterLink *inlink)
     char *expr;
     int ret;
 
-    if (!(s->temp[0] = av_malloc(2*FFMAX(w, h))) ||
-        !(s->temp[1] = av_malloc(2*FFMAX(w, h))))
+    s->nb_threads = FFMAX(1, FFMIN(FFMIN(w, h), ctx->graph->nb_threads));
+    s->temp_len   = 2*FFMAX(w, h);
+    av_freep(&s->temp);
+    if (!(s->temp = av_malloc_array(2*s->nb_threads, s->temp_len)))
+        return AVERROR(ENOMEM);
+
+    /* each thread blurs at most (w + nb_threads - 1) / nb_threads columns */
+    s->vtemp_linesize = FFALIGN(2*((w + s->nb_threads - 1) / s->nb_threads), 32);
+    s->vtemp_size     = s->vtemp_linesize/2*sizeof(int) + 2*h*s->vtemp_linesize;
+    av_freep(&s->vtemp);
+    if (!(s->vtemp = av_malloc_array(s->nb_threads, s->vtemp_size)))
         return AVERROR(ENOMEM);
 
     s->hsub = desc->log2_chroma_w;
@@ -327,17 +341,153 @@ static void hblur(uint8_t *dst, int dst_linesize, const uint8_t *src, int src_li
                    w, radius, power, temp, pixsize);
 }
 
-static void vblur(uint8_t *dst, int dst_linesize, const uint8_t *src, int src_linesize,
-                  int w, int h, int radius, int power, uint8_t *temp[2], int pixsize)
+/* Vertical counterparts of blur8()/blur16(): all the columns of a slice are
+ * blurred at once, keeping one running sum per column, so that the plane is
+ * walked row by row instead of column by column. */
+static inline void vblur8(uint8_t *dst, int dst_linesize, const uint8_t *src, int src_linesize,
+                          int w, int len, int radius, int *sum)
 {
-    int x;
+    const int length = radius*2 + 1;
+    const int inv = ((1<<16) + length/2)/length;
+    int x, y;
 
-    if (radius == 0 && dst == src)
-        return;
+    for (x = 0; x < w; x++)
+        sum[x] = src[radius*src_linesize + x];
+    for (y = 0; y < radius; y++)
+        for (x = 0; x < w; x++)
+            sum[x] += src[y*src_linesize + x]<<1;
+    for (x = 0; x < w; x++)
+        sum[x] = sum[x]*inv + (1<<15);
+
+    for (y = 0; y < len; y++) {
+        const uint8_t *add = src + (y < len-radius ? radius+y : 2*len-radius-y-1)*src_linesize;
+        const uint8_t *sub = src + (y <= radius    ? radius-y : y-radius-1      )*src_linesize;
+
+        for (x = 0; x < w; x++) {
+            sum[x] += (add[x] - sub[x])*inv;
+            dst[x] = sum[x]>>16;
+        }
+        dst += dst_linesize;
+    }
+}
+
+static inline void vblur16(uint16_t *dst, int dst_linesize, const uint16_t *src, int src_linesize,
+                           int w, int len, int radius, int *sum)
+{
+    const int length = radius*2 + 1;
+    const int inv = ((1<<16) + length/2)/length;
+    int x, y;
 
     for (x = 0; x < w; x++)
-        blur_power(dst + x*pixsize, dst_linesize, src + x*pixsize, src_linesize,
-                   h, radius, power, temp, pixsize);
+        sum[x] = src[radius*src_linesize + x];
+    for (y = 0; y < radius; y++)
+        for (x = 0; x < w; x++)
+            sum[x] += src[y*src_linesize + x]<<1;
+    for (x = 0; x < w; x++)
+        sum[x] = sum[x]*inv + (1<<15);
+
+    for (y = 0; y < len; y++) {
+        const uint16_t *add = src + (y < len-radius ? radius+y : 2*len-radius-y-1)*src_linesize;
+        const uint16_t *sub = src + (y <= radius    ? radius-y : y-radius-1      )*src_linesize;
+
+        for (x = 0; x < w; x++) {
+            sum[x] += (add[x] - sub[x])*inv;
+            dst[x] = sum[x]>>16;
+        }
+        dst += dst_linesize;
+    }
+}
+
+static inline void vblur_rows(uint8_t *dst, int dst_linesize, const uint8_t *src, int src_linesize,
+                              int w, int h, int radius, int *sum, int pixsize)
+{
+    if (pixsize == 1) vblur8 (dst, dst_linesize   , src, src_linesize   , w, h, radius, sum);
+    else              vblur16((uint16_t*)dst, dst_linesize>>1, (const uint16_t*)src, src_linesize>>1, w, h, radius, sum);
+}
+
+/**
+ * Blur the w columns starting at dst in place, power times.
+ * temp must hold two planes of h lines of temp_linesize bytes, and sum w
+ * integers.
+ */
+static void vblur(uint8_t *dst, int dst_linesize, int w, int h, int radius, int power,
+                  uint8_t *temp, int temp_linesize, int *sum, int pixsize)
+{
+    uint8_t *a = temp, *b = temp + h*temp_linesize;
+    int y;
+
+    if (radius == 0 || power == 0)
+        return;
+
+    vblur_rows(a, temp_linesize, dst, dst_linesize, w, h, radius, sum, pixsize);
+    for (; power > 2; power--) {
+        uint8_t *c;
+        vblur_rows(b, temp_linesize, a, temp_linesize, w, h, radius, sum, pixsize);
+        c = a; a = b; b = c;
+    }
+    if (power > 1) {
+        vblur_rows(dst, dst_linesize, a, temp_linesize, w, h, radius, sum, pixsize);
+    } else {
+        for (y = 0; y < h; y++)
+            memcpy(dst + y*dst_linesize, a + y*temp_linesize, w*pixsize);
+    }
+}
+
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int w[4], h[4];
+    int pixsize;
+} ThreadData;
+
+static void get_temp(BoxBlurContext *s, int jobnr, uint8_t *temp[2])
+{
+    temp[0] = s->temp + (2*jobnr    ) * s->temp_len;
+    temp[1] = s->temp + (2*jobnr + 1) * s->temp_len;
+}
+
+static int hblur_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    BoxBlurContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *in = td->in, *out = td->out;
+    uint8_t *temp[2];
+    int plane;
+
+    get_temp(s, jobnr, temp);
+
+    for (plane = 0; plane < 4 && in->data[plane] && in->linesize[plane]; plane++) {
+        const int slice_start = (td->h[plane] *  jobnr   ) / nb_jobs;
+        const int slice_end   = (td->h[plane] * (jobnr+1)) / nb_jobs;
+
+        hblur(out->data[plane] + slice_start * out->linesize[plane], out->linesize[plane],
+              in ->data[plane] + slice_start * in ->linesize[plane], in ->linesize[plane],
+              td->w[plane], slice_end - slice_start, s->radius[plane], s->power[plane],
+              temp, td->pixsize);
+    }
+
+    return 0;
+}
+
+static int vblur_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    BoxBlurContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *out = td->out;
+    int *sum = (int *)(s->vtemp + jobnr * s->vtemp_size);
+    uint8_t *temp = (uint8_t *)(sum + s->vtemp_linesize/2);
+    int plane;
+
+    for (plane = 0; plane < 4 && out->data[plane] && out->linesize[plane]; plane++) {
+        const int slice_start = (td->w[plane] *  jobnr   ) / nb_jobs;
+        const int slice_end   = (td->w[plane] * (jobnr+1)) / nb_jobs;
+        uint8_t *dst = out->data[plane] + slice_start * td->pixsize;
+
+        vblur(dst, out->linesize[plane], slice_end - slice_start, td->h[plane],
+              s->radius[plane], s->power[plane],
+              temp, s->vtemp_linesize, sum, td->pixsize);
+    }
+
+    return 0;
 }
 
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
@@ -346,13 +496,10 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     BoxBlurContext *s = ctx->priv;
     AVFilterLink *outlink = inlink->dst->outputs[0];
     AVFrame *out;
-    int plane;
+    ThreadData td;
     int cw = FF_CEIL_RSHIFT(inlink->w, s->hsub), ch = FF_CEIL_RSHIFT(in->height, s->vsub);
-    int w[4] = { inlink->w, cw, cw, inlink->w };
-    int h[4] = { in->height, ch, ch, in->height };
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
     const int depth = desc->comp[0].depth_minus1 + 1;
-    const int pixsize = (depth+7)/8;
 
     out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
     if (!out) {
@@ -361,17 +508,17 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     }
     av_frame_copy_props(out, in);
 
-    for (plane = 0; plane < 4 && in->data[plane] && in->linesize[plane]; plane++)
-        hblur(out->data[plane], out->linesize[plane],
-              in ->data[plane], in ->linesize[plane],
-              w[plane], h[plane], s->radius[plane], s->power[plane],
-              s->temp, pixsize);
+    td.in  = in;
+    td.out = out;
+    td.w[0] = td.w[3] = inlink->w;
+    td.w[1] = td.w[2] = cw;
+    td.h[0] = td.h[3] = in->height;
+    td.h[1] = td.h[2] = ch;
+    td.pixsize = (depth+7)/8;
 
-    for (plane = 0; plane < 4 && in->data[plane] && in->linesize[plane]; plane++)
-        vblur(out->data[plane], out->linesize[plane],
-              out->data[plane], out->linesize[plane],
-              w[plane], h[plane], s->radius[plane], s->power[plane],
-              s->temp, pixsize);
+    /* the vertical pass needs the whole horizontally blurred frame */
+    ctx->internal->execute(ctx, hblur_slice, &td, NULL, s->nb_threads);
+    ctx->internal->execute(ctx, vblur_slice, &td, NULL, s->nb_threads);
 
     av_frame_free(&in);
 
@@ -430,5 +577,5 @@ AVFilter ff_vf_boxblur = {
     .query_formats = query_formats,
     .inputs        = avfilter_vf_boxblur_inputs,
     .outputs       = avfilter_vf_boxblur_outputs,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
 };
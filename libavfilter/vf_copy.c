@@ -27,9 +27,31 @@
 #include "internal.h"
 #include "video.h"
 
+typedef struct JobData {
+    void (*job)(void *arg, int jobnr, int nb_jobs);
+    void *arg;
+} JobData;
+
+static int run_job(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    JobData *d = arg;
+    d->job(d->arg, jobnr, nb_jobs);
+    return 0;
+}
+
+static void execute(void *opaque, void (*job)(void *arg, int jobnr, int nb_jobs),
+                    void *arg, int nb_jobs)
+{
+    AVFilterContext *ctx = opaque;
+    JobData d = { job, arg };
+
+    ctx->internal->execute(ctx, run_job, &d, NULL, nb_jobs);
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
-    AVFilterLink *outlink = inlink->dst->outputs[0];
+    AVFilterContext *ctx = inlink->dst;
+    AVFilterLink *outlink = ctx->outputs[0];
     AVFrame *out = ff_get_video_buffer(outlink, in->width, in->height);
 
     if (!out) {
@@ -37,7 +59,10 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
         return AVERROR(ENOMEM);
     }
     av_frame_copy_props(out, in);
-    av_frame_copy(out, in);
+    av_image_copy_threaded(out->data, out->linesize,
+                           (const uint8_t **)in->data, in->linesize,
+                           in->format, in->width, in->height,
+                           execute, ctx, ctx->graph->nb_threads);
     av_frame_free(&in);
     return ff_filter_frame(outlink, out);
 }
@@ -64,4 +89,5 @@ AVFilter ff_vf_copy = {
     .description = NULL_IF_CONFIG_SMALL("Copy the input video unchanged to the output."),
     .inputs      = avfilter_vf_copy_inputs,
     .outputs     = avfilter_vf_copy_outputs,
+    .flags       = AVFILTER_FLAG_SLICE_THREADS,
 };
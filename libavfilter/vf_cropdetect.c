@@ -41,6 +41,8 @@ typedef struct CropDetectContext {
     int frame_nb;
     int max_pixsteps[4];
     int max_outliers;
+    int step;
+    int interval;
 } CropDetectContext;
 
 static int query_formats(AVFilterContext *ctx)
@@ -164,7 +166,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
     int bpp = s->max_pixsteps[0];
     int w, h, x, y, shrink_by;
     AVDictionary **metadata;
-    int outliers, last_y;
+    int outliers, last_y, step;
     int limit = round(s->limit);
 
     // ignore first 2 frames - they may be empty
@@ -180,10 +182,16 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
             s->frame_nb = 1;
         }
 
+        // Only analyze one frame out of interval
+        if ((s->frame_nb - 1) % s->interval)
+            return ff_filter_frame(inlink->dst->outputs[0], frame);
+
 #define FIND(DST, FROM, NOEND, INC, STEP0, STEP1, LEN) \
         outliers = 0;\
+        step = FFMIN(s->step, LEN);\
         for (last_y = y = FROM; NOEND; y = y INC) {\
-            if (checkline(ctx, frame->data[0] + STEP0 * y, STEP1, LEN, bpp) > limit) {\
+            if (checkline(ctx, frame->data[0] + STEP0 * y, STEP1 * step,\
+                          (LEN + step - 1) / step, bpp) > limit) {\
                 if (++outliers > s->max_outliers) { \
                     DST = last_y;\
                     break;\
@@ -249,6 +257,8 @@ static const AVOption cropdetect_options[] = {
     { "reset", "Recalculate the crop area after this many frames",    OFFSET(reset_count), AV_OPT_TYPE_INT, { .i64 = 0 },  0, INT_MAX, FLAGS },
     { "reset_count", "Recalculate the crop area after this many frames",OFFSET(reset_count),AV_OPT_TYPE_INT,{ .i64 = 0 },  0, INT_MAX, FLAGS },
     { "max_outliers", "Threshold count of outliers",                  OFFSET(max_outliers),AV_OPT_TYPE_INT, { .i64 = 0 },  0, INT_MAX, FLAGS },
+    { "step",     "Only check one pixel out of step along each line",  OFFSET(step),        AV_OPT_TYPE_INT, { .i64 = 1 },  1, INT_MAX, FLAGS },
+    { "interval", "Only analyze one frame out of interval",            OFFSET(interval),    AV_OPT_TYPE_INT, { .i64 = 1 },  1, INT_MAX, FLAGS },
     { NULL }
 };
 
@@ -34,7 +34,9 @@
 
 typedef struct {
     const AVClass *class;
-    AVExpr *e[4];               ///< expressions for each plane
+    AVExpr *(*e)[4];            ///< expressions for each plane, one set per thread
+    int nb_threads;             ///< number of expression sets allocated in e
+    int has_state[4];           ///< the plane expression uses random() or st()/ld()
     char *expr_str[4+3];        ///< expression strings for each plane
     AVFrame *picref;            ///< current input buffer
     int hsub, vsub;             ///< chroma subsampling
@@ -100,6 +102,47 @@ static double alpha(void *priv, double x, double y) { return getpix(priv, x, y,
 static const char *const var_names[] = {   "X",   "Y",   "W",   "H",   "N",   "SW",   "SH",   "T",        NULL };
 enum                                   { VAR_X, VAR_Y, VAR_W, VAR_H, VAR_N, VAR_SW, VAR_SH, VAR_T, VAR_VARS_NB };
 
+/**
+ * Check if the expression uses random() or st()/ld(). Those keep their
+ * state in the AVExpr from one pixel to the next, so the plane has to be
+ * evaluated in order by a single thread.
+ */
+static int expr_has_state(const char *s)
+{
+    static const char name_chars[] = "_0123456789abcdefghijklmnopqrstuvwxyz"
+                                     "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+    while (*s) {
+        size_t len = strspn(s, name_chars);
+
+        if ((len == 2 && (!strncmp(s, "st", 2) || !strncmp(s, "ld", 2))) ||
+            (len == 6 && !strncmp(s, "random", 6)))
+            return 1;
+        s += len ? len : 1;
+    }
+    return 0;
+}
+
+static int parse_expressions(AVFilterContext *ctx, AVExpr **e)
+{
+    GEQContext *geq = ctx->priv;
+    int plane, ret = 0;
+
+    for (plane = 0; plane < 4; plane++) {
+        static double (*p[])(void *, double, double) = { lum, cb, cr, alpha };
+        static const char *const func2_yuv_names[]    = { "lum", "cb", "cr", "alpha", "p", NULL };
+        static const char *const func2_rgb_names[]    = { "g", "b", "r", "alpha", "p", NULL };
+        const char *const *func2_names       = geq->is_rgb ? func2_rgb_names : func2_yuv_names;
+        double (*func2[])(void *, double, double) = { lum, cb, cr, alpha, p[plane], NULL };
+
+        ret = av_expr_parse(&e[plane], geq->expr_str[plane < 3 && geq->is_rgb ? plane+4 : plane], var_names,
+                            NULL, NULL, func2_names, func2, 0, ctx);
+        if (ret < 0)
+            break;
+    }
+    return ret;
+}
+
 static av_cold int geq_init(AVFilterContext *ctx)
 {
     GEQContext *geq = ctx->priv;
@@ -145,18 +188,16 @@ static av_cold int geq_init(AVFilterContext *ctx)
         goto end;
     }
 
-    for (plane = 0; plane < 4; plane++) {
-        static double (*p[])(void *, double, double) = { lum, cb, cr, alpha };
-        static const char *const func2_yuv_names[]    = { "lum", "cb", "cr", "alpha", "p", NULL };
-        static const char *const func2_rgb_names[]    = { "g", "b", "r", "alpha", "p", NULL };
-        const char *const *func2_names       = geq->is_rgb ? func2_rgb_names : func2_yuv_names;
-        double (*func2[])(void *, double, double) = { lum, cb, cr, alpha, p[plane], NULL };
+    for (plane = 0; plane < 4; plane++)
+        geq->has_state[plane] = expr_has_state(geq->expr_str[plane < 3 && geq->is_rgb ? plane+4 : plane]);
 
-        ret = av_expr_parse(&geq->e[plane], geq->expr_str[plane < 3 && geq->is_rgb ? plane+4 : plane], var_names,
-                            NULL, NULL, func2_names, func2, 0, ctx);
-        if (ret < 0)
-            break;
+    geq->e = av_mallocz(sizeof(*geq->e));
+    if (!geq->e) {
+        ret = AVERROR(ENOMEM);
+        goto end;
     }
+    geq->nb_threads = 1;
+    ret = parse_expressions(ctx, geq->e[0]);
 
 end:
     return ret;
@@ -189,21 +230,77 @@ static int geq_query_formats(AVFilterContext *ctx)
 
 static int geq_config_props(AVFilterLink *inlink)
 {
-    GEQContext *geq = inlink->dst->priv;
+    AVFilterContext *ctx = inlink->dst;
+    GEQContext *geq = ctx->priv;
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
+    int nb_threads = FFMAX(1, FFMIN(inlink->h, ctx->graph->nb_threads));
+    int i, ret;
+    void *e;
 
     geq->hsub = desc->log2_chroma_w;
     geq->vsub = desc->log2_chroma_h;
     geq->planes = desc->nb_components;
+
+    /* root() and taylor() use the variables of the expression as scratch
+     * space, so each thread works on its own copy of the expressions */
+    if (nb_threads > geq->nb_threads) {
+        e = av_realloc_array(geq->e, nb_threads, sizeof(*geq->e));
+        if (!e)
+            return AVERROR(ENOMEM);
+        geq->e = e;
+        memset(geq->e + geq->nb_threads, 0,
+               (nb_threads - geq->nb_threads) * sizeof(*geq->e));
+        for (i = geq->nb_threads; i < nb_threads; i++) {
+            geq->nb_threads = i + 1;
+            if ((ret = parse_expressions(ctx, geq->e[i])) < 0)
+                return ret;
+        }
+    }
+    return 0;
+}
+
+typedef struct ThreadData {
+    AVFrame *out;
+    int plane;
+    int w, h;
+    const double *values;
+} ThreadData;
+
+static int slice_geq_filter(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    GEQContext *geq = ctx->priv;
+    ThreadData *td = arg;
+    const int plane = td->plane;
+    const int w = td->w, h = td->h;
+    const int slice_start = (h *  jobnr   ) / nb_jobs;
+    const int slice_end   = (h * (jobnr+1)) / nb_jobs;
+    const int linesize = td->out->linesize[plane];
+    uint8_t *dst = td->out->data[plane] + slice_start * linesize;
+    AVExpr *e = geq->e[jobnr][plane];
+    double values[VAR_VARS_NB];
+    int x, y;
+
+    memcpy(values, td->values, sizeof(values));
+
+    for (y = slice_start; y < slice_end; y++) {
+        values[VAR_Y] = y;
+        for (x = 0; x < w; x++) {
+            values[VAR_X] = x;
+            dst[x] = av_expr_eval(e, values, geq);
+        }
+        dst += linesize;
+    }
     return 0;
 }
 
 static int geq_filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
     int plane;
-    GEQContext *geq = inlink->dst->priv;
-    AVFilterLink *outlink = inlink->dst->outputs[0];
+    AVFilterContext *ctx = inlink->dst;
+    GEQContext *geq = ctx->priv;
+    AVFilterLink *outlink = ctx->outputs[0];
     AVFrame *out;
+    ThreadData td;
     double values[VAR_VARS_NB] = {
         [VAR_N] = inlink->frame_count,
         [VAR_T] = in->pts == AV_NOPTS_VALUE ? NAN : in->pts * av_q2d(inlink->time_base),
@@ -218,9 +315,6 @@ static int geq_filter_frame(AVFilterLink *inlink, AVFrame *in)
     av_frame_copy_props(out, in);
 
     for (plane = 0; plane < geq->planes && out->data[plane]; plane++) {
-        int x, y;
-        uint8_t *dst = out->data[plane];
-        const int linesize = out->linesize[plane];
         const int w = (plane == 1 || plane == 2) ? FF_CEIL_RSHIFT(inlink->w, geq->hsub) : inlink->w;
         const int h = (plane == 1 || plane == 2) ? FF_CEIL_RSHIFT(inlink->h, geq->vsub) : inlink->h;
 
@@ -229,14 +323,13 @@ static int geq_filter_frame(AVFilterLink *inlink, AVFrame *in)
         values[VAR_SW] = w / (double)inlink->w;
         values[VAR_SH] = h / (double)inlink->h;
 
-        for (y = 0; y < h; y++) {
-            values[VAR_Y] = y;
-            for (x = 0; x < w; x++) {
-                values[VAR_X] = x;
-                dst[x] = av_expr_eval(geq->e[plane], values, geq);
-            }
-            dst += linesize;
-        }
+        td.out    = out;
+        td.plane  = plane;
+        td.w      = w;
+        td.h      = h;
+        td.values = values;
+        ctx->internal->execute(ctx, slice_geq_filter, &td, NULL,
+                               geq->has_state[plane] ? 1 : FFMIN(h, geq->nb_threads));
     }
 
     av_frame_free(&geq->picref);
@@ -245,11 +338,13 @@ static int geq_filter_frame(AVFilterLink *inlink, AVFrame *in)
 
 static av_cold void geq_uninit(AVFilterContext *ctx)
 {
-    int i;
+    int i, j;
     GEQContext *geq = ctx->priv;
 
-    for (i = 0; i < FF_ARRAY_ELEMS(geq->e); i++)
-        av_expr_free(geq->e[i]);
+    for (j = 0; j < geq->nb_threads; j++)
+        for (i = 0; i < FF_ARRAY_ELEMS(geq->e[j]); i++)
+            av_expr_free(geq->e[j][i]);
+    av_freep(&geq->e);
 }
 
 static const AVFilterPad geq_inputs[] = {
@@ -280,5 +375,5 @@ AVFilter ff_vf_geq = {
     .inputs        = geq_inputs,
     .outputs       = geq_outputs,
     .priv_class    = &geq_class,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -277,14 +277,104 @@ static int config_props(AVFilterLink *inlink)
     return 0;
 }
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int w, h;
+} ThreadData;
+
+/* packed, 3 or 4 bytes per pixel */
+#define DEFINE_LUT_PACKED(nb_comp)                                          \
+static int lut_packed##nb_comp(AVFilterContext *ctx, void *arg,             \
+                               int jobnr, int nb_jobs)                      \
+{                                                                           \
+    LutContext *s = ctx->priv;                                              \
+    const ThreadData *td = arg;                                             \
+    const AVFrame *in  = td->in;                                            \
+    AVFrame *out = td->out;                                                 \
+    const uint8_t (*tab)[256] = (const uint8_t (*)[256])s->lut;             \
+    const int w = td->w;                                                    \
+    const int slice_start = (td->h *  jobnr   ) / nb_jobs;                  \
+    const int slice_end   = (td->h * (jobnr+1)) / nb_jobs;                  \
+    const int in_linesize  =  in->linesize[0];                              \
+    const int out_linesize = out->linesize[0];                              \
+    const uint8_t *inrow  = in ->data[0] + slice_start * in_linesize;       \
+    uint8_t       *outrow = out->data[0] + slice_start * out_linesize;      \
+    int i, j;                                                               \
+                                                                            \
+    for (i = slice_start; i < slice_end; i++) {                             \
+        const uint8_t *src = inrow;                                         \
+        uint8_t *dst = outrow;                                              \
+        for (j = 0; j < w; j++) {                                           \
+            dst[0] = tab[0][src[0]];                                        \
+            dst[1] = tab[1][src[1]];                                        \
+            dst[2] = tab[2][src[2]];                                        \
+            if (nb_comp == 4)                                               \
+                dst[3] = tab[3][src[3]];                                    \
+            dst += nb_comp;                                                 \
+            src += nb_comp;                                                 \
+        }                                                                   \
+        inrow  += in_linesize;                                              \
+        outrow += out_linesize;                                             \
+    }                                                                       \
+                                                                            \
+    return 0;                                                               \
+}
+
+DEFINE_LUT_PACKED(3)
+DEFINE_LUT_PACKED(4)
+
+static int lut_planar(AVFilterContext *ctx, void *arg,
+                      int jobnr, int nb_jobs)
+{
+    LutContext *s = ctx->priv;
+    const ThreadData *td = arg;
+    const AVFrame *in  = td->in;
+    AVFrame *out = td->out;
+    int i, j, plane;
+
+    for (plane = 0; plane < 4 && in->data[plane] && in->linesize[plane]; plane++) {
+        int vsub = plane == 1 || plane == 2 ? s->vsub : 0;
+        int hsub = plane == 1 || plane == 2 ? s->hsub : 0;
+        const int h = FF_CEIL_RSHIFT(td->h, vsub);
+        const int w = FF_CEIL_RSHIFT(td->w, hsub);
+        const int slice_start = (h *  jobnr   ) / nb_jobs;
+        const int slice_end   = (h * (jobnr+1)) / nb_jobs;
+        const uint8_t *tab = s->lut[plane];
+        const int in_linesize  =  in->linesize[plane];
+        const int out_linesize = out->linesize[plane];
+        const uint8_t *inrow  = in ->data[plane] + slice_start * in_linesize;
+        uint8_t       *outrow = out->data[plane] + slice_start * out_linesize;
+
+        for (i = slice_start; i < slice_end; i++) {
+            /* unrolled to let independent table loads overlap */
+            for (j = 0; j < w - 3; j += 4) {
+                uint8_t a = tab[inrow[j    ]];
+                uint8_t b = tab[inrow[j + 1]];
+                uint8_t c = tab[inrow[j + 2]];
+                uint8_t d = tab[inrow[j + 3]];
+                outrow[j    ] = a;
+                outrow[j + 1] = b;
+                outrow[j + 2] = c;
+                outrow[j + 3] = d;
+            }
+            for (; j < w; j++)
+                outrow[j] = tab[inrow[j]];
+            inrow  += in_linesize;
+            outrow += out_linesize;
+        }
+    }
+
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
     AVFilterContext *ctx = inlink->dst;
     LutContext *s = ctx->priv;
     AVFilterLink *outlink = ctx->outputs[0];
     AVFrame *out;
-    uint8_t *inrow, *outrow, *inrow0, *outrow0;
-    int i, j, plane, direct = 0;
+    ThreadData td;
+    int direct = 0;
 
     if (av_frame_is_writable(in)) {
         direct = 1;
@@ -298,56 +388,12 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
         av_frame_copy_props(out, in);
     }
 
-    if (s->is_rgb) {
-        /* packed */
-        const int w = inlink->w;
-        const int h = in->height;
-        const uint8_t (*tab)[256] = (const uint8_t (*)[256])s->lut;
-        const int in_linesize  =  in->linesize[0];
-        const int out_linesize = out->linesize[0];
-        const int step = s->step;
-
-        inrow0  = in ->data[0];
-        outrow0 = out->data[0];
-
-        for (i = 0; i < h; i ++) {
-            inrow  = inrow0;
-            outrow = outrow0;
-            for (j = 0; j < w; j++) {
-                switch (step) {
-                case 4:  outrow[3] = tab[3][inrow[3]]; // Fall-through
-                case 3:  outrow[2] = tab[2][inrow[2]]; // Fall-through
-                case 2:  outrow[1] = tab[1][inrow[1]]; // Fall-through
-                default: outrow[0] = tab[0][inrow[0]];
-                }
-                outrow += step;
-                inrow  += step;
-            }
-            inrow0  += in_linesize;
-            outrow0 += out_linesize;
-        }
-    } else {
-        /* planar */
-        for (plane = 0; plane < 4 && in->data[plane] && in->linesize[plane]; plane++) {
-            int vsub = plane == 1 || plane == 2 ? s->vsub : 0;
-            int hsub = plane == 1 || plane == 2 ? s->hsub : 0;
-            int h = FF_CEIL_RSHIFT(inlink->h, vsub);
-            int w = FF_CEIL_RSHIFT(inlink->w, hsub);
-            const uint8_t *tab = s->lut[plane];
-            const int in_linesize  =  in->linesize[plane];
-            const int out_linesize = out->linesize[plane];
-
-            inrow  = in ->data[plane];
-            outrow = out->data[plane];
-
-            for (i = 0; i < h; i++) {
-                for (j = 0; j < w; j++)
-                    outrow[j] = tab[inrow[j]];
-                inrow  += in_linesize;
-                outrow += out_linesize;
-            }
-        }
-    }
+    td.in  = in;
+    td.out = out;
+    td.w   = inlink->w;
+    td.h   = in->height;
+    ctx->internal->execute(ctx, s->is_rgb ? (s->step == 4 ? lut_packed4 : lut_packed3) : lut_planar,
+                           &td, NULL, FFMIN(td.h, ctx->graph->nb_threads));
 
     if (!direct)
         av_frame_free(&in);
@@ -381,7 +427,8 @@ static const AVFilterPad outputs[] = {
         .query_formats = query_formats,                                 \
         .inputs        = inputs,                                        \
         .outputs       = outputs,                                       \
-        .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,        \
+        .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC |       \
+                         AVFILTER_FLAG_SLICE_THREADS,                   \
     }
 
 #if CONFIG_LUT_FILTER
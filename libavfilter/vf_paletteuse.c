@@ -74,13 +74,18 @@ struct cache_node {
 
 struct PaletteUseContext;
 
-typedef int (*set_frame_func)(struct PaletteUseContext *s, AVFrame *out, AVFrame *in,
+typedef int (*set_frame_func)(struct PaletteUseContext *s, struct cache_node *cache,
+                              AVFrame *out, AVFrame *in,
                               int x_start, int y_start, int width, int height);
 
 typedef struct PaletteUseContext {
     const AVClass *class;
     FFDualInputContext dinput;
     struct cache_node cache[CACHE_SIZE];    /* lookup cache */
+    struct cache_node (*slice_caches)[CACHE_SIZE]; /* lookup caches of the slice threads but the first */
+    int nb_slice_caches;
+    int nb_threads;                         /* number of bands mapped in parallel */
+    int *jobs_rets;
     struct color_node map[AVPALETTE_COUNT]; /* 3D-Tree (KD-Tree with K=3) for reverse colormap */
     uint32_t palette[AVPALETTE_COUNT];
     int palette_loaded;
@@ -363,14 +368,14 @@ static av_always_inline int get_dst_color_err(struct cache_node *cache,
     return dstx;
 }
 
-static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFrame *in,
+static av_always_inline int set_frame(PaletteUseContext *s, struct cache_node *cache,
+                                      AVFrame *out, AVFrame *in,
                                       int x_start, int y_start, int w, int h,
                                       enum dithering_mode dither,
                                       const enum color_search_method search_method)
 {
     int x, y;
     const struct color_node *map = s->map;
-    struct cache_node *cache = s->cache;
     const uint32_t *palette = s->palette;
     const int src_linesize = in ->linesize[0] >> 2;
     const int dst_linesize = out->linesize[0];
@@ -848,6 +853,30 @@ static void set_processing_window(enum diff_mode diff_mode,
     *hp = height;
 }
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int x, y, w, h;
+} ThreadData;
+
+/**
+ * Map one horizontal band of the processing window. Only used when no error
+ * is diffused across the pixels, so the bands are independent; each of them
+ * has its own lookup cache since the caches grow during the search.
+ */
+static int set_frame_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    PaletteUseContext *s = ctx->priv;
+    const ThreadData *td = arg;
+    const int slice_start = td->y + (td->h *  jobnr   ) / nb_jobs;
+    const int slice_end   = td->y + (td->h * (jobnr+1)) / nb_jobs;
+    struct cache_node *cache = jobnr ? s->slice_caches[jobnr - 1] : s->cache;
+
+    if (slice_start >= slice_end)
+        return 0;
+    return s->set_frame(s, cache, td->out, td->in, td->x, slice_start,
+                        td->w, slice_end - slice_start);
+}
+
 static AVFrame *apply_palette(AVFilterLink *inlink, AVFrame *in)
 {
     int x, y, w, h;
@@ -878,7 +907,18 @@ static AVFrame *apply_palette(AVFilterLink *inlink, AVFrame *in)
     av_dlog(ctx, "%dx%d rect: (%d;%d) -> (%d,%d) [area:%dx%d]\n",
             w, h, x, y, x+w, y+h, in->width, in->height);
 
-    if (s->set_frame(s, out, in, x, y, w, h) < 0) {
+    if (s->nb_threads > 1) {
+        ThreadData td = { .in = in, .out = out, .x = x, .y = y, .w = w, .h = h };
+        int i, ret = 0;
+
+        ctx->internal->execute(ctx, set_frame_slice, &td, s->jobs_rets, s->nb_threads);
+        for (i = 0; i < s->nb_threads; i++)
+            ret = FFMIN(ret, s->jobs_rets[i]);
+        if (ret < 0) {
+            av_frame_free(&out);
+            return NULL;
+        }
+    } else if (s->set_frame(s, s->cache, out, in, x, y, w, h) < 0) {
         av_frame_free(&out);
         return NULL;
     }
@@ -901,6 +941,21 @@ static int config_output(AVFilterLink *outlink)
     outlink->time_base = ctx->inputs[0]->time_base;
     if ((ret = ff_dualinput_init(ctx, &s->dinput)) < 0)
         return ret;
+
+    /* error diffusion carries state from one pixel to the next, so only
+     * the ordered and no dithering modes can be split in bands */
+    if (s->dither == DITHERING_NONE || s->dither == DITHERING_BAYER)
+        s->nb_threads = FFMAX(1, FFMIN(outlink->h, ctx->graph->nb_threads));
+    else
+        s->nb_threads = 1;
+    if (s->nb_threads > 1 && !s->slice_caches) {
+        s->slice_caches = av_calloc(s->nb_threads - 1, sizeof(*s->slice_caches));
+        s->jobs_rets    = av_calloc(s->nb_threads,     sizeof(*s->jobs_rets));
+        if (!s->slice_caches || !s->jobs_rets)
+            return AVERROR(ENOMEM);
+        s->nb_slice_caches = s->nb_threads - 1;
+    }
+    s->nb_threads = FFMIN(s->nb_threads, s->nb_slice_caches + 1);
     return 0;
 }
 
@@ -955,10 +1010,12 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 }
 
 #define DEFINE_SET_FRAME(color_search, name, value)                             \
-static int set_frame_##name(PaletteUseContext *s, AVFrame *out, AVFrame *in,    \
+static int set_frame_##name(PaletteUseContext *s, struct cache_node *cache,     \
+                            AVFrame *out, AVFrame *in,                          \
                             int x_start, int y_start, int w, int h)             \
 {                                                                               \
-    return set_frame(s, out, in, x_start, y_start, w, h, value, color_search);  \
+    return set_frame(s, cache, out, in, x_start, y_start, w, h,                 \
+                     value, color_search);                                      \
 }
 
 #define DEFINE_SET_FRAME_COLOR_SEARCH(color_search, color_search_macro)                                 \
@@ -1023,12 +1080,19 @@ static int request_frame(AVFilterLink *outlink)
 
 static av_cold void uninit(AVFilterContext *ctx)
 {
-    int i;
+    int i, j;
     PaletteUseContext *s = ctx->priv;
 
     ff_dualinput_uninit(&s->dinput);
     for (i = 0; i < CACHE_SIZE; i++)
         av_freep(&s->cache[i].entries);
+    if (s->slice_caches) {
+        for (j = 0; j < s->nb_slice_caches; j++)
+            for (i = 0; i < CACHE_SIZE; i++)
+                av_freep(&s->slice_caches[j][i].entries);
+        av_freep(&s->slice_caches);
+    }
+    av_freep(&s->jobs_rets);
     av_frame_free(&s->last_in);
     av_frame_free(&s->last_out);
 }
@@ -1068,4 +1132,5 @@ AVFilter ff_vf_paletteuse = {
     .inputs        = paletteuse_inputs,
     .outputs       = paletteuse_outputs,
     .priv_class    = &paletteuse_class,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -23,6 +23,7 @@
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
 #include "internal.h"
+#include "signalstats.h"
 
 enum FilterMode {
     FILTER_NONE = -1,
@@ -40,16 +41,23 @@ typedef struct {
     int vsub;       // vertical subsampling
     int fs;         // pixel count per frame
     int cfs;        // pixel count per frame of chroma planes
+    int sfs;        // sampled pixel count per frame
+    int scfs;       // sampled pixel count per frame of chroma planes
     int outfilter;  // FilterMode
     int filters;
+    int xstep;      // horizontal sampling step of the statistics
+    int ystep;      // vertical sampling step of the statistics
+    int interval;   // analyze one frame out of interval
+    int64_t frame_nb;
     AVFrame *frame_prev;
     uint8_t rgba_color[4];
     int yuv_color[3];
     int nb_jobs;
     int *jobs_rets;
-
-    AVFrame *frame_sat;
-    AVFrame *frame_hue;
+    struct SliceStats *jobs_stats;
+    uint8_t  *sat_lut;  // saturation of each (u << 8 | v) chroma pair
+    uint16_t *hue_lut;  // hue in degrees of each (u << 8 | v) chroma pair
+    SignalstatsDSPContext dsp;
 } SignalstatsContext;
 
 typedef struct ThreadData {
@@ -57,10 +65,19 @@ typedef struct ThreadData {
     AVFrame *out;
 } ThreadData;
 
-typedef struct ThreadDataHueSatMetrics {
-    const AVFrame *src;
-    AVFrame *dst_sat, *dst_hue;
-} ThreadDataHueSatMetrics;
+typedef struct ThreadDataStats {
+    const AVFrame *in;
+    const AVFrame *prev;
+} ThreadDataStats;
+
+#define DEPTH 256
+
+/* histograms and differences accumulated by one slice thread */
+typedef struct SliceStats {
+    unsigned histy[DEPTH], histu[DEPTH], histv[DEPTH], histsat[DEPTH];
+    unsigned histhue[360];
+    int64_t dify, difu, difv;
+} SliceStats;
 
 #define OFFSET(x) offsetof(SignalstatsContext, x)
 #define FLAGS AV_OPT_FLAG_FILTERING_PARAM|AV_OPT_FLAG_VIDEO_PARAM
@@ -76,16 +93,49 @@ static const AVOption signalstats_options[] = {
         {"brng", "highlight pixels that are outside of broadcast range",        0, AV_OPT_TYPE_CONST, {.i64=FILTER_BRNG}, 0, 0, FLAGS, "out"},
     {"c",     "set highlight color", OFFSET(rgba_color), AV_OPT_TYPE_COLOR, {.str="yellow"}, .flags=FLAGS},
     {"color", "set highlight color", OFFSET(rgba_color), AV_OPT_TYPE_COLOR, {.str="yellow"}, .flags=FLAGS},
+    {"xstep", "set horizontal sampling step of the statistics", OFFSET(xstep), AV_OPT_TYPE_INT, {.i64=1}, 1, INT_MAX, FLAGS},
+    {"ystep", "set vertical sampling step of the statistics",   OFFSET(ystep), AV_OPT_TYPE_INT, {.i64=1}, 1, INT_MAX, FLAGS},
+    {"interval", "set the number of frames between analyzed frames", OFFSET(interval), AV_OPT_TYPE_INT, {.i64=1}, 1, INT_MAX, FLAGS},
     {NULL}
 };
 
 AVFILTER_DEFINE_CLASS(signalstats);
 
+static int sad_line_c(const uint8_t *src, const uint8_t *ref, int w)
+{
+    int i, sad = 0;
+
+    for (i = 0; i < w; i++)
+        sad += abs(src[i] - ref[i]);
+    return sad;
+}
+
 static av_cold int init(AVFilterContext *ctx)
 {
     uint8_t r, g, b;
+    int u, v;
     SignalstatsContext *s = ctx->priv;
 
+    s->sat_lut = av_malloc_array(256 * 256, sizeof(*s->sat_lut));
+    s->hue_lut = av_malloc_array(256 * 256, sizeof(*s->hue_lut));
+    if (!s->sat_lut || !s->hue_lut)
+        return AVERROR(ENOMEM);
+
+    for (u = 0; u < 256; u++) {
+        for (v = 0; v < 256; v++) {
+            const int sat = hypot(u - 128, v - 128); // int or round?
+            const int hue = floor((180 / M_PI) * atan2f(u-128, v-128) + 180);
+
+            s->sat_lut[u << 8 | v] = sat;
+            // atan2() may return exactly pi, 360 degrees is 0 degrees
+            s->hue_lut[u << 8 | v] = hue % 360;
+        }
+    }
+
+    s->dsp.sad_line = sad_line_c;
+    if (ARCH_X86)
+        ff_signalstats_init_x86(&s->dsp);
+
     if (s->outfilter != FILTER_NONE)
         s->filters |= 1 << s->outfilter;
 
@@ -102,9 +152,10 @@ static av_cold void uninit(AVFilterContext *ctx)
 {
     SignalstatsContext *s = ctx->priv;
     av_frame_free(&s->frame_prev);
-    av_frame_free(&s->frame_sat);
-    av_frame_free(&s->frame_hue);
     av_freep(&s->jobs_rets);
+    av_freep(&s->jobs_stats);
+    av_freep(&s->sat_lut);
+    av_freep(&s->hue_lut);
 }
 
 static int query_formats(AVFilterContext *ctx)
@@ -124,24 +175,6 @@ static int query_formats(AVFilterContext *ctx)
     return ff_set_common_formats(ctx, fmts_list);
 }
 
-static AVFrame *alloc_frame(enum AVPixelFormat pixfmt, int w, int h)
-{
-    AVFrame *frame = av_frame_alloc();
-    if (!frame)
-        return NULL;
-
-    frame->format = pixfmt;
-    frame->width  = w;
-    frame->height = h;
-
-    if (av_frame_get_buffer(frame, 32) < 0) {
-        av_frame_free(&frame);
-        return NULL;
-    }
-
-    return frame;
-}
-
 static int config_props(AVFilterLink *outlink)
 {
     AVFilterContext *ctx = outlink->src;
@@ -159,15 +192,15 @@ static int config_props(AVFilterLink *outlink)
 
     s->fs = inlink->w * inlink->h;
     s->cfs = s->chromaw * s->chromah;
+    s->sfs  = ((inlink->w  + s->xstep - 1) / s->xstep) * ((inlink->h  + s->ystep - 1) / s->ystep);
+    s->scfs = ((s->chromaw + s->xstep - 1) / s->xstep) * ((s->chromah + s->ystep - 1) / s->ystep);
 
     s->nb_jobs   = FFMAX(1, FFMIN(inlink->h, ctx->graph->nb_threads));
-    s->jobs_rets = av_malloc_array(s->nb_jobs, sizeof(*s->jobs_rets));
-    if (!s->jobs_rets)
-        return AVERROR(ENOMEM);
-
-    s->frame_sat = alloc_frame(AV_PIX_FMT_GRAY8,  inlink->w, inlink->h);
-    s->frame_hue = alloc_frame(AV_PIX_FMT_GRAY16, inlink->w, inlink->h);
-    if (!s->frame_sat || !s->frame_hue)
+    av_freep(&s->jobs_rets);
+    av_freep(&s->jobs_stats);
+    s->jobs_rets  = av_malloc_array(s->nb_jobs, sizeof(*s->jobs_rets));
+    s->jobs_stats = av_malloc_array(s->nb_jobs, sizeof(*s->jobs_stats));
+    if (!s->jobs_rets || !s->jobs_stats)
         return AVERROR(ENOMEM);
 
     return 0;
@@ -315,41 +348,68 @@ static const struct {
     {NULL}
 };
 
-#define DEPTH 256
+static int line_sad(const SignalstatsContext *s,
+                    const uint8_t *src, const uint8_t *ref, int w)
+{
+    int i, sad = 0;
 
-static int compute_sat_hue_metrics(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+    if (s->xstep == 1)
+        return s->dsp.sad_line(src, ref, w);
+    for (i = 0; i < w; i += s->xstep)
+        sad += abs(src[i] - ref[i]);
+    return sad;
+}
+
+/**
+ * Accumulate the histograms and the differences with the previous frame of
+ * every xstep-th pixel of every ystep-th line of the slice. The saturation
+ * and hue of the sampled chroma pixels are looked up in tables.
+ */
+static int compute_stats(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    int i, j;
-    ThreadDataHueSatMetrics *td = arg;
     const SignalstatsContext *s = ctx->priv;
-    const AVFrame *src = td->src;
-    AVFrame *dst_sat = td->dst_sat;
-    AVFrame *dst_hue = td->dst_hue;
+    const ThreadDataStats *td = arg;
+    const AVFrame *in   = td->in;
+    const AVFrame *prev = td->prev;
+    SliceStats *st = &s->jobs_stats[jobnr];
+    const int lines  = (in->height + s->ystep - 1) / s->ystep;
+    const int clines = (s->chromah + s->ystep - 1) / s->ystep;
+    const int slice_start  = (lines  *  jobnr   ) / nb_jobs;
+    const int slice_end    = (lines  * (jobnr+1)) / nb_jobs;
+    const int cslice_start = (clines *  jobnr   ) / nb_jobs;
+    const int cslice_end   = (clines * (jobnr+1)) / nb_jobs;
+    int i, j;
 
-    const int slice_start = (s->chromah *  jobnr   ) / nb_jobs;
-    const int slice_end   = (s->chromah * (jobnr+1)) / nb_jobs;
+    memset(st, 0, sizeof(*st));
 
-    const int lsz_u = src->linesize[1];
-    const int lsz_v = src->linesize[2];
-    const uint8_t *p_u = src->data[1] + slice_start * lsz_u;
-    const uint8_t *p_v = src->data[2] + slice_start * lsz_v;
+    // Calculate luma histogram and difference with previous frame or field.
+    for (j = slice_start; j < slice_end; j++) {
+        const uint8_t *p_y  = in  ->data[0] + j * s->ystep * in  ->linesize[0];
+        const uint8_t *pp_y = prev->data[0] + j * s->ystep * prev->linesize[0];
 
-    const int lsz_sat = dst_sat->linesize[0];
-    const int lsz_hue = dst_hue->linesize[0];
-    uint8_t *p_sat = dst_sat->data[0] + slice_start * lsz_sat;
-    uint8_t *p_hue = dst_hue->data[0] + slice_start * lsz_hue;
+        for (i = 0; i < in->width; i += s->xstep)
+            st->histy[p_y[i]]++;
+        st->dify += line_sad(s, p_y, pp_y, in->width);
+    }
 
-    for (j = slice_start; j < slice_end; j++) {
-        for (i = 0; i < s->chromaw; i++) {
+    // Calculate chroma histogram and difference with previous frame or field.
+    for (j = cslice_start; j < cslice_end; j++) {
+        const uint8_t *p_u  = in  ->data[1] + j * s->ystep * in  ->linesize[1];
+        const uint8_t *p_v  = in  ->data[2] + j * s->ystep * in  ->linesize[2];
+        const uint8_t *pp_u = prev->data[1] + j * s->ystep * prev->linesize[1];
+        const uint8_t *pp_v = prev->data[2] + j * s->ystep * prev->linesize[2];
+
+        for (i = 0; i < s->chromaw; i += s->xstep) {
             const int yuvu = p_u[i];
             const int yuvv = p_v[i];
-            p_sat[i] = hypot(yuvu - 128, yuvv - 128); // int or round?
-            ((int16_t*)p_hue)[i] = floor((180 / M_PI) * atan2f(yuvu-128, yuvv-128) + 180);
+
+            st->histu[yuvu]++;
+            st->histv[yuvv]++;
+            st->histsat[s->sat_lut[yuvu << 8 | yuvv]]++;
+            st->histhue[s->hue_lut[yuvu << 8 | yuvv]]++;
         }
-        p_u   += lsz_u;
-        p_v   += lsz_v;
-        p_sat += lsz_sat;
-        p_hue += lsz_hue;
+        st->difu += line_sad(s, p_u, pp_u, s->chromaw);
+        st->difv += line_sad(s, p_v, pp_v, s->chromaw);
     }
 
     return 0;
@@ -362,8 +422,6 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
     AVFilterLink *outlink = ctx->outputs[0];
     AVFrame *out = in;
     int i, j;
-    int  w = 0,  cw = 0, // in
-        pw = 0, cpw = 0; // prev
     int fil;
     char metabuf[128];
     unsigned int histy[DEPTH] = {0},
@@ -380,66 +438,49 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
     int accy, accu, accv;
     int accsat, acchue = 0;
     int medhue, maxhue;
-    int toty = 0, totu = 0, totv = 0, totsat=0;
-    int tothue = 0;
-    int dify = 0, difu = 0, difv = 0;
+    int64_t toty = 0, totu = 0, totv = 0, totsat=0;
+    int64_t tothue = 0;
+    int64_t dify = 0, difu = 0, difv = 0;
 
     int filtot[FILT_NUMB] = {0};
     AVFrame *prev;
-
-    AVFrame *sat = s->frame_sat;
-    AVFrame *hue = s->frame_hue;
-    const uint8_t *p_sat = sat->data[0];
-    const uint8_t *p_hue = hue->data[0];
-    const int lsz_sat = sat->linesize[0];
-    const int lsz_hue = hue->linesize[0];
-    ThreadDataHueSatMetrics td_huesat = {
-        .src     = in,
-        .dst_sat = sat,
-        .dst_hue = hue,
-    };
+    ThreadDataStats td_stats;
 
     if (!s->frame_prev)
         s->frame_prev = av_frame_clone(in);
 
     prev = s->frame_prev;
 
+    // Only keep track of the previous frame on the frames left out.
+    if (s->frame_nb++ % s->interval) {
+        av_frame_free(&s->frame_prev);
+        s->frame_prev = av_frame_clone(in);
+        return ff_filter_frame(outlink, in);
+    }
+
     if (s->outfilter != FILTER_NONE) {
         out = av_frame_clone(in);
         av_frame_make_writable(out);
     }
 
-    ctx->internal->execute(ctx, compute_sat_hue_metrics, &td_huesat,
-                           NULL, FFMIN(s->chromah, ctx->graph->nb_threads));
+    td_stats.in   = in;
+    td_stats.prev = prev;
+    ctx->internal->execute(ctx, compute_stats, &td_stats, NULL, s->nb_jobs);
 
-    // Calculate luma histogram and difference with previous frame or field.
-    for (j = 0; j < link->h; j++) {
-        for (i = 0; i < link->w; i++) {
-            const int yuv = in->data[0][w + i];
-            histy[yuv]++;
-            dify += abs(yuv - prev->data[0][pw + i]);
-        }
-        w  += in->linesize[0];
-        pw += prev->linesize[0];
-    }
+    for (j = 0; j < s->nb_jobs; j++) {
+        const SliceStats *st = &s->jobs_stats[j];
 
-    // Calculate chroma histogram and difference with previous frame or field.
-    for (j = 0; j < s->chromah; j++) {
-        for (i = 0; i < s->chromaw; i++) {
-            const int yuvu = in->data[1][cw+i];
-            const int yuvv = in->data[2][cw+i];
-            histu[yuvu]++;
-            difu += abs(yuvu - prev->data[1][cpw+i]);
-            histv[yuvv]++;
-            difv += abs(yuvv - prev->data[2][cpw+i]);
-
-            histsat[p_sat[i]]++;
-            histhue[((int16_t*)p_hue)[i]]++;
+        for (i = 0; i < DEPTH; i++) {
+            histy[i]   += st->histy[i];
+            histu[i]   += st->histu[i];
+            histv[i]   += st->histv[i];
+            histsat[i] += st->histsat[i];
         }
-        cw  += in->linesize[1];
-        cpw += prev->linesize[1];
-        p_sat += lsz_sat;
-        p_hue += lsz_hue;
+        for (i = 0; i < 360; i++)
+            histhue[i] += st->histhue[i];
+        dify += st->dify;
+        difu += st->difu;
+        difv += st->difv;
     }
 
     for (fil = 0; fil < FILT_NUMB; fil ++) {
@@ -459,10 +500,10 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
     // find low / high based on histogram percentile
     // these only need to be calculated once.
 
-    lowp   = lrint(s->fs  * 10 / 100.);
-    highp  = lrint(s->fs  * 90 / 100.);
-    clowp  = lrint(s->cfs * 10 / 100.);
-    chighp = lrint(s->cfs * 90 / 100.);
+    lowp   = lrint(s->sfs  * 10 / 100.);
+    highp  = lrint(s->sfs  * 90 / 100.);
+    clowp  = lrint(s->scfs * 10 / 100.);
+    chighp = lrint(s->scfs * 90 / 100.);
 
     accy = accu = accv = accsat = 0;
     for (fil = 0; fil < DEPTH; fil++) {
@@ -503,7 +544,7 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
         tothue += histhue[fil] * fil;
         acchue += histhue[fil];
 
-        if (medhue == -1 && acchue > s->cfs / 2)
+        if (medhue == -1 && acchue > s->scfs / 2)
             medhue = fil;
         if (histhue[fil] > maxhue) {
             maxhue = histhue[fil];
@@ -520,34 +561,34 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
 
     SET_META("YMIN",    "%d", miny);
     SET_META("YLOW",    "%d", lowy);
-    SET_META("YAVG",    "%g", 1.0 * toty / s->fs);
+    SET_META("YAVG",    "%g", 1.0 * toty / s->sfs);
     SET_META("YHIGH",   "%d", highy);
     SET_META("YMAX",    "%d", maxy);
 
     SET_META("UMIN",    "%d", minu);
     SET_META("ULOW",    "%d", lowu);
-    SET_META("UAVG",    "%g", 1.0 * totu / s->cfs);
+    SET_META("UAVG",    "%g", 1.0 * totu / s->scfs);
     SET_META("UHIGH",   "%d", highu);
     SET_META("UMAX",    "%d", maxu);
 
     SET_META("VMIN",    "%d", minv);
     SET_META("VLOW",    "%d", lowv);
-    SET_META("VAVG",    "%g", 1.0 * totv / s->cfs);
+    SET_META("VAVG",    "%g", 1.0 * totv / s->scfs);
     SET_META("VHIGH",   "%d", highv);
     SET_META("VMAX",    "%d", maxv);
 
     SET_META("SATMIN",  "%d", minsat);
     SET_META("SATLOW",  "%d", lowsat);
-    SET_META("SATAVG",  "%g", 1.0 * totsat / s->cfs);
+    SET_META("SATAVG",  "%g", 1.0 * totsat / s->scfs);
     SET_META("SATHIGH", "%d", highsat);
     SET_META("SATMAX",  "%d", maxsat);
 
     SET_META("HUEMED",  "%d", medhue);
-    SET_META("HUEAVG",  "%g", 1.0 * tothue / s->cfs);
+    SET_META("HUEAVG",  "%g", 1.0 * tothue / s->scfs);
 
-    SET_META("YDIF",    "%g", 1.0 * dify / s->fs);
-    SET_META("UDIF",    "%g", 1.0 * difu / s->cfs);
-    SET_META("VDIF",    "%g", 1.0 * difv / s->cfs);
+    SET_META("YDIF",    "%g", 1.0 * dify / s->sfs);
+    SET_META("UDIF",    "%g", 1.0 * difu / s->scfs);
+    SET_META("VDIF",    "%g", 1.0 * difv / s->scfs);
 
     for (fil = 0; fil < FILT_NUMB; fil ++) {
         if (s->filters & 1<<fil) {
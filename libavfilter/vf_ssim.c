@@ -0,0 +1,560 @@
+/*
+ * Copyright (c) 2003-2013 Loren Merritt
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/* Computes the Structural Similarity Metric between two video streams.
+ * original algorithm:
+ * Z. Wang, A. C. Bovik, H. R. Sheikh and E. P. Simoncelli,
+ *   "Image quality assessment: From error visibility to structural similarity,"
+ *   IEEE Transactions on Image Processing, vol. 13, no. 4, pp. 600-612, Apr. 2004.
+ *
+ * To improve speed, this implementation uses the standard approximation of
+ * overlapped 8x8 block sums, rather than the original gaussian weights.
+ */
+
+/**
+ * @file
+ * Calculate the SSIM between two input videos.
+ */
+
+#include "libavutil/avstring.h"
+#include "libavutil/opt.h"
+#include "libavutil/pixdesc.h"
+#include "avfilter.h"
+#include "dualinput.h"
+#include "drawutils.h"
+#include "formats.h"
+#include "internal.h"
+#include "ssim.h"
+#include "video.h"
+
+typedef struct SSIMContext {
+    const AVClass *class;
+    FFDualInputContext dinput;
+    FILE *stats_file;
+    char *stats_file_str;
+    int nb_components;
+    uint64_t nb_frames;
+    double ssim[4], ssim_total;
+    char comps[4];
+    float coefs[4];
+    uint8_t rgba_map[4];
+    int planewidth[4];
+    int planeheight[4];
+    int is_rgb;
+    int max;
+    int nb_threads;
+    void *temp;                 ///< per-slice block sums, two lines each
+    int temp_size;              ///< size in bytes of one slice's block sums
+    float *line_ssim[4];        ///< SSIM sum of each window line of each plane
+    SSIMDSPContext dsp;
+} SSIMContext;
+
+#define OFFSET(x) offsetof(SSIMContext, x)
+#define FLAGS AV_OPT_FLAG_FILTERING_PARAM|AV_OPT_FLAG_VIDEO_PARAM
+
+static const AVOption ssim_options[] = {
+    {"stats_file", "Set file where to store per-frame difference information", OFFSET(stats_file_str), AV_OPT_TYPE_STRING, {.str=NULL}, 0, 0, FLAGS },
+    {"f",          "Set file where to store per-frame difference information", OFFSET(stats_file_str), AV_OPT_TYPE_STRING, {.str=NULL}, 0, 0, FLAGS },
+    { NULL }
+};
+
+AVFILTER_DEFINE_CLASS(ssim);
+
+static void set_meta(AVDictionary **metadata, const char *key, char comp, float d)
+{
+    char value[128];
+    snprintf(value, sizeof(value), "%0.2f", d);
+    if (comp) {
+        char key2[128];
+        snprintf(key2, sizeof(key2), "%s%c", key, comp);
+        av_dict_set(metadata, key2, value, 0);
+    } else {
+        av_dict_set(metadata, key, value, 0);
+    }
+}
+
+static void ssim_4x4_line(const uint8_t *main, ptrdiff_t main_stride,
+                          const uint8_t *ref, ptrdiff_t ref_stride,
+                          int (*sums)[4], int width)
+{
+    int x, y, z;
+
+    for (z = 0; z < width; z++) {
+        uint32_t s1 = 0, s2 = 0, ss = 0, s12 = 0;
+
+        for (y = 0; y < 4; y++) {
+            for (x = 0; x < 4; x++) {
+                int a = main[x + y * main_stride];
+                int b = ref[x + y * ref_stride];
+
+                s1  += a;
+                s2  += b;
+                ss  += a*a;
+                ss  += b*b;
+                s12 += a*b;
+            }
+        }
+
+        sums[z][0] = s1;
+        sums[z][1] = s2;
+        sums[z][2] = ss;
+        sums[z][3] = s12;
+        main += 4;
+        ref += 4;
+    }
+}
+
+static void ssim_4x4_line_16bit(const uint8_t *_main, ptrdiff_t main_stride,
+                                const uint8_t *_ref, ptrdiff_t ref_stride,
+                                int64_t (*sums)[4], int width)
+{
+    const uint16_t *main = (const uint16_t *)_main;
+    const uint16_t *ref = (const uint16_t *)_ref;
+    int x, y, z;
+
+    main_stride >>= 1;
+    ref_stride >>= 1;
+
+    for (z = 0; z < width; z++) {
+        uint64_t s1 = 0, s2 = 0, ss = 0, s12 = 0;
+
+        for (y = 0; y < 4; y++) {
+            for (x = 0; x < 4; x++) {
+                unsigned a = main[x + y * main_stride];
+                unsigned b = ref[x + y * ref_stride];
+
+                s1  += a;
+                s2  += b;
+                ss  += a*a;
+                ss  += b*b;
+                s12 += a*b;
+            }
+        }
+
+        sums[z][0] = s1;
+        sums[z][1] = s2;
+        sums[z][2] = ss;
+        sums[z][3] = s12;
+        main += 4;
+        ref += 4;
+    }
+}
+
+static float ssim_end1(int s1, int s2, int ss, int s12)
+{
+    static const int ssim_c1 = (int)(.01*.01*255*255*64 + .5);
+    static const int ssim_c2 = (int)(.03*.03*255*255*64*63 + .5);
+
+    int fs1 = s1;
+    int fs2 = s2;
+    int fss = ss;
+    int fs12 = s12;
+    int vars = fss * 64 - fs1 * fs1 - fs2 * fs2;
+    int covar = fs12 * 64 - fs1 * fs2;
+
+    return (float)(2 * fs1 * fs2 + ssim_c1) * (float)(2 * covar + ssim_c2)
+         / ((float)(fs1 * fs1 + fs2 * fs2 + ssim_c1) * (float)(vars + ssim_c2));
+}
+
+static double ssim_end1_16bit(int64_t s1, int64_t s2, int64_t ss, int64_t s12, int max)
+{
+    double ssim_c1 = .01 * .01 * max * max * 64;
+    double ssim_c2 = .03 * .03 * max * max * 64 * 63;
+
+    double fs1 = s1;
+    double fs2 = s2;
+    double fss = ss;
+    double fs12 = s12;
+    double vars = fss * 64 - fs1 * fs1 - fs2 * fs2;
+    double covar = fs12 * 64 - fs1 * fs2;
+
+    return (2 * fs1 * fs2 + ssim_c1) * (2 * covar + ssim_c2)
+         / ((fs1 * fs1 + fs2 * fs2 + ssim_c1) * (vars + ssim_c2));
+}
+
+static float ssim_end_line(const int (*sum0)[4], const int (*sum1)[4], int width)
+{
+    float ssim = 0.0;
+    int i;
+
+    for (i = 0; i < width; i++)
+        ssim += ssim_end1(sum0[i][0] + sum0[i + 1][0] + sum1[i][0] + sum1[i + 1][0],
+                          sum0[i][1] + sum0[i + 1][1] + sum1[i][1] + sum1[i + 1][1],
+                          sum0[i][2] + sum0[i + 1][2] + sum1[i][2] + sum1[i + 1][2],
+                          sum0[i][3] + sum0[i + 1][3] + sum1[i][3] + sum1[i + 1][3]);
+    return ssim;
+}
+
+static float ssim_end_line_16bit(const int64_t (*sum0)[4], const int64_t (*sum1)[4],
+                                 int width, int max)
+{
+    double ssim = 0.0;
+    int i;
+
+    for (i = 0; i < width; i++)
+        ssim += ssim_end1_16bit(sum0[i][0] + sum0[i + 1][0] + sum1[i][0] + sum1[i + 1][0],
+                                sum0[i][1] + sum0[i + 1][1] + sum1[i][1] + sum1[i + 1][1],
+                                sum0[i][2] + sum0[i + 1][2] + sum1[i][2] + sum1[i + 1][2],
+                                sum0[i][3] + sum0[i + 1][3] + sum1[i][3] + sum1[i + 1][3],
+                                max);
+    return ssim;
+}
+
+typedef struct ThreadData {
+    const uint8_t *main_data[4];
+    int main_linesize[4];
+    const uint8_t *ref_data[4];
+    int ref_linesize[4];
+} ThreadData;
+
+/**
+ * Compute the SSIM of the 8x8 window lines [slice_start, slice_end) of every
+ * plane. Window line y overlaps the 4x4 block lines y and y + 1, so each
+ * slice only recomputes the block sums of its first line on top of its own.
+ */
+static int ssim_plane_slice(AVFilterContext *ctx, void *arg,
+                            int jobnr, int nb_jobs)
+{
+    SSIMContext *s = ctx->priv;
+    ThreadData *td = arg;
+    int c, x, y;
+
+    for (c = 0; c < s->nb_components; c++) {
+        const int width  = s->planewidth[c]  >> 2;
+        const int height = s->planeheight[c] >> 2;
+        const int slice_start = ((height - 1) *  jobnr   ) / nb_jobs;
+        const int slice_end   = ((height - 1) * (jobnr+1)) / nb_jobs;
+        const uint8_t *main = td->main_data[c];
+        const uint8_t *ref  = td->ref_data[c];
+        const ptrdiff_t main_stride = td->main_linesize[c];
+        const ptrdiff_t ref_stride  = td->ref_linesize[c];
+        uint8_t *temp = (uint8_t *)s->temp + jobnr * s->temp_size;
+
+        if (slice_start >= slice_end)
+            continue;
+
+        if (s->max > 255) {
+            int64_t (*sum0)[4] = (int64_t (*)[4])temp;
+            int64_t (*sum1)[4] = sum0 + width + 3;
+
+            ssim_4x4_line_16bit(main + 4 * slice_start * main_stride, main_stride,
+                                ref  + 4 * slice_start * ref_stride,  ref_stride,
+                                sum0, width);
+            for (y = slice_start; y < slice_end; y++) {
+                FFSWAP(void *, sum0, sum1);
+                ssim_4x4_line_16bit(main + 4 * (y + 1) * main_stride, main_stride,
+                                    ref  + 4 * (y + 1) * ref_stride,  ref_stride,
+                                    sum0, width);
+                s->line_ssim[c][y] = ssim_end_line_16bit((const int64_t (*)[4])sum0,
+                                                         (const int64_t (*)[4])sum1,
+                                                         width - 1, s->max);
+            }
+        } else {
+            int (*sum0)[4] = (int (*)[4])temp;
+            int (*sum1)[4] = sum0 + width + 3;
+
+            s->dsp.ssim_4x4_line(main + 4 * slice_start * main_stride, main_stride,
+                                 ref  + 4 * slice_start * ref_stride,  ref_stride,
+                                 sum0, width);
+            for (y = slice_start; y < slice_end; y++) {
+                float ssim = 0.0;
+
+                FFSWAP(void *, sum0, sum1);
+                s->dsp.ssim_4x4_line(main + 4 * (y + 1) * main_stride, main_stride,
+                                     ref  + 4 * (y + 1) * ref_stride,  ref_stride,
+                                     sum0, width);
+                for (x = 0; x < width - 1; x += 4)
+                    ssim += s->dsp.ssim_end_line((const int (*)[4])(sum0 + x),
+                                                 (const int (*)[4])(sum1 + x),
+                                                 FFMIN(4, width - x - 1));
+                s->line_ssim[c][y] = ssim;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static double ssim_db(double ssim, double weight)
+{
+    return 10 * (log(weight) / log(10) - log(weight - ssim) / log(10));
+}
+
+static AVFrame *do_ssim(AVFilterContext *ctx, AVFrame *main,
+                        const AVFrame *ref)
+{
+    AVDictionary **metadata = avpriv_frame_get_metadatap(main);
+    SSIMContext *s = ctx->priv;
+    float c[4], ssimv = 0.0;
+    ThreadData td;
+    int i, y;
+
+    s->nb_frames++;
+
+    for (i = 0; i < s->nb_components; i++) {
+        td.main_data[i]     = main->data[i];
+        td.main_linesize[i] = main->linesize[i];
+        td.ref_data[i]      = ref->data[i];
+        td.ref_linesize[i]  = ref->linesize[i];
+    }
+
+    ctx->internal->execute(ctx, ssim_plane_slice, &td, NULL, s->nb_threads);
+
+    /* Sum the lines in a fixed order so that the result does not depend on
+     * the number of threads. */
+    for (i = 0; i < s->nb_components; i++) {
+        const int width  = s->planewidth[i]  >> 2;
+        const int height = s->planeheight[i] >> 2;
+        double ssim = 0.0;
+
+        for (y = 0; y < height - 1; y++)
+            ssim += s->line_ssim[i][y];
+        c[i] = ssim / ((height - 1) * (width - 1));
+    }
+
+    for (i = 0; i < s->nb_components; i++)
+        ssimv += s->coefs[i] * c[i];
+
+    for (i = 0; i < s->nb_components; i++) {
+        int cidx = s->is_rgb ? s->rgba_map[i] : i;
+        set_meta(metadata, "lavfi.ssim.", s->comps[i], c[cidx]);
+    }
+    set_meta(metadata, "lavfi.ssim.All", 0, ssimv);
+    set_meta(metadata, "lavfi.ssim.dB", 0, ssim_db(ssimv, 1.0));
+
+    if (s->stats_file) {
+        fprintf(s->stats_file, "n:%"PRId64" ", s->nb_frames);
+
+        for (i = 0; i < s->nb_components; i++) {
+            int cidx = s->is_rgb ? s->rgba_map[i] : i;
+            fprintf(s->stats_file, "%c:%f ", s->comps[i], c[cidx]);
+        }
+
+        fprintf(s->stats_file, "All:%f (%f)\n", ssimv, ssim_db(ssimv, 1.0));
+    }
+
+    s->ssim_total += ssimv;
+    for (i = 0; i < s->nb_components; i++)
+        s->ssim[i] += c[i];
+
+    return main;
+}
+
+static av_cold int init(AVFilterContext *ctx)
+{
+    SSIMContext *s = ctx->priv;
+
+    if (s->stats_file_str) {
+        s->stats_file = fopen(s->stats_file_str, "w");
+        if (!s->stats_file) {
+            int err = AVERROR(errno);
+            char buf[128];
+            av_strerror(err, buf, sizeof(buf));
+            av_log(ctx, AV_LOG_ERROR, "Could not open stats file %s: %s\n",
+                   s->stats_file_str, buf);
+            return err;
+        }
+    }
+
+    s->dinput.process = do_ssim;
+    s->dsp.ssim_4x4_line = ssim_4x4_line;
+    s->dsp.ssim_end_line = ssim_end_line;
+    if (ARCH_X86)
+        ff_ssim_init_x86(&s->dsp);
+    return 0;
+}
+
+static int query_formats(AVFilterContext *ctx)
+{
+    static const enum AVPixelFormat pix_fmts[] = {
+        AV_PIX_FMT_GRAY8, AV_PIX_FMT_GRAY16,
+#define PF_NOALPHA(suf) AV_PIX_FMT_YUV420##suf,  AV_PIX_FMT_YUV422##suf,  AV_PIX_FMT_YUV444##suf
+#define PF_ALPHA(suf)   AV_PIX_FMT_YUVA420##suf, AV_PIX_FMT_YUVA422##suf, AV_PIX_FMT_YUVA444##suf
+#define PF(suf)         PF_NOALPHA(suf), PF_ALPHA(suf)
+        PF(P), PF(P9), PF(P10), PF_NOALPHA(P12), PF_NOALPHA(P14), PF(P16),
+        AV_PIX_FMT_YUV440P, AV_PIX_FMT_YUV411P, AV_PIX_FMT_YUV410P,
+        AV_PIX_FMT_YUVJ411P, AV_PIX_FMT_YUVJ420P, AV_PIX_FMT_YUVJ422P,
+        AV_PIX_FMT_YUVJ440P, AV_PIX_FMT_YUVJ444P,
+        AV_PIX_FMT_GBRP, AV_PIX_FMT_GBRP9, AV_PIX_FMT_GBRP10,
+        AV_PIX_FMT_GBRP12, AV_PIX_FMT_GBRP14, AV_PIX_FMT_GBRP16,
+        AV_PIX_FMT_GBRAP, AV_PIX_FMT_GBRAP16,
+        AV_PIX_FMT_NONE
+    };
+
+    AVFilterFormats *fmts_list = ff_make_format_list(pix_fmts);
+    if (!fmts_list)
+        return AVERROR(ENOMEM);
+    return ff_set_common_formats(ctx, fmts_list);
+}
+
+static int config_input_ref(AVFilterLink *inlink)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
+    AVFilterContext *ctx  = inlink->dst;
+    SSIMContext *s = ctx->priv;
+    int sum = 0, max_width = 0, i;
+
+    s->nb_components = desc->nb_components;
+
+    if (ctx->inputs[0]->w != ctx->inputs[1]->w ||
+        ctx->inputs[0]->h != ctx->inputs[1]->h) {
+        av_log(ctx, AV_LOG_ERROR, "Width and height of input videos must be same.\n");
+        return AVERROR(EINVAL);
+    }
+    if (ctx->inputs[0]->format != ctx->inputs[1]->format) {
+        av_log(ctx, AV_LOG_ERROR, "Inputs must be of same pixel format.\n");
+        return AVERROR(EINVAL);
+    }
+
+    s->is_rgb = ff_fill_rgba_map(s->rgba_map, inlink->format) >= 0;
+    s->comps[0] = s->is_rgb ? 'R' : 'Y';
+    s->comps[1] = s->is_rgb ? 'G' : 'U';
+    s->comps[2] = s->is_rgb ? 'B' : 'V';
+    s->comps[3] = 'A';
+
+    s->planeheight[1] = s->planeheight[2] = FF_CEIL_RSHIFT(inlink->h, desc->log2_chroma_h);
+    s->planeheight[0] = s->planeheight[3] = inlink->h;
+    s->planewidth[1]  = s->planewidth[2]  = FF_CEIL_RSHIFT(inlink->w, desc->log2_chroma_w);
+    s->planewidth[0]  = s->planewidth[3]  = inlink->w;
+
+    for (i = 0; i < s->nb_components; i++) {
+        if (s->planewidth[i] < 8 || s->planeheight[i] < 8) {
+            av_log(ctx, AV_LOG_ERROR, "Input planes must be at least 8x8.\n");
+            return AVERROR(EINVAL);
+        }
+        sum += s->planeheight[i] * s->planewidth[i];
+        max_width = FFMAX(max_width, s->planewidth[i]);
+    }
+    for (i = 0; i < s->nb_components; i++)
+        s->coefs[i] = (double) s->planeheight[i] * s->planewidth[i] / sum;
+
+    s->max = (1 << (desc->comp[0].depth_minus1 + 1)) - 1;
+
+    s->nb_threads = FFMIN((s->planeheight[0] >> 2) - 1, ctx->graph->nb_threads);
+    s->temp_size  = 2 * ((max_width >> 2) + 3) *
+                    (s->max > 255 ? sizeof(int64_t[4]) : sizeof(int[4]));
+    av_freep(&s->temp);
+    s->temp = av_malloc_array(s->nb_threads, s->temp_size);
+    if (!s->temp)
+        return AVERROR(ENOMEM);
+
+    for (i = 0; i < s->nb_components; i++) {
+        av_freep(&s->line_ssim[i]);
+        s->line_ssim[i] = av_malloc_array(s->planeheight[i] >> 2, sizeof(*s->line_ssim[i]));
+        if (!s->line_ssim[i])
+            return AVERROR(ENOMEM);
+    }
+
+    return 0;
+}
+
+static int config_output(AVFilterLink *outlink)
+{
+    AVFilterContext *ctx = outlink->src;
+    SSIMContext *s = ctx->priv;
+    AVFilterLink *mainlink = ctx->inputs[0];
+    int ret;
+
+    outlink->w = mainlink->w;
+    outlink->h = mainlink->h;
+    outlink->time_base = mainlink->time_base;
+    outlink->sample_aspect_ratio = mainlink->sample_aspect_ratio;
+    outlink->frame_rate = mainlink->frame_rate;
+
+    if ((ret = ff_dualinput_init(ctx, &s->dinput)) < 0)
+        return ret;
+
+    return 0;
+}
+
+static int filter_frame(AVFilterLink *inlink, AVFrame *buf)
+{
+    SSIMContext *s = inlink->dst->priv;
+    return ff_dualinput_filter_frame(&s->dinput, inlink, buf);
+}
+
+static int request_frame(AVFilterLink *outlink)
+{
+    SSIMContext *s = outlink->src->priv;
+    return ff_dualinput_request_frame(&s->dinput, outlink);
+}
+
+static av_cold void uninit(AVFilterContext *ctx)
+{
+    SSIMContext *s = ctx->priv;
+    int i;
+
+    if (s->nb_frames > 0) {
+        char buf[256];
+        buf[0] = 0;
+        for (i = 0; i < s->nb_components; i++) {
+            int c = s->is_rgb ? s->rgba_map[i] : i;
+            av_strlcatf(buf, sizeof(buf), " %c:%f", s->comps[i], s->ssim[c] / s->nb_frames);
+        }
+        av_log(ctx, AV_LOG_INFO, "SSIM%s All:%f (%f)\n", buf,
+               s->ssim_total / s->nb_frames, ssim_db(s->ssim_total, s->nb_frames));
+    }
+
+    ff_dualinput_uninit(&s->dinput);
+
+    if (s->stats_file)
+        fclose(s->stats_file);
+
+    av_freep(&s->temp);
+    for (i = 0; i < 4; i++)
+        av_freep(&s->line_ssim[i]);
+}
+
+static const AVFilterPad ssim_inputs[] = {
+    {
+        .name         = "main",
+        .type         = AVMEDIA_TYPE_VIDEO,
+        .filter_frame = filter_frame,
+    },{
+        .name         = "reference",
+        .type         = AVMEDIA_TYPE_VIDEO,
+        .filter_frame = filter_frame,
+        .config_props = config_input_ref,
+    },
+    { NULL }
+};
+
+static const AVFilterPad ssim_outputs[] = {
+    {
+        .name          = "default",
+        .type          = AVMEDIA_TYPE_VIDEO,
+        .config_props  = config_output,
+        .request_frame = request_frame,
+    },
+    { NULL }
+};
+
+AVFilter ff_vf_ssim = {
+    .name          = "ssim",
+    .description   = NULL_IF_CONFIG_SMALL("Calculate the SSIM between two video streams."),
+    .init          = init,
+    .uninit        = uninit,
+    .query_formats = query_formats,
+    .priv_size     = sizeof(SSIMContext),
+    .priv_class    = &ssim_class,
+    .inputs        = ssim_inputs,
+    .outputs       = ssim_outputs,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
+};
@@ -0,0 +1,125 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/asm.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/psnr.h"
+
+#if HAVE_SSE2_INLINE && HAVE_INLINE_ASM_LABELS
+static uint64_t sse_line_8bit_sse2(const uint8_t *buf, const uint8_t *ref, int w)
+{
+    const int len = w & ~15;
+    x86_reg i     = -len;
+    unsigned m2   = 0;
+    int j;
+
+    if (len) {
+        __asm__ volatile (
+            "pxor       %%xmm0, %%xmm0          \n\t"
+            "pxor       %%xmm5, %%xmm5          \n\t"
+            "1:                                 \n\t"
+            "movdqu     (%2, %0), %%xmm1        \n\t"
+            "movdqu     (%3, %0), %%xmm3        \n\t"
+            "movdqa     %%xmm1, %%xmm2          \n\t"
+            "movdqa     %%xmm3, %%xmm4          \n\t"
+            "punpcklbw  %%xmm0, %%xmm1          \n\t"
+            "punpckhbw  %%xmm0, %%xmm2          \n\t"
+            "punpcklbw  %%xmm0, %%xmm3          \n\t"
+            "punpckhbw  %%xmm0, %%xmm4          \n\t"
+            "psubw      %%xmm3, %%xmm1          \n\t"
+            "psubw      %%xmm4, %%xmm2          \n\t"
+            "pmaddwd    %%xmm1, %%xmm1          \n\t"
+            "pmaddwd    %%xmm2, %%xmm2          \n\t"
+            "paddd      %%xmm1, %%xmm5          \n\t"
+            "paddd      %%xmm2, %%xmm5          \n\t"
+            "add        $16, %0                \n\t"
+            "jl         1b                      \n\t"
+            "pshufd     $0x0e, %%xmm5, %%xmm1  \n\t"
+            "paddd      %%xmm1, %%xmm5          \n\t"
+            "pshufd     $0x01, %%xmm5, %%xmm1  \n\t"
+            "paddd      %%xmm1, %%xmm5          \n\t"
+            "movd       %%xmm5, %1              \n\t"
+            : "+r"(i), "=m"(m2)
+            : "r"(buf + len), "r"(ref + len)
+            : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                           "%xmm4", "%xmm5",) "memory"
+        );
+    }
+    for (j = len; j < w; j++)
+        m2 += (buf[j] - ref[j]) * (buf[j] - ref[j]);
+
+    return m2;
+}
+
+/* The differences of samples of up to 15 bits fit in signed words. */
+static uint64_t sse_line_16bit_sse2(const uint8_t *_buf, const uint8_t *_ref, int w)
+{
+    const uint16_t *buf = (const uint16_t *)_buf;
+    const uint16_t *ref = (const uint16_t *)_ref;
+    const int len = w & ~7;
+    x86_reg i     = -2 * len;
+    uint64_t m2   = 0;
+    int j;
+
+    if (len) {
+        __asm__ volatile (
+            "pxor       %%xmm0, %%xmm0          \n\t"
+            "pxor       %%xmm5, %%xmm5          \n\t"
+            "1:                                 \n\t"
+            "movdqu     (%2, %0), %%xmm1        \n\t"
+            "movdqu     (%3, %0), %%xmm2        \n\t"
+            "psubw      %%xmm2, %%xmm1          \n\t"
+            "pmaddwd    %%xmm1, %%xmm1          \n\t"
+            "movdqa     %%xmm1, %%xmm2          \n\t"
+            "punpckldq  %%xmm0, %%xmm1          \n\t"
+            "punpckhdq  %%xmm0, %%xmm2          \n\t"
+            "paddq      %%xmm1, %%xmm5          \n\t"
+            "paddq      %%xmm2, %%xmm5          \n\t"
+            "add        $16, %0                \n\t"
+            "jl         1b                      \n\t"
+            "pshufd     $0x0e, %%xmm5, %%xmm1  \n\t"
+            "paddq      %%xmm1, %%xmm5          \n\t"
+            "movq       %%xmm5, %1              \n\t"
+            : "+r"(i), "=m"(m2)
+            : "r"(buf + len), "r"(ref + len)
+            : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm5",) "memory"
+        );
+    }
+    for (j = len; j < w; j++)
+        m2 += (unsigned)((buf[j] - ref[j]) * (buf[j] - ref[j]));
+
+    return m2;
+}
+#endif /* HAVE_SSE2_INLINE && HAVE_INLINE_ASM_LABELS */
+
+av_cold void ff_psnr_init_x86(PSNRDSPContext *dsp, int bpp)
+{
+#if HAVE_SSE2_INLINE && HAVE_INLINE_ASM_LABELS
+    int cpu_flags = av_get_cpu_flags();
+
+    if (INLINE_SSE2(cpu_flags)) {
+        if (bpp <= 8)
+            dsp->sse_line = sse_line_8bit_sse2;
+        else if (bpp <= 15)
+            dsp->sse_line = sse_line_16bit_sse2;
+    }
+#endif
+}
@@ -0,0 +1,75 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/asm.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/signalstats.h"
+
+#if HAVE_SSE2_INLINE && HAVE_INLINE_ASM_LABELS
+static int sad_line_sse2(const uint8_t *src, const uint8_t *ref, int w)
+{
+    const int len = w & ~31;
+    x86_reg i     = -len;
+    int sad       = 0;
+    int j;
+
+    if (len) {
+        __asm__ volatile (
+            "pxor       %%xmm4, %%xmm4          \n\t"
+            "pxor       %%xmm5, %%xmm5          \n\t"
+            "1:                                 \n\t"
+            "movdqu       (%2, %0), %%xmm0      \n\t"
+            "movdqu     16(%2, %0), %%xmm1      \n\t"
+            "movdqu       (%3, %0), %%xmm2      \n\t"
+            "movdqu     16(%3, %0), %%xmm3      \n\t"
+            "psadbw     %%xmm2, %%xmm0          \n\t"
+            "psadbw     %%xmm3, %%xmm1          \n\t"
+            "paddd      %%xmm0, %%xmm4          \n\t"
+            "paddd      %%xmm1, %%xmm5          \n\t"
+            "add        $32, %0                 \n\t"
+            "jl         1b                      \n\t"
+            "paddd      %%xmm5, %%xmm4          \n\t"
+            "pshufd     $0x0e, %%xmm4, %%xmm0   \n\t"
+            "paddd      %%xmm0, %%xmm4          \n\t"
+            "movd       %%xmm4, %1              \n\t"
+            : "+r"(i), "=m"(sad)
+            : "r"(src + len), "r"(ref + len)
+            : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                           "%xmm4", "%xmm5",) "memory"
+        );
+    }
+    for (j = len; j < w; j++)
+        sad += abs(src[j] - ref[j]);
+
+    return sad;
+}
+#endif /* HAVE_SSE2_INLINE && HAVE_INLINE_ASM_LABELS */
+
+av_cold void ff_signalstats_init_x86(SignalstatsDSPContext *dsp)
+{
+#if HAVE_SSE2_INLINE && HAVE_INLINE_ASM_LABELS
+    int cpu_flags = av_get_cpu_flags();
+
+    if (INLINE_SSE2(cpu_flags))
+        dsp->sad_line = sad_line_sse2;
+#endif
+}
@@ -0,0 +1,226 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/mem.h"
+#include "libavutil/x86/asm.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/ssim.h"
+
+#if HAVE_SSE2_INLINE && HAVE_INLINE_ASM_LABELS && HAVE_7REGS
+DECLARE_ASM_CONST(16, uint16_t, pw_1)[8] = { 1, 1, 1, 1, 1, 1, 1, 1 };
+
+#define ROW(mrow, rrow)                                             \
+    "movq       "mrow", %%xmm4              \n\t"                   \
+    "movq       "rrow", %%xmm5              \n\t"                   \
+    "punpcklbw  %%xmm7, %%xmm4              \n\t"                   \
+    "punpcklbw  %%xmm7, %%xmm5              \n\t"                   \
+    "paddw      %%xmm4, %%xmm0              \n\t"                   \
+    "paddw      %%xmm5, %%xmm1              \n\t"                   \
+    "movdqa     %%xmm4, %%xmm6              \n\t"                   \
+    "pmaddwd    %%xmm5, %%xmm6              \n\t"                   \
+    "pmaddwd    %%xmm4, %%xmm4              \n\t"                   \
+    "pmaddwd    %%xmm5, %%xmm5              \n\t"                   \
+    "paddd      %%xmm6, %%xmm3              \n\t"                   \
+    "paddd      %%xmm4, %%xmm2              \n\t"                   \
+    "paddd      %%xmm5, %%xmm2              \n\t"
+
+/* Two blocks per iteration: the sums are accumulated over the 4 rows
+ * for the two pairs of columns of each block, then transposed. */
+static void ssim_4x4_line_sse2(const uint8_t *main, ptrdiff_t main_stride,
+                               const uint8_t *ref, ptrdiff_t ref_stride,
+                               int (*sums)[4], int w)
+{
+    x86_reg pairs = w >> 1;
+    int x, y;
+
+    if (pairs) {
+        __asm__ volatile (
+            "1:                                 \n\t"
+            "pxor       %%xmm0, %%xmm0          \n\t"
+            "pxor       %%xmm1, %%xmm1          \n\t"
+            "pxor       %%xmm2, %%xmm2          \n\t"
+            "pxor       %%xmm3, %%xmm3          \n\t"
+            "pxor       %%xmm7, %%xmm7          \n\t"
+            ROW("(%0)",     "(%1)")
+            ROW("(%0, %4)", "(%1, %5)")
+            "lea        (%0, %4, 2), %0         \n\t"
+            "lea        (%1, %5, 2), %1         \n\t"
+            ROW("(%0)",     "(%1)")
+            ROW("(%0, %4)", "(%1, %5)")
+            "sub        %4, %0                  \n\t"
+            "sub        %5, %1                  \n\t"
+            "sub        %4, %0                  \n\t"
+            "sub        %5, %1                  \n\t"
+            "pmaddwd    %6, %%xmm0              \n\t"
+            "pmaddwd    %6, %%xmm1              \n\t"
+            /* s1, s2, ss, s12 of each pair of columns -> one line per block */
+            "movdqa     %%xmm0, %%xmm4          \n\t"
+            "punpckldq  %%xmm1, %%xmm4          \n\t"
+            "punpckhdq  %%xmm1, %%xmm0          \n\t"
+            "movdqa     %%xmm2, %%xmm5          \n\t"
+            "punpckldq  %%xmm3, %%xmm5          \n\t"
+            "punpckhdq  %%xmm3, %%xmm2          \n\t"
+            "movdqa     %%xmm4, %%xmm6          \n\t"
+            "punpcklqdq %%xmm5, %%xmm6          \n\t"
+            "punpckhqdq %%xmm5, %%xmm4          \n\t"
+            "paddd      %%xmm6, %%xmm4          \n\t"
+            "movdqa     %%xmm0, %%xmm6          \n\t"
+            "punpcklqdq %%xmm2, %%xmm6          \n\t"
+            "punpckhqdq %%xmm2, %%xmm0          \n\t"
+            "paddd      %%xmm6, %%xmm0          \n\t"
+            "movdqu     %%xmm4,   (%2)          \n\t"
+            "movdqu     %%xmm0, 16(%2)          \n\t"
+            "add        $8, %0                 \n\t"
+            "add        $8, %1                 \n\t"
+            "add        $32, %2                \n\t"
+            "sub        $1, %3                 \n\t"
+            "jg         1b                      \n\t"
+            : "+r"(main), "+r"(ref), "+r"(sums), "+r"(pairs)
+            : "r"(main_stride), "r"(ref_stride), "m"(*pw_1)
+            : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                           "%xmm4", "%xmm5", "%xmm6", "%xmm7",) "memory"
+        );
+    }
+
+    if (w & 1) {
+        int s1 = 0, s2 = 0, ss = 0, s12 = 0;
+
+        for (y = 0; y < 4; y++) {
+            for (x = 0; x < 4; x++) {
+                int a = main[x + y * main_stride];
+                int b = ref[x + y * ref_stride];
+
+                s1  += a;
+                s2  += b;
+                ss  += a * a + b * b;
+                s12 += a * b;
+            }
+        }
+        sums[0][0] = s1;
+        sums[0][1] = s2;
+        sums[0][2] = ss;
+        sums[0][3] = s12;
+    }
+}
+#endif /* HAVE_SSE2_INLINE && HAVE_INLINE_ASM_LABELS && HAVE_7REGS */
+
+#if HAVE_SSE2_INLINE
+DECLARE_ASM_CONST(16, int, ssim_c1)[4] = { 416, 416, 416, 416 };
+DECLARE_ASM_CONST(16, int, ssim_c2)[4] = { 235963, 235963, 235963, 235963 };
+
+/* The window sums are added and transposed so that each register holds one
+ * kind of sum for the 4 windows. The integer part is computed exactly like
+ * in C: the sums of samples are below 2^15, so pmaddwd can multiply them. */
+static float ssim_end_line_sse2(const int (*sum0)[4], const int (*sum1)[4], int w)
+{
+    DECLARE_ALIGNED(16, float, ssim)[4];
+    float sum = 0.0;
+    int i;
+
+    __asm__ volatile (
+        "movdqu     (%1), %%xmm0            \n\t"
+        "movdqu   16(%1), %%xmm1            \n\t"
+        "movdqu   32(%1), %%xmm2            \n\t"
+        "movdqu   48(%1), %%xmm3            \n\t"
+        "movdqu   64(%1), %%xmm4            \n\t"
+        "paddd      %%xmm1, %%xmm0          \n\t"
+        "paddd      %%xmm2, %%xmm1          \n\t"
+        "paddd      %%xmm3, %%xmm2          \n\t"
+        "paddd      %%xmm4, %%xmm3          \n\t"
+        "movdqu     (%2), %%xmm4            \n\t"
+        "movdqu   16(%2), %%xmm5            \n\t"
+        "paddd      %%xmm5, %%xmm4          \n\t"
+        "paddd      %%xmm4, %%xmm0          \n\t"
+        "movdqu   32(%2), %%xmm4            \n\t"
+        "paddd      %%xmm4, %%xmm5          \n\t"
+        "paddd      %%xmm5, %%xmm1          \n\t"
+        "movdqu   48(%2), %%xmm5            \n\t"
+        "paddd      %%xmm5, %%xmm4          \n\t"
+        "paddd      %%xmm4, %%xmm2          \n\t"
+        "movdqu   64(%2), %%xmm4            \n\t"
+        "paddd      %%xmm4, %%xmm5          \n\t"
+        "paddd      %%xmm5, %%xmm3          \n\t"
+
+        "movdqa     %%xmm0, %%xmm4          \n\t"
+        "punpckldq  %%xmm1, %%xmm4          \n\t"
+        "punpckhdq  %%xmm1, %%xmm0          \n\t"
+        "movdqa     %%xmm2, %%xmm5          \n\t"
+        "punpckldq  %%xmm3, %%xmm5          \n\t"
+        "punpckhdq  %%xmm3, %%xmm2          \n\t"
+        "movdqa     %%xmm4, %%xmm1          \n\t"
+        "punpcklqdq %%xmm5, %%xmm1          \n\t" // s1
+        "punpckhqdq %%xmm5, %%xmm4          \n\t" // s2
+        "movdqa     %%xmm0, %%xmm3          \n\t"
+        "punpcklqdq %%xmm2, %%xmm3          \n\t" // ss
+        "punpckhqdq %%xmm2, %%xmm0          \n\t" // s12
+
+        "movdqa     %%xmm1, %%xmm5          \n\t"
+        "pmaddwd    %%xmm4, %%xmm5          \n\t" // s1 * s2
+        "movdqa     %%xmm1, %%xmm2          \n\t"
+        "pmaddwd    %%xmm1, %%xmm2          \n\t" // s1 * s1
+        "pmaddwd    %%xmm4, %%xmm4          \n\t" // s2 * s2
+        "pslld      $6, %%xmm3             \n\t"
+        "psubd      %%xmm2, %%xmm3          \n\t"
+        "psubd      %%xmm4, %%xmm3          \n\t" // vars
+        "paddd      %%xmm4, %%xmm2          \n\t"
+        "paddd      %3, %%xmm2              \n\t" // s1 * s1 + s2 * s2 + c1
+        "pslld      $6, %%xmm0             \n\t"
+        "psubd      %%xmm5, %%xmm0          \n\t" // covar
+        "pslld      $1, %%xmm5             \n\t"
+        "paddd      %3, %%xmm5              \n\t" // 2 * s1 * s2 + c1
+        "pslld      $1, %%xmm0             \n\t"
+        "paddd      %4, %%xmm0              \n\t" // 2 * covar + c2
+        "paddd      %4, %%xmm3              \n\t" // vars + c2
+        "cvtdq2ps   %%xmm5, %%xmm5          \n\t"
+        "cvtdq2ps   %%xmm0, %%xmm0          \n\t"
+        "cvtdq2ps   %%xmm2, %%xmm2          \n\t"
+        "cvtdq2ps   %%xmm3, %%xmm3          \n\t"
+        "mulps      %%xmm0, %%xmm5          \n\t"
+        "mulps      %%xmm3, %%xmm2          \n\t"
+        "divps      %%xmm2, %%xmm5          \n\t"
+        "movaps     %%xmm5, %0              \n\t"
+        : "=m"(ssim)
+        : "r"(sum0), "r"(sum1), "m"(*ssim_c1), "m"(*ssim_c2)
+        : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                       "%xmm4", "%xmm5",) "memory"
+    );
+
+    /* add the lanes in order, like the C version */
+    for (i = 0; i < w; i++)
+        sum += ssim[i];
+
+    return sum;
+}
+#endif /* HAVE_SSE2_INLINE */
+
+av_cold void ff_ssim_init_x86(SSIMDSPContext *dsp)
+{
+#if HAVE_SSE2_INLINE
+    int cpu_flags = av_get_cpu_flags();
+
+    if (INLINE_SSE2(cpu_flags)) {
+#if HAVE_INLINE_ASM_LABELS && HAVE_7REGS
+        dsp->ssim_4x4_line = ssim_4x4_line_sse2;
+#endif
+        dsp->ssim_end_line = ssim_end_line_sse2;
+    }
+#endif /* HAVE_SSE2_INLINE */
+}
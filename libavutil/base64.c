@@ -29,6 +29,19 @@
 #include "intreadwrite.h"
 #include "timer.h"
 
+#if ARCH_X86
+#include "thread.h"
+#include "x86/base64.h"
+
+static FFBase64DSP base64_dsp;
+static AVOnce base64_dsp_once = AV_ONCE_INIT;
+
+static av_cold void base64_dsp_init(void)
+{
+    ff_base64_init_x86(&base64_dsp);
+}
+#endif
+
 /* ---------------- private code */
 static const uint8_t map2[256] =
 {
@@ -85,6 +98,16 @@ int av_base64_decode(uint8_t *out, const char *in_str, int out_size)
     unsigned bits = 0xff;
     unsigned v;
 
+#if ARCH_X86
+    ff_thread_once(&base64_dsp_once, base64_dsp_init);
+    if (base64_dsp.decode && out_size >= 16) {
+        /* the SIMD loads must not go past the end of the string */
+        int len = base64_dsp.decode(dst, in, strlen(in_str), out_size);
+        dst += len;
+        in  += len / 3 * 4;
+    }
+#endif
+
     while (end - dst > 3) {
         BASE64_DEC_STEP(0);
         BASE64_DEC_STEP(1);
@@ -148,6 +171,15 @@ char *av_base64_encode(char *out, int out_size, const uint8_t *in, int in_size)
         out_size < AV_BASE64_SIZE(in_size))
         return NULL;
     ret = dst = out;
+#if ARCH_X86
+    ff_thread_once(&base64_dsp_once, base64_dsp_init);
+    if (base64_dsp.encode) {
+        int len = base64_dsp.encode(dst, in, in_size);
+        in  += len;
+        dst += len / 3 * 4;
+        bytes_remaining -= len;
+    }
+#endif
     while (bytes_remaining > 3) {
         i_bits = AV_RB32(in);
         in += 3; bytes_remaining -= 3;
@@ -251,6 +283,11 @@ int main(int argc, char ** argv)
     for (i = 0; i < FF_ARRAY_ELEMS(tests); i++)
         error_count += test_encode_decode(tests[i].data, strlen(tests[i].data), tests[i].encoded_ref);
 
+    /* long enough for the block-wise code paths */
+    for (i = 0; i < sizeof(in); i++)
+        in[i] = i * 37 + (i >> 3);
+    error_count += test_encode_decode(in, sizeof(in) - 7, NULL);
+
     if (argc>1 && !strcmp(argv[1], "-t")) {
         memset(in, 123, sizeof(in));
         for(i=0; i<10000; i++){
@@ -217,10 +217,14 @@ int av_buffer_realloc(AVBufferRef **pbuf, int size)
 AVBufferPool *av_buffer_pool_init(int size, AVBufferRef* (*alloc)(int size))
 {
     AVBufferPool *pool = av_mallocz(sizeof(*pool));
+    int i;
+
     if (!pool)
         return NULL;
 
     ff_mutex_init(&pool->mutex, NULL);
+    for (i = 0; i < BUFFER_POOL_CACHES; i++)
+        ff_mutex_init(&pool->caches[i].mutex, NULL);
 
     pool->size     = size;
     pool->alloc    = alloc ? alloc : av_buffer_alloc;
@@ -234,16 +238,27 @@ AVBufferPool *av_buffer_pool_init(int size, AVBufferRef* (*alloc)(int size))
  * This function gets called when the pool has been uninited and
  * all the buffers returned to it.
  */
-static void buffer_pool_free(AVBufferPool *pool)
+static void free_entries(BufferPoolEntry *buf)
 {
-    while (pool->pool) {
-        BufferPoolEntry *buf = pool->pool;
-        pool->pool = buf->next;
+    while (buf) {
+        BufferPoolEntry *next = buf->next;
 
         buf->free(buf->opaque, buf->data);
-        av_freep(&buf);
+        av_free(buf);
+        buf = next;
     }
+}
+
+static void buffer_pool_free(AVBufferPool *pool)
+{
+    int i;
+
+    free_entries(pool->pool);
     ff_mutex_destroy(&pool->mutex);
+    for (i = 0; i < BUFFER_POOL_CACHES; i++) {
+        free_entries(pool->caches[i].entries);
+        ff_mutex_destroy(&pool->caches[i].mutex);
+    }
     av_freep(&pool);
 }
 
@@ -296,6 +311,85 @@ static void add_to_pool(BufferPoolEntry *buf)
             end = end->next;
     }
 }
+#else
+/*
+ * Return the cache used by the calling thread. Thread stacks lie far apart,
+ * so the address of a local variable identifies the thread well enough
+ * without requiring thread-local storage. A thread that ends up on another
+ * thread's cache only loses locality, never correctness.
+ */
+static BufferPoolCache *get_cache(AVBufferPool *pool)
+{
+    int stack;
+    uint32_t key = (uintptr_t)&stack >> 20;
+
+    return &pool->caches[((key * 0x9E3779B1U) >> 16) % BUFFER_POOL_CACHES];
+}
+
+/* move all but the first keep entries of the cache to the shared list;
+ * must be called with the cache locked */
+static void flush_cache(AVBufferPool *pool, BufferPoolCache *cache, int keep)
+{
+    BufferPoolEntry *last = cache->entries, *first, *end;
+    int i;
+
+    for (i = 1; i < keep; i++)
+        last = last->next;
+    first      = last->next;
+    last->next = NULL;
+    cache->nb_entries = keep;
+
+    for (end = first; end->next; end = end->next)
+        ;
+
+    ff_mutex_lock(&pool->mutex);
+    end->next  = pool->pool;
+    pool->pool = first;
+    ff_mutex_unlock(&pool->mutex);
+}
+
+/* take one entry from the cache, refilling it from the shared list when it
+ * is empty; must be called with the cache locked */
+static BufferPoolEntry *cache_get(AVBufferPool *pool, BufferPoolCache *cache)
+{
+    BufferPoolEntry *buf = cache->entries;
+    int i;
+
+    if (!buf) {
+        ff_mutex_lock(&pool->mutex);
+        buf = pool->pool;
+        if (buf) {
+            BufferPoolEntry *last = buf;
+
+            for (i = 1; i < BUFFER_POOL_CACHE_SIZE / 2 && last->next; i++)
+                last = last->next;
+            pool->pool = last->next;
+            last->next = NULL;
+            cache->nb_entries = i;
+        }
+        ff_mutex_unlock(&pool->mutex);
+        if (!buf)
+            return NULL;
+    }
+
+    cache->entries = buf->next;
+    cache->nb_entries--;
+    buf->next = NULL;
+
+    return buf;
+}
+
+static void cache_put(AVBufferPool *pool, BufferPoolCache *cache,
+                      BufferPoolEntry *buf)
+{
+    ff_mutex_lock(&cache->mutex);
+    if (cache->nb_entries >= BUFFER_POOL_CACHE_SIZE)
+        flush_cache(pool, cache, BUFFER_POOL_CACHE_SIZE / 2);
+    buf->next      = cache->entries;
+    cache->entries = buf;
+    cache->nb_entries++;
+    ff_mutex_unlock(&cache->mutex);
+}
 #endif
 
 static void pool_release_buffer(void *opaque, uint8_t *data)
@@ -309,10 +403,7 @@ static void pool_release_buffer(void *opaque, uint8_t *data)
 #if USE_ATOMICS
     add_to_pool(buf);
 #else
-    ff_mutex_lock(&pool->mutex);
-    buf->next = pool->pool;
-    pool->pool = buf;
-    ff_mutex_unlock(&pool->mutex);
+    cache_put(pool, get_cache(pool), buf);
 #endif
 
     if (!avpriv_atomic_int_add_and_fetch(&pool->refcount, -1))
@@ -356,6 +447,10 @@ AVBufferRef *av_buffer_pool_get(AVBufferPool *pool)
 {
     AVBufferRef *ret;
     BufferPoolEntry *buf;
+#if !USE_ATOMICS
+    BufferPoolCache *cache = get_cache(pool);
+    int i;
+#endif
 
 #if USE_ATOMICS
     /* check whether the pool is empty */
@@ -380,19 +475,34 @@ AVBufferRef *av_buffer_pool_get(AVBufferPool *pool)
         return NULL;
     }
 #else
-    ff_mutex_lock(&pool->mutex);
-    buf = pool->pool;
+    ff_mutex_lock(&cache->mutex);
+    buf = cache_get(pool, cache);
+    ff_mutex_unlock(&cache->mutex);
+
+    /* before allocating, look for buffers parked in other threads' caches */
+    for (i = 0; !buf && i < BUFFER_POOL_CACHES; i++) {
+        BufferPoolCache *c = &pool->caches[i];
+
+        if (c == cache)
+            continue;
+        ff_mutex_lock(&c->mutex);
+        if (c->entries) {
+            buf = c->entries;
+            c->entries = buf->next;
+            c->nb_entries--;
+            buf->next = NULL;
+        }
+        ff_mutex_unlock(&c->mutex);
+    }
+
     if (buf) {
         ret = av_buffer_create(buf->data, pool->size, pool_release_buffer,
                                buf, 0);
-        if (ret) {
-            pool->pool = buf->next;
-            buf->next = NULL;
-        }
+        if (!ret)
+            cache_put(pool, cache, buf);
     } else {
         ret = pool_alloc_buffer(pool);
     }
-    ff_mutex_unlock(&pool->mutex);
 #endif
 
     if (ret)
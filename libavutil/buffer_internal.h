@@ -72,9 +72,29 @@ typedef struct BufferPoolEntry {
     struct BufferPoolEntry *next;
 } BufferPoolEntry;
 
+/**
+ * Number of per-thread caches in front of the shared list of a pool.
+ */
+#define BUFFER_POOL_CACHES     8
+/**
+ * Maximum number of entries held by one cache. When a full cache gets
+ * another buffer back, half of it is moved to the shared list at once.
+ */
+#define BUFFER_POOL_CACHE_SIZE 8
+
+typedef struct BufferPoolCache {
+    AVMutex mutex;
+    BufferPoolEntry *entries;
+    int nb_entries;
+
+    /* keep the caches of different threads on different cache lines */
+    uint8_t padding[64];
+} BufferPoolCache;
+
 struct AVBufferPool {
     AVMutex mutex;
     BufferPoolEntry *pool;
+    BufferPoolCache caches[BUFFER_POOL_CACHES];
 
     /*
      * This is used to track when the pool is to be freed.
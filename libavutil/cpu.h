@@ -54,6 +54,8 @@
 #define AV_CPU_FLAG_FMA3        0x10000 ///< Haswell FMA3 functions
 #define AV_CPU_FLAG_BMI1        0x20000 ///< Bit Manipulation Instruction Set 1
 #define AV_CPU_FLAG_BMI2        0x40000 ///< Bit Manipulation Instruction Set 2
+#define AV_CPU_FLAG_SHA         0x80000 ///< SHA-1/SHA-256 instructions
+#define AV_CPU_FLAG_CLMUL      0x100000 ///< carry-less multiplication (PCLMULQDQ)
 
 #define AV_CPU_FLAG_ALTIVEC      0x0001 ///< standard
 
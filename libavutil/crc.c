@@ -23,6 +23,41 @@
 #include "bswap.h"
 #include "crc.h"
 
+#if ARCH_X86
+#include "thread.h"
+#include "x86/crc.h"
+#endif
+
+static const struct {
+    uint8_t  le;
+    uint8_t  bits;
+    uint32_t poly;
+} av_crc_table_params[AV_CRC_MAX] = {
+    [AV_CRC_8_ATM]      = { 0,  8,       0x07 },
+    [AV_CRC_16_ANSI]    = { 0, 16,     0x8005 },
+    [AV_CRC_16_CCITT]   = { 0, 16,     0x1021 },
+    [AV_CRC_24_IEEE]    = { 0, 24,   0x864CFB },
+    [AV_CRC_32_IEEE]    = { 0, 32, 0x04C11DB7 },
+    [AV_CRC_32_IEEE_LE] = { 1, 32, 0xEDB88320 },
+    [AV_CRC_16_ANSI_LE] = { 1, 16,     0xA001 },
+};
+
+#if ARCH_X86
+static FFCRCFold av_crc_fold[AV_CRC_MAX];
+static AVOnce av_crc_fold_once = AV_ONCE_INIT;
+
+static av_cold void crc_fold_init(void)
+{
+    int id;
+
+    for (id = 0; id < AV_CRC_MAX; id++)
+        ff_crc_fold_init_x86(&av_crc_fold[id],
+                             av_crc_table_params[id].le,
+                             av_crc_table_params[id].bits,
+                             av_crc_table_params[id].poly);
+}
+#endif
+
 #if CONFIG_HARDCODED_TABLES
 static const AVCRC av_crc_table[AV_CRC_MAX][257] = {
     [AV_CRC_8_ATM] = {
@@ -290,20 +325,11 @@ static const AVCRC av_crc_table[AV_CRC_MAX][257] = {
 #else
 #define CRC_TABLE_SIZE 1024
 #endif
-static struct {
-    uint8_t  le;
-    uint8_t  bits;
-    uint32_t poly;
-} av_crc_table_params[AV_CRC_MAX] = {
-    [AV_CRC_8_ATM]      = { 0,  8,       0x07 },
-    [AV_CRC_16_ANSI]    = { 0, 16,     0x8005 },
-    [AV_CRC_16_CCITT]   = { 0, 16,     0x1021 },
-    [AV_CRC_24_IEEE]    = { 0, 24,   0x864CFB },
-    [AV_CRC_32_IEEE]    = { 0, 32, 0x04C11DB7 },
-    [AV_CRC_32_IEEE_LE] = { 1, 32, 0xEDB88320 },
-    [AV_CRC_16_ANSI_LE] = { 1, 16,     0xA001 },
-};
 static AVCRC av_crc_table[AV_CRC_MAX][CRC_TABLE_SIZE];
+#if !CONFIG_SMALL
+/* tables 4 to 7 for the standard CRCs, used to process 8 bytes at a time */
+static AVCRC av_crc_table_ext[AV_CRC_MAX][1024];
+#endif
 #endif
 
 int av_crc_init(AVCRC *ctx, int le, int bits, uint32_t poly, int ctx_size)
@@ -342,13 +368,31 @@ int av_crc_init(AVCRC *ctx, int le, int bits, uint32_t poly, int ctx_size)
 const AVCRC *av_crc_get_table(AVCRCId crc_id)
 {
 #if !CONFIG_HARDCODED_TABLES
-    if (!av_crc_table[crc_id][FF_ARRAY_ELEMS(av_crc_table[crc_id]) - 1])
+    if (!av_crc_table[crc_id][FF_ARRAY_ELEMS(av_crc_table[crc_id]) - 1]) {
         if (av_crc_init(av_crc_table[crc_id],
                         av_crc_table_params[crc_id].le,
                         av_crc_table_params[crc_id].bits,
                         av_crc_table_params[crc_id].poly,
                         sizeof(av_crc_table[crc_id])) < 0)
             return NULL;
+#if !CONFIG_SMALL
+        {
+            const AVCRC *ctx = av_crc_table[crc_id];
+            AVCRC *ext = av_crc_table_ext[crc_id];
+            int i, j;
+
+            for (i = 0; i < 256; i++)
+                ext[i] = (ctx[768 + i] >> 8) ^ ctx[ctx[768 + i] & 0xFF];
+            for (j = 1; j < 4; j++)
+                for (i = 0; i < 256; i++)
+                    ext[256 * j + i] =
+                        (ext[256 * (j - 1) + i] >> 8) ^ ctx[ext[256 * (j - 1) + i] & 0xFF];
+        }
+#endif
+    }
+#endif
+#if ARCH_X86
+    ff_thread_once(&av_crc_fold_once, crc_fold_init);
 #endif
     return av_crc_table[crc_id];
 }
@@ -356,13 +400,58 @@ const AVCRC *av_crc_get_table(AVCRCId crc_id)
 uint32_t av_crc(const AVCRC *ctx, uint32_t crc,
                 const uint8_t *buffer, size_t length)
 {
-    const uint8_t *end = buffer + length;
+    const uint8_t *end;
+
+#if ARCH_X86
+    /* fold the bulk of the data for the standard CRCs, and finish with a
+     * 16 byte block of the same CRC */
+    if (length >= 64 &&
+        ctx >= av_crc_table[0] && ctx < av_crc_table[AV_CRC_MAX] &&
+        (ctx - av_crc_table[0]) % FF_ARRAY_ELEMS(av_crc_table[0]) == 0) {
+        const FFCRCFold *f = &av_crc_fold[(ctx - av_crc_table[0]) /
+                                          FF_ARRAY_ELEMS(av_crc_table[0])];
+
+        if (f->fold) {
+            uint8_t block[16];
+
+            f->fold(f, crc, buffer, length >> 4, block);
+            crc     = av_crc(ctx, 0, block, 16);
+            buffer += length & ~15;
+            length &= 15;
+        }
+    }
+#endif
+    end = buffer + length;
 
 #if !CONFIG_SMALL
     if (!ctx[256]) {
         while (((intptr_t) buffer & 3) && buffer < end)
             crc = ctx[((uint8_t) crc) ^ *buffer++] ^ (crc >> 8);
 
+#if !CONFIG_HARDCODED_TABLES
+        /* the standard tables have 4 more tables stored separately */
+        if (ctx >= av_crc_table[0] && ctx < av_crc_table[AV_CRC_MAX] &&
+            (ctx - av_crc_table[0]) % CRC_TABLE_SIZE == 0) {
+            const AVCRC *ext = av_crc_table_ext[(ctx - av_crc_table[0]) / CRC_TABLE_SIZE];
+
+            if (ext[1023]) {
+                while (buffer < end - 7) {
+                    uint32_t a = crc ^ av_le2ne32(*(const uint32_t *) buffer);
+                    uint32_t b =       av_le2ne32(*(const uint32_t *)(buffer + 4));
+                    buffer += 8;
+                    crc = ext[3 * 256 + ( a        & 0xFF)] ^
+                          ext[2 * 256 + ((a >> 8 ) & 0xFF)] ^
+                          ext[1 * 256 + ((a >> 16) & 0xFF)] ^
+                          ext[0 * 256 + ((a >> 24)       )] ^
+                          ctx[3 * 256 + ( b        & 0xFF)] ^
+                          ctx[2 * 256 + ((b >> 8 ) & 0xFF)] ^
+                          ctx[1 * 256 + ((b >> 16) & 0xFF)] ^
+                          ctx[0 * 256 + ((b >> 24)       )];
+                }
+            }
+        }
+#endif
+
         while (buffer < end - 3) {
             crc ^= av_le2ne32(*(const uint32_t *) buffer); buffer += 4;
             crc = ctx[3 * 256 + ( crc        & 0xFF)] ^
@@ -26,11 +26,120 @@
 #include "mem.h"
 #include "bprint.h"
 
+/**
+ * Dictionaries with at least this many entries get a hash index to look up
+ * exact keys without scanning all the entries.
+ */
+#define INDEX_MIN_COUNT 16
+
+typedef struct DictIndexEntry {
+    unsigned hash;      ///< case-folded hash of the key
+    int elem;           ///< index of the entry in elems, -1 for an empty slot
+} DictIndexEntry;
+
 struct AVDictionary {
     int count;
     AVDictionaryEntry *elems;
+    DictIndexEntry *index;  ///< open addressing hash table, may be NULL
+    int index_size;         ///< number of slots in index, a power of 2
 };
 
+static unsigned hash_key(const char *key)
+{
+    unsigned hash = 0;
+
+    while (*key)
+        hash = hash * 33 + av_toupper(*key++);
+    return hash;
+}
+
+static void index_insert(AVDictionary *m, unsigned hash, int elem)
+{
+    unsigned mask = m->index_size - 1, i;
+
+    for (i = hash & mask; m->index[i].elem >= 0; i = (i + 1) & mask)
+        ;
+    m->index[i].hash = hash;
+    m->index[i].elem = elem;
+}
+
+static unsigned index_find(const AVDictionary *m, int elem)
+{
+    unsigned mask = m->index_size - 1, i;
+
+    for (i = hash_key(m->elems[elem].key) & mask; m->index[i].elem != elem; i = (i + 1) & mask)
+        ;
+    return i;
+}
+
+/**
+ * Remove a slot, moving back the following entries of the probe sequence
+ * which would otherwise become unreachable.
+ */
+static void index_remove(AVDictionary *m, unsigned i)
+{
+    unsigned mask = m->index_size - 1, j, k;
+
+    for (j = (i + 1) & mask; m->index[j].elem >= 0; j = (j + 1) & mask) {
+        k = m->index[j].hash & mask;
+        if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+            continue;
+        m->index[i] = m->index[j];
+        i = j;
+    }
+    m->index[i].elem = -1;
+}
+
+/**
+ * Make room in the index for one more entry, creating or growing it as
+ * needed. Without an index the dictionary is simply scanned, so failing
+ * to allocate it is not an error.
+ */
+static void index_grow(AVDictionary *m)
+{
+    DictIndexEntry *index;
+    int i, size;
+
+    if (!m->index && m->count + 1 < INDEX_MIN_COUNT)
+        return;
+    if (m->index && 2 * (m->count + 1) <= m->index_size)
+        return;
+
+    size = FFMAX(2 * INDEX_MIN_COUNT, m->index_size * 2);
+    while (size < 2 * (m->count + 1))
+        size *= 2;
+    if (!(index = av_malloc_array(size, sizeof(*index)))) {
+        av_freep(&m->index);
+        m->index_size = 0;
+        return;
+    }
+    for (i = 0; i < size; i++)
+        index[i].elem = -1;
+
+    av_free(m->index);
+    m->index      = index;
+    m->index_size = size;
+    for (i = 0; i < m->count; i++)
+        index_insert(m, hash_key(m->elems[i].key), i);
+}
+
+static int key_match(const char *s, const char *key, int flags)
+{
+    unsigned j;
+
+    if (flags & AV_DICT_MATCH_CASE)
+        for (j = 0; s[j] == key[j] && key[j]; j++)
+            ;
+    else
+        for (j = 0; av_toupper(s[j]) == av_toupper(key[j]) && key[j]; j++)
+            ;
+    if (key[j])
+        return 0;
+    if (s[j] && !(flags & AV_DICT_IGNORE_SUFFIX))
+        return 0;
+    return 1;
+}
+
 int av_dict_count(const AVDictionary *m)
 {
     return m ? m->count : 0;
@@ -39,7 +148,7 @@ int av_dict_count(const AVDictionary *m)
 AVDictionaryEntry *av_dict_get(const AVDictionary *m, const char *key,
                                const AVDictionaryEntry *prev, int flags)
 {
-    unsigned int i, j;
+    unsigned int i;
 
     if (!m)
         return NULL;
@@ -49,19 +158,25 @@ AVDictionaryEntry *av_dict_get(const AVDictionary *m, const char *key,
     else
         i = 0;
 
+    if (m->index && !(flags & AV_DICT_IGNORE_SUFFIX)) {
+        /* all the keys equal to key up to the case share its hash, return
+         * the first matching one after prev */
+        unsigned mask = m->index_size - 1, hash = hash_key(key), slot;
+        int best = -1;
+
+        for (slot = hash & mask; m->index[slot].elem >= 0; slot = (slot + 1) & mask) {
+            int elem = m->index[slot].elem;
+            if (m->index[slot].hash == hash && elem >= i &&
+                (best < 0 || elem < best) &&
+                key_match(m->elems[elem].key, key, flags))
+                best = elem;
+        }
+        return best >= 0 ? &m->elems[best] : NULL;
+    }
+
     for (; i < m->count; i++) {
-        const char *s = m->elems[i].key;
-        if (flags & AV_DICT_MATCH_CASE)
-            for (j = 0; s[j] == key[j] && key[j]; j++)
-                ;
-        else
-            for (j = 0; av_toupper(s[j]) == av_toupper(key[j]) && key[j]; j++)
-                ;
-        if (key[j])
-            continue;
-        if (s[j] && !(flags & AV_DICT_IGNORE_SUFFIX))
-            continue;
-        return &m->elems[i];
+        if (key_match(m->elems[i].key, key, flags))
+            return &m->elems[i];
     }
     return NULL;
 }
@@ -96,6 +211,12 @@ int av_dict_set(AVDictionary **pm, const char *key, const char *value,
             oldval = tag->value;
         else
             av_free(tag->value);
+        if (m->index) {
+            int elem = tag - m->elems;
+            index_remove(m, index_find(m, elem));
+            if (elem != m->count - 1)
+                m->index[index_find(m, m->count - 1)].elem = elem;
+        }
         av_free(tag->key);
         *tag = m->elems[--m->count];
     } else {
@@ -119,12 +240,16 @@ int av_dict_set(AVDictionary **pm, const char *key, const char *value,
             m->elems[m->count].value = newval;
             av_freep(&copy_value);
         }
+        index_grow(m);
+        if (m->index)
+            index_insert(m, hash_key(copy_key), m->count);
         m->count++;
     } else {
         av_freep(&copy_key);
     }
     if (!m->count) {
         av_freep(&m->elems);
+        av_freep(&m->index);
         av_freep(pm);
     }
 
@@ -133,6 +258,7 @@ int av_dict_set(AVDictionary **pm, const char *key, const char *value,
 err_out:
     if (m && !m->count) {
         av_freep(&m->elems);
+        av_freep(&m->index);
         av_freep(pm);
     }
     av_free(copy_key);
@@ -206,6 +332,7 @@ void av_dict_free(AVDictionary **pm)
             av_freep(&m->elems[m->count].value);
         }
         av_freep(&m->elems);
+        av_freep(&m->index);
     }
     av_freep(pm);
 }
@@ -278,6 +405,8 @@ int main(void)
     AVDictionary *dict = NULL;
     AVDictionaryEntry *e;
     char *buffer = NULL;
+    char key[16];
+    int i, found;
 
     printf("Testing av_dict_get_string() and av_dict_parse_string()\n");
     av_dict_get_string(dict, &buffer, '=', ',');
@@ -356,6 +485,37 @@ int main(void)
     printf("%s\n", e->value);
     av_dict_free(&dict);
 
+    printf("\nTesting av_dict_get() on a large dictionary\n");
+    for (i = 0; i < 100; i++) {
+        snprintf(key, sizeof(key), "key%d", i);
+        av_dict_set_int(&dict, key, i, 0);
+    }
+    for (i = 0; i < 100; i += 3) {
+        snprintf(key, sizeof(key), "key%d", i);
+        av_dict_set(&dict, key, NULL, 0);
+    }
+    for (i = 1; i < 100; i += 7) {
+        snprintf(key, sizeof(key), "key%d", i);
+        av_dict_set_int(&dict, key, 10 * i, 0);
+    }
+    av_dict_set(&dict, "KEY1", "upper", AV_DICT_MATCH_CASE);
+    printf("count %d\n", av_dict_count(dict));
+    found = 0;
+    e = NULL;
+    while ((e = av_dict_get(dict, "", e, AV_DICT_IGNORE_SUFFIX)))
+        found += av_dict_get(dict, e->key, NULL, AV_DICT_MATCH_CASE) == e;
+    printf("found %d\n", found);
+    e = NULL;
+    while ((e = av_dict_get(dict, "Key1", e, 0)))
+        printf("%s %s\n", e->key, e->value);
+    e = av_dict_get(dict, "KEY1", NULL, AV_DICT_MATCH_CASE);
+    printf("%s %s\n", e->key, e->value);
+    e = av_dict_get(dict, "key3", NULL, 0);
+    printf("key3 %s\n", e ? e->value : "(null)");
+    e = av_dict_get(dict, "key9", NULL, 0);
+    printf("key9 %s\n", e ? e->value : "(null)");
+    av_dict_free(&dict);
+
     return 0;
 }
 #endif
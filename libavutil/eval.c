@@ -649,6 +649,59 @@ static int verify_expr(AVExpr *e)
     }
 }
 
+/**
+ * Return 1 if the node does not depend on the constants, the variables,
+ * the opaque pointer or any other state, and can thus be computed once
+ * at parse time.
+ */
+static int is_pure_expr(const AVExpr *e)
+{
+    switch (e->type) {
+    case e_const:
+    case e_func1:
+    case e_func2:
+    case e_ld:
+    case e_st:
+    case e_random:
+    case e_print:
+    case e_while:
+    case e_taylor:
+    case e_root:
+        return 0;
+    case e_func0:
+        return e->a.func0 != etime;
+    default:
+        return 1;
+    }
+}
+
+/**
+ * Replace all the subtrees which only have constant leaves with a single
+ * value node, so that they are not recomputed at each evaluation.
+ */
+static void fold_expr(AVExpr *e)
+{
+    int i, foldable = is_pure_expr(e);
+
+    for (i = 0; i < 3; i++) {
+        if (!e->param[i])
+            continue;
+        fold_expr(e->param[i]);
+        if (e->param[i]->type != e_value)
+            foldable = 0;
+    }
+
+    if (foldable && e->type != e_value) {
+        Parser p = { 0 };
+        e->value = eval_expr(&p, e);
+        e->type  = e_value;
+        for (i = 0; i < 3; i++) {
+            av_expr_free(e->param[i]);
+            e->param[i] = NULL;
+        }
+    }
+}
+
 int av_expr_parse(AVExpr **expr, const char *s,
                   const char * const *const_names,
                   const char * const *func1_names, double (* const *funcs1)(void *, double),
@@ -691,6 +744,7 @@ int av_expr_parse(AVExpr **expr, const char *s,
         ret = AVERROR(EINVAL);
         goto end;
     }
+    fold_expr(e);
     e->var= av_mallocz(sizeof(double) *VARS);
     if (!e->var) {
         ret = AVERROR(ENOMEM);
@@ -56,6 +56,22 @@ static void vector_dmul_scalar_c(double *dst, const double *src, double mul,
         dst[i] = src[i] * mul;
 }
 
+static void vector_dmul_c(double *dst, const double *src0, const double *src1,
+                          int len)
+{
+    int i;
+    for (i = 0; i < len; i++)
+        dst[i] = src0[i] * src1[i];
+}
+
+static void vector_dmac_scalar_c(double *dst, const double *src, double mul,
+                                 int len)
+{
+    int i;
+    for (i = 0; i < len; i++)
+        dst[i] += src[i] * mul;
+}
+
 static void vector_fmul_window_c(float *dst, const float *src0,
                                  const float *src1, const float *win, int len)
 {
@@ -116,6 +132,18 @@ float avpriv_scalarproduct_float_c(const float *v1, const float *v2, int len)
     return p;
 }
 
+static double scalarproduct_double_c(const double *v1, const double *v2,
+                                     int len)
+{
+    double p = 0.0;
+    int i;
+
+    for (i = 0; i < len; i++)
+        p += v1[i] * v2[i];
+
+    return p;
+}
+
 av_cold void avpriv_float_dsp_init(AVFloatDSPContext *fdsp, int bit_exact)
 {
     fdsp->vector_fmul = vector_fmul_c;
@@ -127,6 +155,9 @@ av_cold void avpriv_float_dsp_init(AVFloatDSPContext *fdsp, int bit_exact)
     fdsp->vector_fmul_reverse = vector_fmul_reverse_c;
     fdsp->butterflies_float = butterflies_float_c;
     fdsp->scalarproduct_float = avpriv_scalarproduct_float_c;
+    fdsp->vector_dmul = vector_dmul_c;
+    fdsp->vector_dmac_scalar = vector_dmac_scalar_c;
+    fdsp->scalarproduct_double = scalarproduct_double_c;
 
     if (ARCH_AARCH64)
         ff_float_dsp_init_aarch64(fdsp);
@@ -292,6 +323,42 @@ static int test_vector_dmul_scalar(AVFloatDSPContext *fdsp, AVFloatDSPContext *c
     return ret;
 }
 
+static int test_vector_dmul(AVFloatDSPContext *fdsp, AVFloatDSPContext *cdsp,
+                            const double *v1, const double *v2)
+{
+    LOCAL_ALIGNED(32, double, cdst, [LEN]);
+    LOCAL_ALIGNED(32, double, odst, [LEN]);
+    int ret;
+
+    cdsp->vector_dmul(cdst, v1, v2, LEN);
+    fdsp->vector_dmul(odst, v1, v2, LEN);
+
+    if (ret = compare_doubles(cdst, odst, LEN, DBL_EPSILON))
+        av_log(NULL, AV_LOG_ERROR, "vector_dmul failed\n");
+
+    return ret;
+}
+
+#define ARBITRARY_DMAC_SCALAR_CONST 0.005
+static int test_vector_dmac_scalar(AVFloatDSPContext *fdsp, AVFloatDSPContext *cdsp,
+                                   const double *v1, const double *src0, double scale)
+{
+    LOCAL_ALIGNED(32, double, cdst, [LEN]);
+    LOCAL_ALIGNED(32, double, odst, [LEN]);
+    int ret;
+
+    memcpy(cdst, v1, LEN * sizeof(*v1));
+    memcpy(odst, v1, LEN * sizeof(*v1));
+
+    cdsp->vector_dmac_scalar(cdst, src0, scale, LEN);
+    fdsp->vector_dmac_scalar(odst, src0, scale, LEN);
+
+    if (ret = compare_doubles(cdst, odst, LEN, ARBITRARY_DMAC_SCALAR_CONST))
+        av_log(NULL, AV_LOG_ERROR, "vector_dmac_scalar failed\n");
+
+    return ret;
+}
+
 #define ARBITRARY_FMUL_WINDOW_CONST 0.008
 static int test_vector_fmul_window(AVFloatDSPContext *fdsp, AVFloatDSPContext *cdsp,
                                    const float *v1, const float *v2, const float *v3)
@@ -382,6 +449,22 @@ static int test_scalarproduct_float(AVFloatDSPContext *fdsp, AVFloatDSPContext *
     return ret;
 }
 
+#define ARBITRARY_SCALARPRODUCT_DOUBLE_CONST 1e-8
+static int test_scalarproduct_double(AVFloatDSPContext *fdsp, AVFloatDSPContext *cdsp,
+                                     const double *v1, const double *v2)
+{
+    double cprod, oprod;
+    int ret;
+
+    cprod = cdsp->scalarproduct_double(v1, v2, LEN);
+    oprod = fdsp->scalarproduct_double(v1, v2, LEN);
+
+    if (ret = compare_doubles(&cprod, &oprod, 1, ARBITRARY_SCALARPRODUCT_DOUBLE_CONST))
+        av_log(NULL, AV_LOG_ERROR, "scalarproduct_double failed\n");
+
+    return ret;
+}
+
 int main(int argc, char **argv)
 {
     int ret = 0, seeded = 0;
@@ -394,6 +477,7 @@ int main(int argc, char **argv)
     LOCAL_ALIGNED(32, float, src2, [LEN]);
     LOCAL_ALIGNED(32, double, dbl_src0, [LEN]);
     LOCAL_ALIGNED(32, double, dbl_src1, [LEN]);
+    LOCAL_ALIGNED(32, double, dbl_src2, [LEN]);
 
     for (;;) {
         int arg = getopt(argc, argv, "s:c:");
@@ -429,6 +513,7 @@ int main(int argc, char **argv)
 
     fill_double_array(&lfg, dbl_src0, LEN);
     fill_double_array(&lfg, dbl_src1, LEN);
+    fill_double_array(&lfg, dbl_src2, LEN);
 
     avpriv_float_dsp_init(&fdsp, 1);
     av_set_cpu_flags_mask(0);
@@ -452,6 +537,12 @@ int main(int argc, char **argv)
         ret -= 1 << 7;
     if (test_vector_dmul_scalar(&fdsp, &cdsp, dbl_src0, dbl_src1[0]))
         ret -= 1 << 8;
+    if (test_vector_dmul(&fdsp, &cdsp, dbl_src0, dbl_src1))
+        ret -= 1 << 9;
+    if (test_vector_dmac_scalar(&fdsp, &cdsp, dbl_src2, dbl_src0, dbl_src1[0]))
+        ret -= 1 << 10;
+    if (test_scalarproduct_double(&fdsp, &cdsp, dbl_src0, dbl_src1))
+        ret -= 1 << 11;
 
     return ret;
 }
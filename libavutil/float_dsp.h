@@ -157,6 +157,52 @@ typedef struct AVFloatDSPContext {
      * @return sum of elementwise products
      */
     float (*scalarproduct_float)(const float *v1, const float *v2, int len);
+
+    /**
+     * Calculate the product of two vectors of doubles and store the result in
+     * a vector of doubles.
+     *
+     * @param dst  output vector
+     *             constraints: 32-byte aligned
+     * @param src0 first input vector
+     *             constraints: 32-byte aligned
+     * @param src1 second input vector
+     *             constraints: 32-byte aligned
+     * @param len  number of elements in the input
+     *             constraints: multiple of 8
+     */
+    void (*vector_dmul)(double *dst, const double *src0, const double *src1,
+                        int len);
+
+    /**
+     * Multiply a vector of doubles by a scalar double and add to
+     * destination vector.  Source and destination vectors must
+     * overlap exactly or not at all.
+     *
+     * @param dst result vector
+     *            constraints: 32-byte aligned
+     * @param src input vector
+     *            constraints: 32-byte aligned
+     * @param mul scalar value
+     * @param len length of vector
+     *            constraints: multiple of 8
+     */
+    void (*vector_dmac_scalar)(double *dst, const double *src, double mul,
+                               int len);
+
+    /**
+     * Calculate the scalar product of two vectors of doubles.
+     *
+     * @param v1  first vector
+     *            constraints: 32-byte aligned
+     * @param v2  second vector
+     *            constraints: 32-byte aligned
+     * @param len length of vectors
+     *            constraints: multiple of 8
+     *
+     * @return sum of elementwise products
+     */
+    double (*scalarproduct_double)(const double *v1, const double *v2, int len);
 } AVFloatDSPContext;
 
 /**
@@ -30,6 +30,7 @@
 #include "mathematics.h"
 #include "pixdesc.h"
 #include "rational.h"
+#include "x86/imgutils.h"
 
 void av_image_fill_max_pixsteps(int max_pixsteps[4], int max_pixstep_comps[4],
                                 const AVPixFmtDescriptor *pixdesc)
@@ -270,14 +271,22 @@ int av_image_check_sar(unsigned int w, unsigned int h, AVRational sar)
     return AVERROR(EINVAL);
 }
 
-void av_image_copy_plane(uint8_t       *dst, int dst_linesize,
-                         const uint8_t *src, int src_linesize,
-                         int bytewidth, int height)
+/* Planes of this size or bigger are not going to stay in the cache
+ * anyway, so they are written with non-temporal stores where possible. */
+#define NT_COPY_MIN_SIZE (8 << 20)
+
+static void image_copy_plane(uint8_t       *dst, int dst_linesize,
+                             const uint8_t *src, int src_linesize,
+                             int bytewidth, int height, int nt)
 {
     if (!dst || !src)
         return;
     av_assert0(abs(src_linesize) >= bytewidth);
     av_assert0(abs(dst_linesize) >= bytewidth);
+    if (ARCH_X86 && nt &&
+        !ff_image_copy_plane_nt_x86(dst, dst_linesize, src, src_linesize,
+                                    bytewidth, height))
+        return;
     for (;height > 0; height--) {
         memcpy(dst, src, bytewidth);
         dst += dst_linesize;
@@ -285,43 +294,202 @@ void av_image_copy_plane(uint8_t       *dst, int dst_linesize,
     }
 }
 
+void av_image_copy_plane(uint8_t       *dst, int dst_linesize,
+                         const uint8_t *src, int src_linesize,
+                         int bytewidth, int height)
+{
+    image_copy_plane(dst, dst_linesize, src, src_linesize, bytewidth, height,
+                     (int64_t)bytewidth * height >= NT_COPY_MIN_SIZE);
+}
+
+/**
+ * Compute the size of the planes to copy for an image.
+ *
+ * @return the number of planes, or a negative value on error
+ */
+static int image_copy_get_planes(const AVPixFmtDescriptor *desc,
+                                 enum AVPixelFormat pix_fmt,
+                                 int width, int height,
+                                 int bytewidths[4], int heights[4])
+{
+    int i, planes_nb = 0;
+
+    if (desc->flags & AV_PIX_FMT_FLAG_PAL ||
+        desc->flags & AV_PIX_FMT_FLAG_PSEUDOPAL) {
+        bytewidths[0] = width;
+        heights[0]    = height;
+        return 1;
+    }
+
+    for (i = 0; i < desc->nb_components; i++)
+        planes_nb = FFMAX(planes_nb, desc->comp[i].plane + 1);
+
+    for (i = 0; i < planes_nb; i++) {
+        int h = height;
+        int bwidth = av_image_get_linesize(pix_fmt, width, i);
+        if (bwidth < 0) {
+            av_log(NULL, AV_LOG_ERROR, "av_image_get_linesize failed\n");
+            return bwidth;
+        }
+        if (i == 1 || i == 2) {
+            h = FF_CEIL_RSHIFT(height, desc->log2_chroma_h);
+        }
+        bytewidths[i] = bwidth;
+        heights[i]    = h;
+    }
+
+    return planes_nb;
+}
+
 void av_image_copy(uint8_t *dst_data[4], int dst_linesizes[4],
                    const uint8_t *src_data[4], const int src_linesizes[4],
                    enum AVPixelFormat pix_fmt, int width, int height)
 {
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(pix_fmt);
+    int i, planes_nb, bytewidths[4], heights[4];
 
     if (!desc || desc->flags & AV_PIX_FMT_FLAG_HWACCEL)
         return;
 
+    planes_nb = image_copy_get_planes(desc, pix_fmt, width, height,
+                                      bytewidths, heights);
+    for (i = 0; i < planes_nb; i++)
+        av_image_copy_plane(dst_data[i], dst_linesizes[i],
+                            src_data[i], src_linesizes[i],
+                            bytewidths[i], heights[i]);
+
     if (desc->flags & AV_PIX_FMT_FLAG_PAL ||
         desc->flags & AV_PIX_FMT_FLAG_PSEUDOPAL) {
-        av_image_copy_plane(dst_data[0], dst_linesizes[0],
-                            src_data[0], src_linesizes[0],
-                            width, height);
         /* copy the palette */
         memcpy(dst_data[1], src_data[1], 4*256);
-    } else {
-        int i, planes_nb = 0;
-
-        for (i = 0; i < desc->nb_components; i++)
-            planes_nb = FFMAX(planes_nb, desc->comp[i].plane + 1);
-
-        for (i = 0; i < planes_nb; i++) {
-            int h = height;
-            int bwidth = av_image_get_linesize(pix_fmt, width, i);
-            if (bwidth < 0) {
-                av_log(NULL, AV_LOG_ERROR, "av_image_get_linesize failed\n");
-                return;
-            }
-            if (i == 1 || i == 2) {
-                h = FF_CEIL_RSHIFT(height, desc->log2_chroma_h);
+    }
+}
+
+typedef struct ImageCopyThreadData {
+    uint8_t       **dst_data;
+    const int      *dst_linesizes;
+    const uint8_t **src_data;
+    const int      *src_linesizes;
+    int planes_nb;
+    int bytewidths[4];
+    int heights[4];
+} ImageCopyThreadData;
+
+static void image_copy_slice(void *arg, int jobnr, int nb_jobs)
+{
+    ImageCopyThreadData *td = arg;
+    int i;
+
+    for (i = 0; i < td->planes_nb; i++) {
+        const int start = (td->heights[i] *  jobnr   ) / nb_jobs;
+        const int end   = (td->heights[i] * (jobnr+1)) / nb_jobs;
+
+        if (!td->dst_data[i] || !td->src_data[i])
+            continue;
+        image_copy_plane(td->dst_data[i] + start * td->dst_linesizes[i],
+                         td->dst_linesizes[i],
+                         td->src_data[i] + start * td->src_linesizes[i],
+                         td->src_linesizes[i],
+                         td->bytewidths[i], end - start,
+                         (int64_t)td->bytewidths[i] * td->heights[i] >= NT_COPY_MIN_SIZE);
+    }
+}
+
+void av_image_copy_threaded(uint8_t *dst_data[4], int dst_linesizes[4],
+                            const uint8_t *src_data[4], const int src_linesizes[4],
+                            enum AVPixelFormat pix_fmt, int width, int height,
+                            av_image_execute_fn execute, void *opaque, int nb_jobs)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(pix_fmt);
+    ImageCopyThreadData td = {
+        .dst_data      = dst_data,
+        .dst_linesizes = dst_linesizes,
+        .src_data      = src_data,
+        .src_linesizes = src_linesizes,
+    };
+
+    nb_jobs = FFMIN(nb_jobs, height);
+    if (!execute || nb_jobs < 2) {
+        av_image_copy(dst_data, dst_linesizes, src_data, src_linesizes,
+                      pix_fmt, width, height);
+        return;
+    }
+
+    if (!desc || desc->flags & AV_PIX_FMT_FLAG_HWACCEL)
+        return;
+
+    td.planes_nb = image_copy_get_planes(desc, pix_fmt, width, height,
+                                         td.bytewidths, td.heights);
+    if (td.planes_nb < 0)
+        return;
+
+    if (desc->flags & AV_PIX_FMT_FLAG_PAL ||
+        desc->flags & AV_PIX_FMT_FLAG_PSEUDOPAL) {
+        /* copy the palette */
+        memcpy(dst_data[1], src_data[1], 4*256);
+    }
+
+    execute(opaque, image_copy_slice, &td, nb_jobs);
+}
+
+/* in pixels, a block of 32x32 pixels of 8 bytes fits in the L1 cache */
+#define TRANSPOSE_BLOCK 32
+
+#define DEF_TRANSPOSE(name, type)                                           \
+static void transpose_ ## name(uint8_t       *dst, int dst_linesize,       \
+                               const uint8_t *src, int src_linesize,       \
+                               int width, int height)                      \
+{                                                                           \
+    int x, y, bx, by;                                                       \
+                                                                            \
+    for (by = 0; by < height; by += TRANSPOSE_BLOCK) {                      \
+        const int bh = FFMIN(TRANSPOSE_BLOCK, height - by);                 \
+        for (bx = 0; bx < width; bx += TRANSPOSE_BLOCK) {                   \
+            const int bw = FFMIN(TRANSPOSE_BLOCK, width - bx);              \
+            for (x = bx; x < bx + bw; x++) {                                \
+                type *d = (type *)(dst + x * dst_linesize) + by;            \
+                const uint8_t *s = src + by * src_linesize + x * sizeof(type); \
+                for (y = 0; y < bh; y++)                                    \
+                    d[y] = *(const type *)(s + y * src_linesize);           \
+            }                                                               \
+        }                                                                   \
+    }                                                                       \
+}
+
+DEF_TRANSPOSE(8,  uint8_t)
+DEF_TRANSPOSE(16, uint16_t)
+DEF_TRANSPOSE(32, uint32_t)
+DEF_TRANSPOSE(64, uint64_t)
+
+int av_image_transpose_plane(uint8_t       *dst, int dst_linesize,
+                             const uint8_t *src, int src_linesize,
+                             int width, int height, int pixel_size)
+{
+    int x, y, bx, by;
+
+    if (pixel_size <= 0 || width < 0 || height < 0)
+        return AVERROR(EINVAL);
+
+    switch (pixel_size) {
+    case 1: transpose_8 (dst, dst_linesize, src, src_linesize, width, height); break;
+    case 2: transpose_16(dst, dst_linesize, src, src_linesize, width, height); break;
+    case 4: transpose_32(dst, dst_linesize, src, src_linesize, width, height); break;
+    case 8: transpose_64(dst, dst_linesize, src, src_linesize, width, height); break;
+    default:
+        for (by = 0; by < height; by += TRANSPOSE_BLOCK) {
+            const int bh = FFMIN(TRANSPOSE_BLOCK, height - by);
+            for (bx = 0; bx < width; bx += TRANSPOSE_BLOCK) {
+                const int bw = FFMIN(TRANSPOSE_BLOCK, width - bx);
+                for (x = bx; x < bx + bw; x++)
+                    for (y = by; y < by + bh; y++)
+                        memcpy(dst + x * dst_linesize + y * pixel_size,
+                               src + y * src_linesize + x * pixel_size,
+                               pixel_size);
             }
-            av_image_copy_plane(dst_data[i], dst_linesizes[i],
-                                src_data[i], src_linesizes[i],
-                                bwidth, h);
         }
     }
+
+    return 0;
 }
 
 int av_image_fill_arrays(uint8_t *dst_data[4], int dst_linesize[4],
@@ -405,3 +573,145 @@ int av_image_copy_to_buffer(uint8_t *dst, int dst_size,
 
     return size;
 }
+
+#ifdef TEST
+
+#include <stdio.h>
+
+#include "mem.h"
+
+static void fill_pattern(uint8_t *buf, int size, unsigned seed)
+{
+    int i;
+
+    for (i = 0; i < size; i++) {
+        seed = seed * 1664525 + 1013904223;
+        buf[i] = seed >> 24;
+    }
+}
+
+static int test_transpose(int width, int height, int pixel_size, int negative)
+{
+    const int src_stride = width  * pixel_size + 5;
+    const int dst_stride = height * pixel_size + 3;
+    uint8_t *src_buf = av_malloc(src_stride * height);
+    uint8_t *dst_buf = av_mallocz(dst_stride * FFMAX(width, 1));
+    uint8_t *src, *dst;
+    int src_linesize = src_stride, dst_linesize = dst_stride;
+    int x, y, ret = -1;
+
+    if (!src_buf || !dst_buf)
+        goto end;
+    fill_pattern(src_buf, src_stride * height, width * 131 + height);
+    src = src_buf;
+    dst = dst_buf;
+    if (negative) {
+        src          += src_stride * (height - 1);
+        dst          += dst_stride * (width  - 1);
+        src_linesize  = -src_stride;
+        dst_linesize  = -dst_stride;
+    }
+    if (av_image_transpose_plane(dst, dst_linesize, src, src_linesize,
+                                 width, height, pixel_size) < 0)
+        goto end;
+    for (y = 0; y < height; y++)
+        for (x = 0; x < width; x++)
+            if (memcmp(dst + x * dst_linesize + y * pixel_size,
+                       src + y * src_linesize + x * pixel_size, pixel_size))
+                goto end;
+    ret = 0;
+end:
+    printf("transpose %dx%d, %d byte pixels%s: %s\n", width, height, pixel_size,
+           negative ? ", negative linesizes" : "", ret ? "failed" : "ok");
+    av_free(src_buf);
+    av_free(dst_buf);
+    return ret;
+}
+
+/* runs the jobs in reverse order, as a thread pool might */
+static void execute_reverse(void *opaque, void (*job)(void *arg, int jobnr, int nb_jobs),
+                            void *arg, int nb_jobs)
+{
+    int i;
+
+    for (i = nb_jobs - 1; i >= 0; i--)
+        job(arg, i, nb_jobs);
+}
+
+/* Copy an image with av_image_copy() and av_image_copy_threaded(), from a
+ * bottom-up source to a misaligned destination, and compare the planes
+ * with the source. */
+static int test_copy(enum AVPixelFormat pix_fmt, int width, int height, int nb_jobs)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(pix_fmt);
+    uint8_t *src_buf = NULL, *dst_buf = NULL;
+    uint8_t *src_data[4], *dst_data[4];
+    int src_linesizes[4], dst_linesizes[4], bytewidths[4], heights[4];
+    int i, y, pass, planes_nb, size, ret = -1;
+
+    if ((size = av_image_alloc(src_data, src_linesizes, width, height, pix_fmt, 16)) < 0)
+        goto end;
+    src_buf = src_data[0];
+    fill_pattern(src_buf, size, width + height);
+    if ((size = av_image_alloc(dst_data, dst_linesizes, width, height, pix_fmt, 16)) < 0)
+        goto end;
+    dst_buf = dst_data[0];
+
+    planes_nb = image_copy_get_planes(desc, pix_fmt, width, height, bytewidths, heights);
+    for (i = 0; i < planes_nb; i++) {
+        src_data[i]     += src_linesizes[i] * (heights[i] - 1);
+        src_linesizes[i] = -src_linesizes[i];
+        /* the lines are padded, so there is room for the offset */
+        dst_data[i]     += 1;
+    }
+
+    for (pass = 0; pass < 2; pass++) {
+        memset(dst_buf, 0, size);
+        if (pass)
+            av_image_copy_threaded(dst_data, dst_linesizes,
+                                   (const uint8_t **)src_data, src_linesizes,
+                                   pix_fmt, width, height,
+                                   execute_reverse, NULL, nb_jobs);
+        else
+            av_image_copy(dst_data, dst_linesizes,
+                          (const uint8_t **)src_data, src_linesizes,
+                          pix_fmt, width, height);
+        for (i = 0; i < planes_nb; i++)
+            for (y = 0; y < heights[i]; y++)
+                if (memcmp(dst_data[i] + y * dst_linesizes[i],
+                           src_data[i] + y * src_linesizes[i], bytewidths[i]))
+                    goto end;
+    }
+    ret = 0;
+end:
+    printf("copy %s %dx%d, %d jobs: %s\n", av_get_pix_fmt_name(pix_fmt),
+           width, height, nb_jobs, ret ? "failed" : "ok");
+    av_free(src_buf);
+    av_free(dst_buf);
+    return ret;
+}
+
+int main(void)
+{
+    static const int sizes[][2] = { { 1, 1 }, { 7, 3 }, { 33, 65 }, { 100, 37 } };
+    static const int pixel_sizes[] = { 1, 2, 3, 4, 8 };
+    int i, j, ret = 0;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(sizes); i++)
+        for (j = 0; j < FF_ARRAY_ELEMS(pixel_sizes); j++) {
+            ret |= test_transpose(sizes[i][0], sizes[i][1], pixel_sizes[j], 0);
+            ret |= test_transpose(sizes[i][0], sizes[i][1], pixel_sizes[j], 1);
+        }
+
+    ret |= test_copy(AV_PIX_FMT_YUV420P,  99, 71, 1);
+    ret |= test_copy(AV_PIX_FMT_YUV420P,  99, 71, 7);
+    ret |= test_copy(AV_PIX_FMT_NV12,    101, 33, 3);
+    ret |= test_copy(AV_PIX_FMT_RGB24,    17,  5, 8);
+    /* planes of at least 8 MiB take the non-temporal path */
+    ret |= test_copy(AV_PIX_FMT_GRAY8,  4097, 2049, 1);
+    ret |= test_copy(AV_PIX_FMT_GRAY8,  4097, 2049, 5);
+
+    return !!ret;
+}
+
+#endif /* TEST */
@@ -120,6 +120,55 @@ void av_image_copy(uint8_t *dst_data[4], int dst_linesizes[4],
                    const uint8_t *src_data[4], const int src_linesizes[4],
                    enum AVPixelFormat pix_fmt, int width, int height);
 
+/**
+ * Function type used to run jobs on a caller-provided thread pool.
+ *
+ * It must call job(arg, jobnr, nb_jobs) once for every jobnr from 0 to
+ * nb_jobs - 1, in any order and from any thread, and return once all
+ * the calls have returned.
+ *
+ * @param opaque the opaque pointer given along with the function
+ */
+typedef void (*av_image_execute_fn)(void *opaque,
+                                    void (*job)(void *arg, int jobnr, int nb_jobs),
+                                    void *arg, int nb_jobs);
+
+/**
+ * Copy image in src_data to dst_data, splitting the work in slices of
+ * lines which are run through execute.
+ *
+ * Otherwise identical to av_image_copy(), which it falls back to if
+ * execute is NULL or nb_jobs is lower than 2.
+ *
+ * @param execute function running the slices, possibly in parallel
+ * @param opaque  opaque pointer passed to execute
+ * @param nb_jobs maximum number of slices to split the image in
+ */
+void av_image_copy_threaded(uint8_t *dst_data[4], int dst_linesizes[4],
+                            const uint8_t *src_data[4], const int src_linesizes[4],
+                            enum AVPixelFormat pix_fmt, int width, int height,
+                            av_image_execute_fn execute, void *opaque, int nb_jobs);
+
+/**
+ * Transpose an image plane, so that the pixel at line y and column x of
+ * src ends up at line x and column y of dst.
+ *
+ * The copy is done in blocks small enough to be cached, so that neither
+ * the reads nor the writes walk over the whole plane with a large stride.
+ *
+ * @param dst          destination plane, width lines of height pixels
+ * @param dst_linesize linesize of dst
+ * @param src          source plane, height lines of width pixels
+ * @param src_linesize linesize of src
+ * @param width        width of src in pixels
+ * @param height       height of src in pixels
+ * @param pixel_size   size of a pixel in bytes
+ * @return 0 on success, a negative AVERROR on failure
+ */
+int av_image_transpose_plane(uint8_t       *dst, int dst_linesize,
+                             const uint8_t *src, int src_linesize,
+                             int width, int height, int pixel_size);
+
 /**
  * Setup the data pointers and linesizes based on the specified image
  * parameters and the provided array.
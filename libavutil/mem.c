@@ -25,6 +25,10 @@
  */
 
 #define _XOPEN_SOURCE 600
+/* for MADV_HUGEPAGE */
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE
+#endif
 
 #include "config.h"
 
@@ -35,6 +39,9 @@
 #if HAVE_MALLOC_H
 #include <malloc.h>
 #endif
+#if HAVE_MADVISE
+#include <sys/mman.h>
+#endif
 
 #include "avassert.h"
 #include "avutil.h"
@@ -72,6 +79,34 @@ void av_max_alloc(size_t max){
     max_alloc_size = max;
 }
 
+static int mem_flags;
+
+void av_mem_set_flags(int flags)
+{
+    mem_flags = flags;
+}
+
+int av_mem_get_flags(void)
+{
+    return mem_flags;
+}
+
+#if HAVE_MADVISE && defined(MADV_HUGEPAGE)
+#define USE_HUGEPAGES 1
+#else
+#define USE_HUGEPAGES 0
+#endif
+
+static void prefault(void *ptr, size_t size)
+{
+    volatile uint8_t *p = ptr;
+    size_t i;
+
+    /* no page is smaller than 4 KiB on the systems where it matters */
+    for (i = 0; i < size; i += 4096)
+        p[i] = 0;
+}
+
 void *av_malloc(size_t size)
 {
     void *ptr = NULL;
@@ -91,9 +126,20 @@ void *av_malloc(size_t size)
     ptr               = (char *)ptr + diff;
     ((char *)ptr)[-1] = diff;
 #elif HAVE_POSIX_MEMALIGN
-    if (size) //OS X on SDK 10.6 has a broken posix_memalign implementation
-    if (posix_memalign(&ptr, ALIGN, size))
-        ptr = NULL;
+    if (size) { //OS X on SDK 10.6 has a broken posix_memalign implementation
+        size_t align = ALIGN;
+
+        if (USE_HUGEPAGES && (mem_flags & AV_MEM_FLAG_HUGEPAGES) &&
+            size >= AV_MEM_LARGE_BLOCK)
+            align = AV_MEM_LARGE_BLOCK;
+        if (posix_memalign(&ptr, align, size))
+            ptr = NULL;
+#if USE_HUGEPAGES
+        /* only whole huge pages can be backed by one */
+        if (ptr && align == AV_MEM_LARGE_BLOCK)
+            madvise(ptr, size & ~(size_t)(AV_MEM_LARGE_BLOCK - 1), MADV_HUGEPAGE);
+#endif
+    }
 #elif HAVE_ALIGNED_MALLOC
     ptr = _aligned_malloc(size, ALIGN);
 #elif HAVE_MEMALIGN
@@ -133,6 +179,8 @@ void *av_malloc(size_t size)
         size = 1;
         ptr= av_malloc(1);
     }
+    if (ptr && (mem_flags & AV_MEM_FLAG_PREFAULT) && size >= AV_MEM_LARGE_BLOCK)
+        prefault(ptr, size);
 #if CONFIG_MEMORY_POISONING
     if (ptr)
         memset(ptr, FF_MEMORY_POISON, size);
@@ -350,6 +350,54 @@ static inline int av_size_mult(size_t a, size_t b, size_t *r)
  */
 void av_max_alloc(size_t max);
 
+/**
+ * @defgroup lavu_mem_flags Allocation flags
+ * Flags changing how av_malloc() allocates large blocks, such as frame
+ * buffers. They only affect blocks of AV_MEM_LARGE_BLOCK bytes or more.
+ * @{
+ */
+
+/**
+ * Minimum size of a block affected by the allocation flags.
+ */
+#define AV_MEM_LARGE_BLOCK (2 << 20)
+
+/**
+ * Align large blocks to huge page boundaries and ask the system to back
+ * them with huge pages (transparent huge pages on Linux). This reduces
+ * TLB misses when working on big frames, at the cost of some address
+ * space. Ignored where unsupported.
+ */
+#define AV_MEM_FLAG_HUGEPAGES (1 << 0)
+
+/**
+ * Touch every page of a large block from the allocating thread. With the
+ * usual first-touch NUMA policy, this places the memory on the node of
+ * the thread allocating it instead of the node of whichever thread
+ * writes to it first.
+ */
+#define AV_MEM_FLAG_PREFAULT  (1 << 1)
+
+/**
+ * Set the allocation flags used by av_malloc() and the functions built
+ * on it, such as av_buffer_alloc() and buffer pools.
+ *
+ * This is a global setting, and should be set before allocating any
+ * buffers that are meant to be affected.
+ *
+ * @param flags a combination of AV_MEM_FLAG_*
+ */
+void av_mem_set_flags(int flags);
+
+/**
+ * @return the flags set with av_mem_set_flags()
+ */
+int av_mem_get_flags(void);
+
+/**
+ * @}
+ */
+
 /**
  * deliberately overlapping memcpy implementation
  * @param dst destination buffer
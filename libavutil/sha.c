@@ -23,12 +23,14 @@
 
 #include <string.h>
 
+#include "config.h"
 #include "attributes.h"
 #include "avutil.h"
 #include "bswap.h"
 #include "sha.h"
 #include "intreadwrite.h"
 #include "mem.h"
+#include "x86/sha.h"
 
 /** hash context */
 typedef struct AVSHA {
@@ -307,6 +309,8 @@ av_cold int av_sha_init(AVSHA *ctx, int bits)
     default:
         return -1;
     }
+    if (ARCH_X86)
+        ff_sha_init_x86(&ctx->transform, bits);
     ctx->count = 0;
     return 0;
 }
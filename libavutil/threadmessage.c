@@ -18,7 +18,11 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <string.h>
+
+#include "atomic.h"
 #include "fifo.h"
+#include "mem.h"
 #include "threadmessage.h"
 #if HAVE_THREADS
 #if HAVE_PTHREADS
@@ -37,9 +41,21 @@ struct AVThreadMessageQueue {
     AVFifoBuffer *fifo;
     pthread_mutex_t lock;
     pthread_cond_t cond;
-    int err_send;
-    int err_recv;
+    volatile int err_send;
+    volatile int err_recv;
     unsigned elsize;
+    unsigned flags;
+
+    /* AV_THREAD_MESSAGE_QUEUE_SPSC ring buffer; the indexes run from 0 to
+     * 2 * nelem - 1 so that a full ring can be told apart from an empty one.
+     * read_idx is only written by the receiving thread and write_idx only
+     * by the sending thread. */
+    uint8_t *ring;
+    int nelem;
+    volatile int read_idx;
+    volatile int write_idx;
+    volatile int recv_waiting;
+    volatile int send_waiting;
 #else
     int dummy;
 #endif
@@ -48,12 +64,20 @@ struct AVThreadMessageQueue {
 int av_thread_message_queue_alloc(AVThreadMessageQueue **mq,
                                   unsigned nelem,
                                   unsigned elsize)
+{
+    return av_thread_message_queue_alloc2(mq, nelem, elsize, 0);
+}
+
+int av_thread_message_queue_alloc2(AVThreadMessageQueue **mq,
+                                   unsigned nelem,
+                                   unsigned elsize,
+                                   unsigned flags)
 {
 #if HAVE_THREADS
     AVThreadMessageQueue *rmq;
     int ret = 0;
 
-    if (nelem > INT_MAX / elsize)
+    if (!elsize || nelem > INT_MAX / 2 / elsize)
         return AVERROR(EINVAL);
     if (!(rmq = av_mallocz(sizeof(*rmq))))
         return AVERROR(ENOMEM);
@@ -66,13 +90,22 @@ int av_thread_message_queue_alloc(AVThreadMessageQueue **mq,
         av_free(rmq);
         return AVERROR(ret);
     }
-    if (!(rmq->fifo = av_fifo_alloc(elsize * nelem))) {
+    if (flags & AV_THREAD_MESSAGE_QUEUE_SPSC) {
+        rmq->ring = av_malloc_array(nelem, elsize);
+        if (!rmq->ring && nelem && elsize)
+            ret = AVERROR(ENOMEM);
+    } else if (!(rmq->fifo = av_fifo_alloc(elsize * nelem))) {
+        ret = AVERROR(ENOMEM);
+    }
+    if (ret < 0) {
         pthread_cond_destroy(&rmq->cond);
         pthread_mutex_destroy(&rmq->lock);
         av_free(rmq);
-        return AVERROR(ret);
+        return ret;
     }
     rmq->elsize = elsize;
+    rmq->nelem  = nelem;
+    rmq->flags  = flags;
     *mq = rmq;
     return 0;
 #else
@@ -86,6 +119,7 @@ void av_thread_message_queue_free(AVThreadMessageQueue **mq)
 #if HAVE_THREADS
     if (*mq) {
         av_fifo_freep(&(*mq)->fifo);
+        av_freep(&(*mq)->ring);
         pthread_cond_destroy(&(*mq)->cond);
         pthread_mutex_destroy(&(*mq)->lock);
         av_freep(mq);
@@ -127,6 +161,104 @@ static int av_thread_message_queue_recv_locked(AVThreadMessageQueue *mq,
     return 0;
 }
 
+static int ring_count(AVThreadMessageQueue *mq, int read_idx, int write_idx)
+{
+    int count = write_idx - read_idx;
+    return count < 0 ? count + 2 * mq->nelem : count;
+}
+
+static int ring_next(AVThreadMessageQueue *mq, int idx)
+{
+    return idx + 1 < 2 * mq->nelem ? idx + 1 : 0;
+}
+
+/**
+ * Lock-free path for queues with a single sender and a single receiver.
+ * The mutex is only taken to sleep when the ring is full or empty, and by
+ * the other side to wake up a sleeping peer. The waiting flag is set
+ * before checking the ring again, and the index is updated before checking
+ * the flag: as the atomic accesses are full barriers, either the waiting
+ * side sees the new index or the other side sees the flag. The flag is
+ * cleared when the peer is woken up, so that it is only signaled once.
+ */
+static int av_thread_message_queue_send_spsc(AVThreadMessageQueue *mq,
+                                             void *msg,
+                                             unsigned flags)
+{
+    int err, write_idx = mq->write_idx;
+
+    while (1) {
+        if ((err = avpriv_atomic_int_get(&mq->err_send)))
+            return err;
+        if (ring_count(mq, avpriv_atomic_int_get(&mq->read_idx), write_idx) < mq->nelem)
+            break;
+        if ((flags & AV_THREAD_MESSAGE_NONBLOCK))
+            return AVERROR(EAGAIN);
+        pthread_mutex_lock(&mq->lock);
+        while (1) {
+            avpriv_atomic_int_set(&mq->send_waiting, 1);
+            if (mq->err_send ||
+                ring_count(mq, avpriv_atomic_int_get(&mq->read_idx), write_idx) < mq->nelem)
+                break;
+            pthread_cond_wait(&mq->cond, &mq->lock);
+        }
+        avpriv_atomic_int_set(&mq->send_waiting, 0);
+        pthread_mutex_unlock(&mq->lock);
+    }
+
+    memcpy(mq->ring + (write_idx % mq->nelem) * mq->elsize, msg, mq->elsize);
+    avpriv_atomic_int_set(&mq->write_idx, ring_next(mq, write_idx));
+
+    if (avpriv_atomic_int_get(&mq->recv_waiting)) {
+        pthread_mutex_lock(&mq->lock);
+        avpriv_atomic_int_set(&mq->recv_waiting, 0);
+        pthread_mutex_unlock(&mq->lock);
+        pthread_cond_signal(&mq->cond);
+    }
+    return 0;
+}
+
+static int av_thread_message_queue_recv_spsc(AVThreadMessageQueue *mq,
+                                             void *msg,
+                                             unsigned flags)
+{
+    int err, read_idx = mq->read_idx;
+
+    while (1) {
+        if (ring_count(mq, read_idx, avpriv_atomic_int_get(&mq->write_idx)))
+            break;
+        if ((err = avpriv_atomic_int_get(&mq->err_recv))) {
+            /* deliver messages sent before the error was set */
+            if (ring_count(mq, read_idx, avpriv_atomic_int_get(&mq->write_idx)))
+                break;
+            return err;
+        }
+        if ((flags & AV_THREAD_MESSAGE_NONBLOCK))
+            return AVERROR(EAGAIN);
+        pthread_mutex_lock(&mq->lock);
+        while (1) {
+            avpriv_atomic_int_set(&mq->recv_waiting, 1);
+            if (mq->err_recv ||
+                ring_count(mq, read_idx, avpriv_atomic_int_get(&mq->write_idx)))
+                break;
+            pthread_cond_wait(&mq->cond, &mq->lock);
+        }
+        avpriv_atomic_int_set(&mq->recv_waiting, 0);
+        pthread_mutex_unlock(&mq->lock);
+    }
+
+    memcpy(msg, mq->ring + (read_idx % mq->nelem) * mq->elsize, mq->elsize);
+    avpriv_atomic_int_set(&mq->read_idx, ring_next(mq, read_idx));
+
+    if (avpriv_atomic_int_get(&mq->send_waiting)) {
+        pthread_mutex_lock(&mq->lock);
+        avpriv_atomic_int_set(&mq->send_waiting, 0);
+        pthread_mutex_unlock(&mq->lock);
+        pthread_cond_signal(&mq->cond);
+    }
+    return 0;
+}
+
 #endif /* HAVE_THREADS */
 
 int av_thread_message_queue_send(AVThreadMessageQueue *mq,
@@ -136,6 +268,9 @@ int av_thread_message_queue_send(AVThreadMessageQueue *mq,
 #if HAVE_THREADS
     int ret;
 
+    if (mq->flags & AV_THREAD_MESSAGE_QUEUE_SPSC)
+        return av_thread_message_queue_send_spsc(mq, msg, flags);
+
     pthread_mutex_lock(&mq->lock);
     ret = av_thread_message_queue_send_locked(mq, msg, flags);
     pthread_mutex_unlock(&mq->lock);
@@ -152,6 +287,9 @@ int av_thread_message_queue_recv(AVThreadMessageQueue *mq,
 #if HAVE_THREADS
     int ret;
 
+    if (mq->flags & AV_THREAD_MESSAGE_QUEUE_SPSC)
+        return av_thread_message_queue_recv_spsc(mq, msg, flags);
+
     pthread_mutex_lock(&mq->lock);
     ret = av_thread_message_queue_recv_locked(mq, msg, flags);
     pthread_mutex_unlock(&mq->lock);
@@ -182,3 +320,130 @@ void av_thread_message_queue_set_err_recv(AVThreadMessageQueue *mq,
     pthread_mutex_unlock(&mq->lock);
 #endif /* HAVE_THREADS */
 }
+
+#ifdef TEST
+
+#include <stdio.h>
+
+#include "common.h"
+#include "error.h"
+#include "time.h"
+
+typedef struct TestSender {
+    AVThreadMessageQueue *mq;
+    int nb_messages;
+    int ret;
+} TestSender;
+
+static void *sender_thread(void *arg)
+{
+    TestSender *s = arg;
+    int i, ret = 0;
+
+    for (i = 0; i < s->nb_messages; i++) {
+        /* give the receiver a chance to find the queue empty */
+        if (i % 97 == 0)
+            av_usleep(1000);
+        if ((ret = av_thread_message_queue_send(s->mq, &i, 0)) < 0)
+            break;
+    }
+    s->ret = ret;
+    av_thread_message_queue_set_err_recv(s->mq, AVERROR_EOF);
+    return NULL;
+}
+
+/* blocking transfer with a short queue, ended by the sender */
+static int test_transfer(unsigned flags)
+{
+    AVThreadMessageQueue *mq;
+    TestSender s = { .nb_messages = 1000 };
+    pthread_t thread;
+    int i, msg, ret;
+
+    if ((ret = av_thread_message_queue_alloc2(&mq, 4, sizeof(int), flags)) < 0)
+        return ret;
+    s.mq = mq;
+    if ((ret = pthread_create(&thread, NULL, sender_thread, &s))) {
+        av_thread_message_queue_free(&mq);
+        return AVERROR(ret);
+    }
+    for (i = 0; ; i++) {
+        /* let the sender find the queue full */
+        if (i % 89 == 0)
+            av_usleep(1000);
+        if ((ret = av_thread_message_queue_recv(mq, &msg, 0)) < 0)
+            break;
+        if (msg != i) {
+            printf("message %d received as %d\n", i, msg);
+            break;
+        }
+    }
+    pthread_join(thread, NULL);
+    av_thread_message_queue_free(&mq);
+
+    printf("transfer: %d messages received, then %s\n", i, av_err2str(ret));
+    return i == s.nb_messages && ret == AVERROR_EOF ? 0 : -1;
+}
+
+/* the receiver stops a sender blocked on a full queue */
+static int test_err_send(unsigned flags)
+{
+    AVThreadMessageQueue *mq;
+    TestSender s = { .nb_messages = INT_MAX };
+    pthread_t thread;
+    int i, msg, ret;
+
+    if ((ret = av_thread_message_queue_alloc2(&mq, 2, sizeof(int), flags)) < 0)
+        return ret;
+    s.mq = mq;
+    if ((ret = pthread_create(&thread, NULL, sender_thread, &s))) {
+        av_thread_message_queue_free(&mq);
+        return AVERROR(ret);
+    }
+    for (i = 0; i < 10; i++)
+        if ((ret = av_thread_message_queue_recv(mq, &msg, 0)) < 0)
+            break;
+    av_usleep(1000);
+    av_thread_message_queue_set_err_send(mq, AVERROR_EXIT);
+    pthread_join(thread, NULL);
+    av_thread_message_queue_free(&mq);
+
+    printf("err_send: sender stopped with %s\n", av_err2str(s.ret));
+    return i == 10 && s.ret == AVERROR_EXIT ? 0 : -1;
+}
+
+static int test_nonblock(unsigned flags)
+{
+    AVThreadMessageQueue *mq;
+    int msg = 42, ret, err = 0;
+
+    if ((ret = av_thread_message_queue_alloc2(&mq, 1, sizeof(int), flags)) < 0)
+        return ret;
+    err |= av_thread_message_queue_recv(mq, &msg, AV_THREAD_MESSAGE_NONBLOCK) != AVERROR(EAGAIN);
+    err |= av_thread_message_queue_send(mq, &msg, AV_THREAD_MESSAGE_NONBLOCK) != 0;
+    err |= av_thread_message_queue_send(mq, &msg, AV_THREAD_MESSAGE_NONBLOCK) != AVERROR(EAGAIN);
+    msg = 0;
+    err |= av_thread_message_queue_recv(mq, &msg, AV_THREAD_MESSAGE_NONBLOCK) != 0 || msg != 42;
+    av_thread_message_queue_set_err_recv(mq, AVERROR_EOF);
+    err |= av_thread_message_queue_recv(mq, &msg, 0) != AVERROR_EOF;
+    av_thread_message_queue_free(&mq);
+
+    printf("nonblock: %s\n", err ? "failed" : "ok");
+    return err ? -1 : 0;
+}
+
+int main(void)
+{
+    static const unsigned flags[] = { 0, AV_THREAD_MESSAGE_QUEUE_SPSC };
+    int i, ret = 0;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(flags); i++) {
+        printf("flags %u\n", flags[i]);
+        ret |= test_transfer(flags[i]);
+        ret |= test_err_send(flags[i]);
+        ret |= test_nonblock(flags[i]);
+    }
+    return !!ret;
+}
+
+#endif /* TEST */
@@ -32,6 +32,23 @@ typedef enum AVThreadMessageFlags {
 
 } AVThreadMessageFlags;
 
+typedef enum AVThreadMessageQueueFlags {
+
+    /**
+     * The queue is used by a single sending thread and a single receiving
+     * thread. Messages are then passed through a lock-free ring buffer,
+     * and the threads only synchronize when one of them has to wait because
+     * the queue is full or empty.
+     *
+     * This mode is only valid with exactly one sender and one receiver:
+     * calling av_thread_message_queue_send() or
+     * av_thread_message_queue_recv() from more than one thread at a time
+     * results in lost or duplicated messages.
+     */
+    AV_THREAD_MESSAGE_QUEUE_SPSC = 1,
+
+} AVThreadMessageQueueFlags;
+
 /**
  * Allocate a new message queue.
  *
@@ -45,6 +62,23 @@ int av_thread_message_queue_alloc(AVThreadMessageQueue **mq,
                                   unsigned nelem,
                                   unsigned elsize);
 
+/**
+ * Allocate a new message queue.
+ *
+ * @param mq      pointer to the message queue
+ * @param nelem   maximum number of elements in the queue
+ * @param elsize  size of each element in the queue
+ * @param flags   a combination of AVThreadMessageQueueFlags; with
+ *                AV_THREAD_MESSAGE_QUEUE_SPSC the queue must only have one
+ *                sending and one receiving thread
+ * @return  >=0 for success; <0 for error, in particular AVERROR(ENOSYS) if
+ *          lavu was built without thread support
+ */
+int av_thread_message_queue_alloc2(AVThreadMessageQueue **mq,
+                                   unsigned nelem,
+                                   unsigned elsize,
+                                   unsigned flags);
+
 /**
  * Free a message queue.
  *
@@ -0,0 +1,46 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVUTIL_X86_BASE64_H
+#define AVUTIL_X86_BASE64_H
+
+#include <stdint.h>
+
+typedef struct FFBase64DSP {
+    /**
+     * Encode the leading part of in, 12 bytes at a time.
+     *
+     * @return number of input bytes consumed, the output holds 4/3 as many
+     *         characters
+     */
+    int (*encode)(char *out, const uint8_t *in, int in_size);
+
+    /**
+     * Decode the leading part of the in_size characters of in, 16 at a
+     * time, stopping before the first block containing anything but base64
+     * characters.
+     *
+     * @return number of bytes written to out, 4/3 as many characters of in
+     *         were consumed
+     */
+    int (*decode)(uint8_t *out, const uint8_t *in, int in_size, int out_size);
+} FFBase64DSP;
+
+void ff_base64_init_x86(FFBase64DSP *dsp);
+
+#endif /* AVUTIL_X86_BASE64_H */
@@ -0,0 +1,190 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/mem.h"
+#include "libavutil/x86/asm.h"
+#include "libavutil/x86/cpu.h"
+#include "base64.h"
+
+#if HAVE_SSSE3_INLINE
+
+#define PB(x) { x, x, x, x, x, x, x, x, x, x, x, x, x, x, x, x }
+
+/* put input bytes 0..11 into the dwords as { b1, b0, b2, b1 } */
+DECLARE_ALIGNED(16, static const uint8_t, enc_shuf)[16] = {
+    1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10
+};
+DECLARE_ALIGNED(16, static const uint32_t, enc_mask_hi)[4] = {
+    0x0fc0fc00, 0x0fc0fc00, 0x0fc0fc00, 0x0fc0fc00
+};
+DECLARE_ALIGNED(16, static const uint32_t, enc_mul_hi)[4] = {
+    0x04000040, 0x04000040, 0x04000040, 0x04000040
+};
+DECLARE_ALIGNED(16, static const uint32_t, enc_mask_lo)[4] = {
+    0x003f03f0, 0x003f03f0, 0x003f03f0, 0x003f03f0
+};
+DECLARE_ALIGNED(16, static const uint32_t, enc_mul_lo)[4] = {
+    0x01000010, 0x01000010, 0x01000010, 0x01000010
+};
+DECLARE_ALIGNED(16, static const uint8_t, pb_51)[16] = PB(51);
+DECLARE_ALIGNED(16, static const uint8_t, pb_26)[16] = PB(26);
+DECLARE_ALIGNED(16, static const uint8_t, pb_13)[16] = PB(13);
+/* offset from a 6-bit value to its character, indexed by the value
+ * range: 13 for 0-25, 0 for 26-51, 1-10 for 52-61, 11 and 12 for 62, 63 */
+DECLARE_ALIGNED(16, static const int8_t, enc_offset)[16] = {
+    'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+    '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0
+};
+
+static int base64_encode_ssse3(char *out, const uint8_t *in, int in_size)
+{
+    int i = 0;
+
+    /* 16 bytes are loaded to encode 12 */
+    for (; in_size - i >= 16; i += 12, out += 16) {
+        __asm__ volatile (
+            "movdqu      (%[in]), %%xmm0            \n\t"
+            "pshufb      %[shuf], %%xmm0            \n\t"
+            "movdqa      %%xmm0, %%xmm1             \n\t"
+            "pand        %[mask_hi], %%xmm0         \n\t"
+            "pmulhuw     %[mul_hi], %%xmm0          \n\t"
+            "pand        %[mask_lo], %%xmm1         \n\t"
+            "pmullw      %[mul_lo], %%xmm1          \n\t"
+            "por         %%xmm1, %%xmm0             \n\t"
+            /* xmm0 now holds one 6-bit value per byte */
+            "movdqa      %%xmm0, %%xmm1             \n\t"
+            "psubusb     %[pb_51], %%xmm1           \n\t"
+            "movdqa      %[pb_26], %%xmm2           \n\t"
+            "pcmpgtb     %%xmm0, %%xmm2             \n\t"
+            "pand        %[pb_13], %%xmm2           \n\t"
+            "por         %%xmm2, %%xmm1             \n\t"
+            "movdqa      %[offset], %%xmm2          \n\t"
+            "pshufb      %%xmm1, %%xmm2             \n\t"
+            "paddb       %%xmm2, %%xmm0             \n\t"
+            "movdqu      %%xmm0, (%[out])           \n\t"
+            :
+            : [in]"r"(in + i), [out]"r"(out),
+              [shuf]"m"(*enc_shuf),
+              [mask_hi]"m"(*enc_mask_hi), [mul_hi]"m"(*enc_mul_hi),
+              [mask_lo]"m"(*enc_mask_lo), [mul_lo]"m"(*enc_mul_lo),
+              [pb_51]"m"(*pb_51), [pb_26]"m"(*pb_26), [pb_13]"m"(*pb_13),
+              [offset]"m"(*enc_offset)
+            : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2",)
+              "memory"
+        );
+    }
+
+    return i;
+}
+
+/* Validity classes: a character is valid if the entries for its low and
+ * high nibbles have no bit in common. */
+DECLARE_ALIGNED(16, static const uint8_t, dec_lut_lo)[16] = {
+    0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+    0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A
+};
+DECLARE_ALIGNED(16, static const uint8_t, dec_lut_hi)[16] = {
+    0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10
+};
+/* offset from a character to its 6-bit value, indexed by the high nibble,
+ * minus one for '/' */
+DECLARE_ALIGNED(16, static const int8_t, dec_offset)[16] = {
+    0, 63 - '/', 62 - '+', 52 - '0', -'A', -'A', 26 - 'a', 26 - 'a',
+    0, 0, 0, 0, 0, 0, 0, 0
+};
+DECLARE_ALIGNED(16, static const uint8_t, pb_0f)[16] = PB(0x0f);
+DECLARE_ALIGNED(16, static const uint8_t, pb_2f)[16] = PB(0x2f);
+DECLARE_ALIGNED(16, static const uint16_t, dec_mul_ab)[8] = {
+    0x0140, 0x0140, 0x0140, 0x0140, 0x0140, 0x0140, 0x0140, 0x0140
+};
+DECLARE_ALIGNED(16, static const uint32_t, dec_mul_abc)[4] = {
+    0x00011000, 0x00011000, 0x00011000, 0x00011000
+};
+DECLARE_ALIGNED(16, static const int8_t, dec_shuf)[16] = {
+    2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1
+};
+
+static int base64_decode_ssse3(uint8_t *out, const uint8_t *in, int in_size,
+                               int out_size)
+{
+    int i = 0;
+
+    /* 16 bytes are stored for 12 decoded ones */
+    for (; out_size - i >= 16 && in_size >= 16; i += 12, in += 16, in_size -= 16) {
+        int valid;
+
+        __asm__ volatile (
+            "movdqu      (%[in]), %%xmm0            \n\t"
+            "movdqa      %%xmm0, %%xmm1             \n\t"
+            "psrld       $4, %%xmm1                 \n\t"
+            "pand        %[pb_0f], %%xmm1           \n\t"
+            "movdqa      %%xmm0, %%xmm2             \n\t"
+            "pand        %[pb_0f], %%xmm2           \n\t"
+            "movdqa      %[lut_lo], %%xmm3          \n\t"
+            "pshufb      %%xmm2, %%xmm3             \n\t"
+            "movdqa      %[lut_hi], %%xmm2          \n\t"
+            "pshufb      %%xmm1, %%xmm2             \n\t"
+            "pand        %%xmm3, %%xmm2             \n\t"
+            "pxor        %%xmm3, %%xmm3             \n\t"
+            "pcmpeqb     %%xmm3, %%xmm2             \n\t"
+            "pmovmskb    %%xmm2, %[valid]           \n\t"
+            /* map the characters to their 6-bit values */
+            "movdqa      %%xmm0, %%xmm2             \n\t"
+            "pcmpeqb     %[pb_2f], %%xmm2           \n\t"
+            "paddb       %%xmm2, %%xmm1             \n\t"
+            "movdqa      %[offset], %%xmm2          \n\t"
+            "pshufb      %%xmm1, %%xmm2             \n\t"
+            "paddb       %%xmm2, %%xmm0             \n\t"
+            /* pack 4 x 6 bits into 3 bytes */
+            "pmaddubsw   %[mul_ab], %%xmm0          \n\t"
+            "pmaddwd     %[mul_abc], %%xmm0         \n\t"
+            "pshufb      %[shuf], %%xmm0            \n\t"
+            "movdqu      %%xmm0, (%[out])           \n\t"
+            : [valid]"=r"(valid)
+            : [in]"r"(in), [out]"r"(out + i),
+              [pb_0f]"m"(*pb_0f), [pb_2f]"m"(*pb_2f),
+              [lut_lo]"m"(*dec_lut_lo), [lut_hi]"m"(*dec_lut_hi),
+              [offset]"m"(*dec_offset), [mul_ab]"m"(*dec_mul_ab),
+              [mul_abc]"m"(*dec_mul_abc), [shuf]"m"(*dec_shuf)
+            : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",)
+              "memory"
+        );
+        if (valid != 0xFFFF)
+            break;
+    }
+
+    return i;
+}
+
+#endif /* HAVE_SSSE3_INLINE */
+
+av_cold void ff_base64_init_x86(FFBase64DSP *dsp)
+{
+#if HAVE_SSSE3_INLINE
+    int cpu_flags = av_get_cpu_flags();
+
+    if (INLINE_SSSE3(cpu_flags)) {
+        dsp->encode = base64_encode_ssse3;
+        dsp->decode = base64_decode_ssse3;
+    }
+#endif /* HAVE_SSSE3_INLINE */
+}
@@ -0,0 +1,47 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVUTIL_X86_CRC_H
+#define AVUTIL_X86_CRC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libavutil/mem.h"
+
+typedef struct FFCRCFold {
+    /**
+     * Multipliers folding a 16 byte block over 64, 48, 32 and 16 bytes,
+     * for the low and the high 64 bits of the block.
+     */
+    DECLARE_ALIGNED(16, uint64_t, k)[4][2];
+    /**
+     * pshufb mask turning a block into a 128-bit polynomial
+     */
+    DECLARE_ALIGNED(16, uint8_t, shuf)[16];
+    /**
+     * Fold blocks (at least 4) 16 byte blocks of buf into out, so that the
+     * CRC of out starting from 0 is the CRC of buf starting from crc.
+     */
+    void (*fold)(const struct FFCRCFold *f, uint32_t crc,
+                 const uint8_t *buf, size_t blocks, uint8_t *out);
+} FFCRCFold;
+
+void ff_crc_fold_init_x86(FFCRCFold *f, int le, int bits, uint32_t poly);
+
+#endif /* AVUTIL_X86_CRC_H */
@@ -0,0 +1,163 @@
+/*
+ * CRC folding using carry-less multiplication
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/asm.h"
+#include "libavutil/x86/cpu.h"
+#include "crc.h"
+
+#if HAVE_CLMUL_INLINE && HAVE_INLINE_ASM_LABELS
+
+/* Each block is a 128-bit polynomial, the first byte holding the highest
+ * powers. A block followed by n bytes is replaced by the sum of its two
+ * halves multiplied by x^(8n) modulo the CRC polynomial, which leaves the
+ * CRC unchanged. Four blocks are carried in parallel until the end of the
+ * data, then folded into one, and the caller finishes with the tables. */
+#define LOAD(m, off)                                            \
+    "movdqu        "#off"(%[buf]), %%xmm"#m"               \n\t"\
+    "pshufb        %%xmm5, %%xmm"#m"                       \n\t"
+
+#define FOLD(acc, k, blk)                                       \
+    "movdqa        %%xmm"#acc", %%xmm6                     \n\t"\
+    "pclmulqdq     $0x00, %%xmm"#k", %%xmm"#acc"           \n\t"\
+    "pclmulqdq     $0x11, %%xmm"#k", %%xmm6                \n\t"\
+    "pxor          %%xmm6, %%xmm"#acc"                     \n\t"\
+    "pxor          %%xmm"#blk", %%xmm"#acc"                \n\t"
+
+static void crc_fold_clmul(const FFCRCFold *f, uint32_t crc,
+                           const uint8_t *buf, size_t blocks, uint8_t *out)
+{
+    const uint8_t *end4 = buf + 16 * (blocks & ~3);
+    const uint8_t *end  = buf + 16 * blocks;
+
+    __asm__ volatile (
+        "movdqa        %[shuf], %%xmm5                     \n\t"
+        "movd          %[crc], %%xmm4                      \n\t"
+        "movdqu        (%[buf]), %%xmm0                    \n\t"
+        "pxor          %%xmm4, %%xmm0                      \n\t"
+        "pshufb        %%xmm5, %%xmm0                      \n\t"
+        LOAD(1, 16)
+        LOAD(2, 32)
+        LOAD(3, 48)
+        "movdqa        %[k64], %%xmm4                      \n\t"
+        "add           $64, %[buf]                         \n\t"
+        "jmp           2f                                  \n\t"
+        "1:                                                \n\t"
+        LOAD(7,  0)
+        FOLD(0, 4, 7)
+        LOAD(7, 16)
+        FOLD(1, 4, 7)
+        LOAD(7, 32)
+        FOLD(2, 4, 7)
+        LOAD(7, 48)
+        FOLD(3, 4, 7)
+        "add           $64, %[buf]                         \n\t"
+        "2:                                                \n\t"
+        "cmp           %[end4], %[buf]                     \n\t"
+        "jb            1b                                  \n\t"
+
+        "movdqa        %[k48], %%xmm4                      \n\t"
+        FOLD(0, 4, 3)
+        "movdqa        %[k32], %%xmm4                      \n\t"
+        FOLD(1, 4, 0)
+        "movdqa        %[k16], %%xmm4                      \n\t"
+        FOLD(2, 4, 1)
+        "jmp           4f                                  \n\t"
+        "3:                                                \n\t"
+        LOAD(7,  0)
+        FOLD(2, 4, 7)
+        "add           $16, %[buf]                         \n\t"
+        "4:                                                \n\t"
+        "cmp           %[end], %[buf]                      \n\t"
+        "jb            3b                                  \n\t"
+
+        "pshufb        %%xmm5, %%xmm2                      \n\t"
+        "movdqu        %%xmm2, (%[out])                    \n\t"
+        : [buf]"+r"(buf)
+        : [end4]"r"(end4), [end]"r"(end), [out]"r"(out), [crc]"rm"(crc),
+          [shuf]"m"(f->shuf), [k64]"m"(f->k[0]), [k48]"m"(f->k[1]),
+          [k32]"m"(f->k[2]), [k16]"m"(f->k[3])
+        : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                       "%xmm4", "%xmm5", "%xmm6", "%xmm7",)
+          "memory"
+    );
+}
+
+/* x^n modulo x^bits + poly, most significant bit first */
+static av_cold uint32_t xpow_mod(int n, int bits, uint32_t poly)
+{
+    uint64_t r = 1;
+
+    while (n--) {
+        r <<= 1;
+        if (r >> bits)
+            r ^= (1ULL << bits) | poly;
+    }
+    return r;
+}
+
+static av_cold uint64_t reverse64(uint64_t x)
+{
+    uint64_t r = 0;
+    int i;
+
+    for (i = 0; i < 64; i++)
+        r |= ((x >> i) & 1) << (63 - i);
+    return r;
+}
+
+#endif /* HAVE_CLMUL_INLINE && HAVE_INLINE_ASM_LABELS */
+
+av_cold void ff_crc_fold_init_x86(FFCRCFold *f, int le, int bits, uint32_t poly)
+{
+#if HAVE_CLMUL_INLINE && HAVE_INLINE_ASM_LABELS
+    int cpu_flags = av_get_cpu_flags();
+    int i;
+
+    if (INLINE_CLMUL(cpu_flags)) {
+        if (le) {
+            /* bit reversed: the low half of a block holds the high powers,
+             * and the product of two reversed values is one bit short */
+            uint32_t p = 0;
+
+            for (i = 0; i < bits; i++)
+                p |= ((poly >> i) & 1) << (bits - 1 - i);
+            for (i = 0; i < 4; i++) {
+                f->k[i][0] = reverse64(xpow_mod(128 * (4 - i) + 63, bits, p));
+                f->k[i][1] = reverse64(xpow_mod(128 * (4 - i) -  1, bits, p));
+            }
+            for (i = 0; i < 16; i++)
+                f->shuf[i] = i;
+        } else {
+            /* a CRC of less than 32 bits is kept in the top bits of a 32-bit
+             * register, i.e. the polynomial is multiplied by x^(32 - bits) */
+            for (i = 0; i < 4; i++) {
+                f->k[i][0] = (uint64_t)xpow_mod(128 * (4 - i) - 32 + bits, bits, poly) << (32 - bits);
+                f->k[i][1] = (uint64_t)xpow_mod(128 * (4 - i) + 32 + bits, bits, poly) << (32 - bits);
+            }
+            for (i = 0; i < 16; i++)
+                f->shuf[i] = 15 - i;
+        }
+        f->fold = crc_fold_clmul;
+    }
+#endif /* HAVE_CLMUL_INLINE && HAVE_INLINE_ASM_LABELS */
+}
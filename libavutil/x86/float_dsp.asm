@@ -191,6 +191,84 @@ INIT_YMM avx
 VECTOR_DMUL_SCALAR
 %endif
 
+;-----------------------------------------------------------------------------
+; void vector_dmul(double *dst, const double *src0, const double *src1,
+;                  int len)
+;-----------------------------------------------------------------------------
+%macro VECTOR_DMUL 0
+cglobal vector_dmul, 4,4,2, dst, src0, src1, len
+    lea       lenq, [lend*8 - 64]
+ALIGN 16
+.loop:
+%assign a 0
+%rep 32/mmsize
+    mova      m0,   [src0q + lenq + (a+0)*mmsize]
+    mova      m1,   [src0q + lenq + (a+1)*mmsize]
+    mulpd     m0, m0, [src1q + lenq + (a+0)*mmsize]
+    mulpd     m1, m1, [src1q + lenq + (a+1)*mmsize]
+    mova      [dstq + lenq + (a+0)*mmsize], m0
+    mova      [dstq + lenq + (a+1)*mmsize], m1
+%assign a a+2
+%endrep
+
+    sub       lenq, 64
+    jge       .loop
+    REP_RET
+%endmacro
+
+INIT_XMM sse2
+VECTOR_DMUL
+%if HAVE_AVX_EXTERNAL
+INIT_YMM avx
+VECTOR_DMUL
+%endif
+
+;------------------------------------------------------------------------------
+; void ff_vector_dmac_scalar(double *dst, const double *src, double mul,
+;                            int len)
+;------------------------------------------------------------------------------
+
+%macro VECTOR_DMAC_SCALAR 0
+%if ARCH_X86_32
+cglobal vector_dmac_scalar, 3,4,3, dst, src, mul, len, lenaddr
+    mov          lenq, lenaddrm
+%elif UNIX64
+cglobal vector_dmac_scalar, 3,3,3, dst, src, len
+%else
+cglobal vector_dmac_scalar, 4,4,3, dst, src, mul, len
+%endif
+%if ARCH_X86_32
+    VBROADCASTSD   m0, mulm
+%else
+%if WIN64
+    SWAP 0, 2
+%endif
+    movlhps       xm0, xm0
+%if cpuflag(avx)
+    vinsertf128   ym0, ym0, xm0, 1
+%endif
+%endif
+    lea          lenq, [lend*8-2*mmsize]
+.loop:
+    ; multiply and add separately, to round like the C version
+    mulpd          m1, m0, [srcq+lenq       ]
+    mulpd          m2, m0, [srcq+lenq+mmsize]
+    addpd          m1, m1, [dstq+lenq       ]
+    addpd          m2, m2, [dstq+lenq+mmsize]
+    mova   [dstq+lenq       ], m1
+    mova   [dstq+lenq+mmsize], m2
+    sub          lenq, 2*mmsize
+    jge .loop
+    REP_RET
+%endmacro
+
+INIT_XMM sse2
+VECTOR_DMAC_SCALAR
+%if HAVE_AVX_EXTERNAL
+INIT_YMM avx
+VECTOR_DMAC_SCALAR
+%endif
+
 ;-----------------------------------------------------------------------------
 ; vector_fmul_window(float *dst, const float *src0,
 ;                    const float *src1, const float *win, int len);
@@ -354,6 +432,48 @@ cglobal scalarproduct_float, 3,3,2, v1, v2, offset
 %endif
     RET
 
+;-----------------------------------------------------------------------------
+; double scalarproduct_double(const double *v1, const double *v2, int len)
+;-----------------------------------------------------------------------------
+%macro SCALARPRODUCT_DOUBLE 0
+cglobal scalarproduct_double, 3,3,3, v1, v2, offset
+    movsxdifnidn offsetq, offsetd
+    shl      offsetq, 3
+    add          v1q, offsetq
+    add          v2q, offsetq
+    neg      offsetq
+    xorpd         m0, m0
+    xorpd         m1, m1
+.loop:
+    mova          m2, [v1q+offsetq]
+    mulpd         m2, m2, [v2q+offsetq]
+    addpd         m0, m0, m2
+    mova          m2, [v1q+offsetq+mmsize]
+    mulpd         m2, m2, [v2q+offsetq+mmsize]
+    addpd         m1, m1, m2
+    add      offsetq, 2*mmsize
+    jl .loop
+    addpd         m0, m0, m1
+%if mmsize == 32
+    vextractf128 xm1, m0, 1
+    addpd        xm0, xm0, xm1
+%endif
+    movhlps      xm1, xm0
+    addsd        xm0, xm0, xm1
+%if ARCH_X86_64 == 0
+    movsd        r0m, xm0
+    fld qword    r0m
+%endif
+    RET
+%endmacro
+
+INIT_XMM sse2
+SCALARPRODUCT_DOUBLE
+%if HAVE_AVX_EXTERNAL
+INIT_YMM avx
+SCALARPRODUCT_DOUBLE
+%endif
+
 ;-----------------------------------------------------------------------------
 ; void ff_butterflies_float(float *src0, float *src1, int len);
 ;-----------------------------------------------------------------------------
@@ -65,6 +65,19 @@ float ff_scalarproduct_float_sse(const float *v1, const float *v2, int order);
 
 void ff_butterflies_float_sse(float *src0, float *src1, int len);
 
+void ff_vector_dmul_sse2(double *dst, const double *src0, const double *src1,
+                         int len);
+void ff_vector_dmul_avx(double *dst, const double *src0, const double *src1,
+                        int len);
+
+void ff_vector_dmac_scalar_sse2(double *dst, const double *src, double mul,
+                                int len);
+void ff_vector_dmac_scalar_avx(double *dst, const double *src, double mul,
+                               int len);
+
+double ff_scalarproduct_double_sse2(const double *v1, const double *v2, int len);
+double ff_scalarproduct_double_avx(const double *v1, const double *v2, int len);
+
 av_cold void ff_float_dsp_init_x86(AVFloatDSPContext *fdsp)
 {
     int cpu_flags = av_get_cpu_flags();
@@ -84,6 +97,9 @@ av_cold void ff_float_dsp_init_x86(AVFloatDSPContext *fdsp)
     }
     if (EXTERNAL_SSE2(cpu_flags)) {
         fdsp->vector_dmul_scalar = ff_vector_dmul_scalar_sse2;
+        fdsp->vector_dmul          = ff_vector_dmul_sse2;
+        fdsp->vector_dmac_scalar   = ff_vector_dmac_scalar_sse2;
+        fdsp->scalarproduct_double = ff_scalarproduct_double_sse2;
     }
     if (EXTERNAL_AVX(cpu_flags)) {
         fdsp->vector_fmul = ff_vector_fmul_avx;
@@ -91,6 +107,9 @@ av_cold void ff_float_dsp_init_x86(AVFloatDSPContext *fdsp)
         fdsp->vector_dmul_scalar = ff_vector_dmul_scalar_avx;
         fdsp->vector_fmul_add    = ff_vector_fmul_add_avx;
         fdsp->vector_fmul_reverse = ff_vector_fmul_reverse_avx;
+        fdsp->vector_dmul          = ff_vector_dmul_avx;
+        fdsp->vector_dmac_scalar   = ff_vector_dmac_scalar_avx;
+        fdsp->scalarproduct_double = ff_scalarproduct_double_avx;
     }
     if (EXTERNAL_FMA3(cpu_flags)) {
         fdsp->vector_fmac_scalar = ff_vector_fmac_scalar_fma3;
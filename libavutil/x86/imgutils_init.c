@@ -0,0 +1,83 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "config.h"
+#include "libavutil/cpu.h"
+#include "libavutil/error.h"
+#include "libavutil/x86/asm.h"
+#include "libavutil/x86/cpu.h"
+#include "imgutils.h"
+
+#if HAVE_SSE2_INLINE && HAVE_INLINE_ASM_LABELS
+static void copy_line_nt_sse2(uint8_t *dst, const uint8_t *src, int size)
+{
+    int head = -(intptr_t)dst & 15;
+    x86_reg i;
+
+    if (size < head + 64) {
+        memcpy(dst, src, size);
+        return;
+    }
+    memcpy(dst, src, head);
+    dst  += head;
+    src  += head;
+    size -= head;
+
+    i = -(size & ~63);
+    __asm__ volatile (
+        "1:                                     \n\t"
+        "movdqu     (%1, %0), %%xmm0            \n\t"
+        "movdqu   16(%1, %0), %%xmm1            \n\t"
+        "movdqu   32(%1, %0), %%xmm2            \n\t"
+        "movdqu   48(%1, %0), %%xmm3            \n\t"
+        "movntdq    %%xmm0,   (%2, %0)          \n\t"
+        "movntdq    %%xmm1, 16(%2, %0)          \n\t"
+        "movntdq    %%xmm2, 32(%2, %0)          \n\t"
+        "movntdq    %%xmm3, 48(%2, %0)          \n\t"
+        "add        $64, %0                     \n\t"
+        "jl         1b                          \n\t"
+        : "+r"(i)
+        : "r"(src + (size & ~63)), "r"(dst + (size & ~63))
+        : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",)
+          "memory"
+    );
+    memcpy(dst + (size & ~63), src + (size & ~63), size & 63);
+}
+#endif /* HAVE_SSE2_INLINE && HAVE_INLINE_ASM_LABELS */
+
+int ff_image_copy_plane_nt_x86(uint8_t       *dst, int dst_linesize,
+                               const uint8_t *src, int src_linesize,
+                               int bytewidth, int height)
+{
+#if HAVE_SSE2_INLINE && HAVE_INLINE_ASM_LABELS
+    if (INLINE_SSE2(av_get_cpu_flags())) {
+        for (; height > 0; height--) {
+            copy_line_nt_sse2(dst, src, bytewidth);
+            dst += dst_linesize;
+            src += src_linesize;
+        }
+        /* order the non-temporal stores before anything that follows */
+        __asm__ volatile ("sfence" ::: "memory");
+        return 0;
+    }
+#endif
+    return AVERROR(ENOSYS);
+}
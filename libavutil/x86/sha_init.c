@@ -0,0 +1,238 @@
+/*
+ * SHA-1/SHA-256 transforms using the x86 SHA extensions
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/mem.h"
+#include "libavutil/x86/asm.h"
+#include "libavutil/x86/cpu.h"
+#include "sha.h"
+
+#if HAVE_SHA_INLINE
+
+DECLARE_ALIGNED(16, static const uint8_t, sha1_bswap_mask)[16] = {
+    15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0
+};
+
+DECLARE_ALIGNED(16, static const uint8_t, sha256_bswap_mask)[16] = {
+    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12
+};
+
+DECLARE_ALIGNED(16, static const uint32_t, sha256_k)[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+/* The message words W[4*i .. 4*i+3] live in xmm3 + (i & 3).
+ * SHA-1 keeps ABCD in xmm0 and alternates E between xmm1 and xmm2. */
+#define LOAD_MSG(i, m, mask)                                    \
+    "movdqu        16*"#i"(%[data]), %%xmm"#m"             \n\t"\
+    "pshufb        %["#mask"], %%xmm"#m"                   \n\t"
+
+#define SHA1_ROUNDS(f, e, eo)                                   \
+    "movdqa        %%xmm0, %%xmm"#eo"                      \n\t"\
+    "sha1rnds4     $"#f", %%xmm"#e", %%xmm0                \n\t"
+
+#define SHA1_MSG(cur, next, prev, prev2)                        \
+    "sha1msg2      %%xmm"#cur", %%xmm"#next"               \n\t"\
+    "sha1msg1      %%xmm"#cur", %%xmm"#prev"               \n\t"\
+    "pxor          %%xmm"#cur", %%xmm"#prev2"              \n\t"
+
+/* rounds 16 to 67, four at a time */
+#define SHA1_QROUND(f, e, eo, cur, next, prev, prev2)           \
+    "sha1nexte     %%xmm"#cur", %%xmm"#e"                  \n\t"\
+    SHA1_ROUNDS(f, e, eo)                                       \
+    SHA1_MSG(cur, next, prev, prev2)
+
+static void sha1_transform_sha(uint32_t *state, const uint8_t buffer[64])
+{
+    __asm__ volatile (
+        "movdqu        (%[state]), %%xmm0                  \n\t"
+        "pshufd        $0x1B, %%xmm0, %%xmm0               \n\t"
+        "movd          16(%[state]), %%xmm1                \n\t"
+        "pslldq        $12, %%xmm1                         \n\t"
+
+        LOAD_MSG(0, 3, mask1)
+        "paddd         %%xmm3, %%xmm1                      \n\t"
+        SHA1_ROUNDS(0, 1, 2)
+        LOAD_MSG(1, 4, mask1)
+        "sha1nexte     %%xmm4, %%xmm2                      \n\t"
+        SHA1_ROUNDS(0, 2, 1)
+        "sha1msg1      %%xmm4, %%xmm3                      \n\t"
+        LOAD_MSG(2, 5, mask1)
+        "sha1nexte     %%xmm5, %%xmm1                      \n\t"
+        SHA1_ROUNDS(0, 1, 2)
+        "sha1msg1      %%xmm5, %%xmm4                      \n\t"
+        "pxor          %%xmm5, %%xmm3                      \n\t"
+        LOAD_MSG(3, 6, mask1)
+        "sha1nexte     %%xmm6, %%xmm2                      \n\t"
+        SHA1_ROUNDS(0, 2, 1)
+        SHA1_MSG(6, 3, 5, 4)
+
+        SHA1_QROUND(0, 1, 2, 3, 4, 6, 5)
+        SHA1_QROUND(1, 2, 1, 4, 5, 3, 6)
+        SHA1_QROUND(1, 1, 2, 5, 6, 4, 3)
+        SHA1_QROUND(1, 2, 1, 6, 3, 5, 4)
+        SHA1_QROUND(1, 1, 2, 3, 4, 6, 5)
+        SHA1_QROUND(1, 2, 1, 4, 5, 3, 6)
+        SHA1_QROUND(2, 1, 2, 5, 6, 4, 3)
+        SHA1_QROUND(2, 2, 1, 6, 3, 5, 4)
+        SHA1_QROUND(2, 1, 2, 3, 4, 6, 5)
+        SHA1_QROUND(2, 2, 1, 4, 5, 3, 6)
+        SHA1_QROUND(2, 1, 2, 5, 6, 4, 3)
+        SHA1_QROUND(3, 2, 1, 6, 3, 5, 4)
+        SHA1_QROUND(3, 1, 2, 3, 4, 6, 5)
+
+        "sha1nexte     %%xmm4, %%xmm2                      \n\t"
+        SHA1_ROUNDS(3, 2, 1)
+        "sha1msg2      %%xmm4, %%xmm5                      \n\t"
+        "pxor          %%xmm4, %%xmm6                      \n\t"
+        "sha1nexte     %%xmm5, %%xmm1                      \n\t"
+        SHA1_ROUNDS(3, 1, 2)
+        "sha1msg2      %%xmm5, %%xmm6                      \n\t"
+        "sha1nexte     %%xmm6, %%xmm2                      \n\t"
+        SHA1_ROUNDS(3, 2, 1)
+
+        "movd          16(%[state]), %%xmm7                \n\t"
+        "pslldq        $12, %%xmm7                         \n\t"
+        "sha1nexte     %%xmm7, %%xmm1                      \n\t"
+        "movdqu        (%[state]), %%xmm7                  \n\t"
+        "pshufd        $0x1B, %%xmm7, %%xmm7               \n\t"
+        "paddd         %%xmm7, %%xmm0                      \n\t"
+        "pshufd        $0x1B, %%xmm0, %%xmm0               \n\t"
+        "movdqu        %%xmm0, (%[state])                  \n\t"
+        "pshufd        $3, %%xmm1, %%xmm1                  \n\t"
+        "movd          %%xmm1, 16(%[state])                \n\t"
+        :
+        : [state]"r"(state), [data]"r"(buffer), [mask1]"m"(*sha1_bswap_mask)
+        : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                       "%xmm4", "%xmm5", "%xmm6", "%xmm7",)
+          "memory"
+    );
+}
+
+/* SHA-256 keeps ABEF in xmm1 and CDGH in xmm2, xmm0 holds W + K. */
+#define SHA256_ROUNDS(i, m)                                     \
+    "movdqa        %%xmm"#m", %%xmm0                       \n\t"\
+    "paddd         16*"#i"(%[k]), %%xmm0                   \n\t"\
+    "sha256rnds2   %%xmm0, %%xmm1, %%xmm2                  \n\t"\
+    "pshufd        $0x0E, %%xmm0, %%xmm0                   \n\t"\
+    "sha256rnds2   %%xmm0, %%xmm2, %%xmm1                  \n\t"
+
+#define SHA256_MSG2(cur, prev, next)                            \
+    "movdqa        %%xmm"#cur", %%xmm7                     \n\t"\
+    "palignr       $4, %%xmm"#prev", %%xmm7                \n\t"\
+    "paddd         %%xmm7, %%xmm"#next"                    \n\t"\
+    "sha256msg2    %%xmm"#cur", %%xmm"#next"               \n\t"
+
+#define SHA256_MSG1(cur, prev)                                  \
+    "sha256msg1    %%xmm"#cur", %%xmm"#prev"               \n\t"
+
+/* rounds 16 to 51, four at a time */
+#define SHA256_QROUND(i, cur, prev, next)                       \
+    SHA256_ROUNDS(i, cur)                                       \
+    SHA256_MSG2(cur, prev, next)                                \
+    SHA256_MSG1(cur, prev)
+
+static void sha256_transform_sha(uint32_t *state, const uint8_t buffer[64])
+{
+    __asm__ volatile (
+        "movdqu        (%[state]), %%xmm7                  \n\t"
+        "movdqu        16(%[state]), %%xmm2                \n\t"
+        "pshufd        $0xB1, %%xmm7, %%xmm7               \n\t"
+        "pshufd        $0x1B, %%xmm2, %%xmm2               \n\t"
+        "movdqa        %%xmm7, %%xmm1                      \n\t"
+        "palignr       $8, %%xmm2, %%xmm1                  \n\t"
+        "pblendw       $0xF0, %%xmm7, %%xmm2               \n\t"
+
+        LOAD_MSG(0, 3, mask256)
+        SHA256_ROUNDS(0, 3)
+        LOAD_MSG(1, 4, mask256)
+        SHA256_ROUNDS(1, 4)
+        SHA256_MSG1(4, 3)
+        LOAD_MSG(2, 5, mask256)
+        SHA256_ROUNDS(2, 5)
+        SHA256_MSG1(5, 4)
+        LOAD_MSG(3, 6, mask256)
+        SHA256_QROUND( 3, 6, 5, 3)
+
+        SHA256_QROUND( 4, 3, 6, 4)
+        SHA256_QROUND( 5, 4, 3, 5)
+        SHA256_QROUND( 6, 5, 4, 6)
+        SHA256_QROUND( 7, 6, 5, 3)
+        SHA256_QROUND( 8, 3, 6, 4)
+        SHA256_QROUND( 9, 4, 3, 5)
+        SHA256_QROUND(10, 5, 4, 6)
+        SHA256_QROUND(11, 6, 5, 3)
+        SHA256_QROUND(12, 3, 6, 4)
+
+        SHA256_ROUNDS(13, 4)
+        SHA256_MSG2(4, 3, 5)
+        SHA256_ROUNDS(14, 5)
+        SHA256_MSG2(5, 4, 6)
+        SHA256_ROUNDS(15, 6)
+
+        "pshufd        $0x1B, %%xmm1, %%xmm7               \n\t"
+        "pshufd        $0xB1, %%xmm2, %%xmm2               \n\t"
+        "movdqa        %%xmm7, %%xmm1                      \n\t"
+        "pblendw       $0xF0, %%xmm2, %%xmm1               \n\t"
+        "palignr       $8, %%xmm7, %%xmm2                  \n\t"
+        "movdqu        (%[state]), %%xmm0                  \n\t"
+        "paddd         %%xmm0, %%xmm1                      \n\t"
+        "movdqu        16(%[state]), %%xmm0                \n\t"
+        "paddd         %%xmm0, %%xmm2                      \n\t"
+        "movdqu        %%xmm1, (%[state])                  \n\t"
+        "movdqu        %%xmm2, 16(%[state])                \n\t"
+        :
+        : [state]"r"(state), [data]"r"(buffer), [k]"r"(sha256_k),
+          [mask256]"m"(*sha256_bswap_mask)
+        : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                       "%xmm4", "%xmm5", "%xmm6", "%xmm7",)
+          "memory"
+    );
+}
+
+#endif /* HAVE_SHA_INLINE */
+
+av_cold void ff_sha_init_x86(void (**transform)(uint32_t *state, const uint8_t buffer[64]),
+                             int bits)
+{
+#if HAVE_SHA_INLINE
+    int cpu_flags = av_get_cpu_flags();
+
+    if (INLINE_SHA(cpu_flags))
+        *transform = bits == 160 ? sha1_transform_sha : sha256_transform_sha;
+#endif /* HAVE_SHA_INLINE */
+}
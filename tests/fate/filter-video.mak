@@ -88,6 +88,12 @@ $(foreach MODE,$(FPMODES),$(eval $(call FATE_FPFILTER_SUITE,$(MODE))))
 FATE_FILTER_VSYNTH-$(CONFIG_FRAMEPACK_FILTER) += $(FATE_FILTER_FRAMEPACK)
 fate-filter-framepack: $(FATE_FILTER_FRAMEPACK)
 
+FATE_FILTER_VSYNTH-$(CONFIG_GEQ_FILTER) += fate-filter-geq
+fate-filter-geq: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf "geq=lum=p(W-1-X\,Y):cb=cb(X\,H-1-Y):cr=128+sin(X/8)*cr(X\,Y)/4"
+
+FATE_FILTER_VSYNTH-$(CONFIG_GEQ_FILTER) += fate-filter-geq-state
+fate-filter-geq-state: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf "geq=lum=lum(X\,Y)/2+random(0)*128:cb=st(0\,ld(0)*0.9+cb(X\,Y)*0.1):cr=128"
+
 FATE_FILTER_VSYNTH-$(CONFIG_GRADFUN_FILTER) += fate-filter-gradfun
 fate-filter-gradfun: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf gradfun
 
@@ -430,8 +436,25 @@ FATE_METADATA_FILTER-$(call ALLYES, $(EBUR128_METADATA_DEPS)) += fate-filter-met
 fate-filter-metadata-ebur128: SRC = $(TARGET_SAMPLES)/filter/seq-3341-7_seq-3342-5-24bit.flac
 fate-filter-metadata-ebur128: CMD = run $(FILTER_METADATA_COMMAND) "amovie='$(SRC)',ebur128=metadata=1"
 
+SIGNALSTATS_METADATA_DEPS = FFPROBE LAVFI_INDEV TESTSRC_FILTER FORMAT_FILTER SCALE_FILTER SIGNALSTATS_FILTER
+FATE_METADATA_FILTER_LAVFI-$(call ALLYES, $(SIGNALSTATS_METADATA_DEPS)) += fate-filter-metadata-signalstats
+fate-filter-metadata-signalstats: CMD = run $(FILTER_METADATA_COMMAND) "sws_flags=+accurate_rnd+bitexact;testsrc=s=352x288:d=0.2,format=yuv420p,signalstats=stat=tout+vrep+brng"
+
+FATE_METADATA_FILTER_LAVFI-$(call ALLYES, $(SIGNALSTATS_METADATA_DEPS)) += fate-filter-metadata-signalstats-sampled
+fate-filter-metadata-signalstats-sampled: CMD = run $(FILTER_METADATA_COMMAND) "sws_flags=+accurate_rnd+bitexact;testsrc=s=352x288:d=0.2,format=yuv422p,signalstats=xstep=3:ystep=2:interval=2"
+
+CROPDETECT_METADATA_DEPS = FFPROBE LAVFI_INDEV TESTSRC_FILTER FORMAT_FILTER SCALE_FILTER PAD_FILTER CROPDETECT_FILTER
+FATE_METADATA_FILTER_LAVFI-$(call ALLYES, $(CROPDETECT_METADATA_DEPS)) += fate-filter-metadata-cropdetect-sampled
+fate-filter-metadata-cropdetect-sampled: CMD = run $(FILTER_METADATA_COMMAND) "sws_flags=+accurate_rnd+bitexact;testsrc=s=320x240:d=0.4,format=yuv420p,pad=352:288:16:22,cropdetect=round=2:step=3:interval=3"
+
+SSIM_METADATA_DEPS = FFPROBE LAVFI_INDEV TESTSRC_FILTER FORMAT_FILTER SCALE_FILTER SPLIT_FILTER \
+                     LUTYUV_FILTER BOXBLUR_FILTER SSIM_FILTER
+FATE_METADATA_FILTER_LAVFI-$(call ALLYES, $(SSIM_METADATA_DEPS)) += fate-filter-metadata-ssim
+fate-filter-metadata-ssim: CMD = run $(FILTER_METADATA_COMMAND) "sws_flags=+accurate_rnd+bitexact;testsrc=s=352x288:d=0.4,format=yuv420p,split[a][b];[b]lutyuv=y=val*0.9+16:u=val*0.9+12,boxblur=2:1[c];[a][c]ssim"
+
 FATE_SAMPLES_FFPROBE += $(FATE_METADATA_FILTER-yes)
+FATE_FFPROBE += $(FATE_METADATA_FILTER_LAVFI-yes)
 
 fate-vfilter: $(FATE_FILTER-yes) $(FATE_FILTER_VSYNTH-yes)
 
-fate-filter: fate-afilter fate-vfilter $(FATE_METADATA_FILTER-yes)
+fate-filter: fate-afilter fate-vfilter $(FATE_METADATA_FILTER-yes) $(FATE_METADATA_FILTER_LAVFI-yes)
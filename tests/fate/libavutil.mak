@@ -75,6 +75,10 @@ FATE_LIBAVUTIL += fate-hmac
 fate-hmac: libavutil/hmac-test$(EXESUF)
 fate-hmac: CMD = run libavutil/hmac-test
 
+FATE_LIBAVUTIL += fate-imgutils
+fate-imgutils: libavutil/imgutils-test$(EXESUF)
+fate-imgutils: CMD = run libavutil/imgutils-test
+
 FATE_LIBAVUTIL += fate-md5
 fate-md5: libavutil/md5-test$(EXESUF)
 fate-md5: CMD = run libavutil/md5-test
@@ -117,6 +121,10 @@ fate-twofish: libavutil/twofish-test$(EXESUF)
 fate-twofish: CMD = run libavutil/twofish-test
 fate-twofish: REF = /dev/null
 
+FATE_LIBAVUTIL-$(HAVE_THREADS) += fate-threadmessage
+fate-threadmessage: libavutil/threadmessage-test$(EXESUF)
+fate-threadmessage: CMD = run libavutil/threadmessage-test
+
 FATE_LIBAVUTIL += fate-xtea
 fate-xtea: libavutil/xtea-test$(EXESUF)
 fate-xtea: CMD = run libavutil/xtea-test
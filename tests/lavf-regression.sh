@@ -213,6 +213,7 @@ if [ -n "$do_png" ] ; then
 do_image_formats png
 do_image_formats png "-pix_fmt gray16be"
 do_image_formats png "-pix_fmt rgb48be"
+do_image_formats png "-slices 4 -threads 2 -thread_type slice"
 fi
 
 if [ -n "$do_xbm" ] ; then